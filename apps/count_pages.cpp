@@ -1,6 +1,7 @@
 #include <cas/key.hpp>
 #include <cas/key_decoder.hpp>
 #include <cas/memory_page.hpp>
+#include <cas/partition_header.hpp>
 #include <cas/swh_pid.hpp>
 #include <cas/types.hpp>
 #include <cstdio>
@@ -19,22 +20,27 @@ int main_(int argc, char** argv) {
   std::string input_filename = std::string{argv[1]};
   long nr_target_keys = atol(argv[2]);
 
-  // create page as buffer
-  std::vector<std::byte> buffer{cas::PAGE_SZ, std::byte{0}};
-  cas::MemoryPage page{&buffer[0]};
+  // create page as buffer, the page size is recorded in the header
+  auto header = cas::PartitionHeader::Read(input_filename);
+  size_t page_size = header.page_size_;
+  std::vector<std::byte> buffer{page_size, std::byte{0}};
+  cas::MemoryPage page{&buffer[0], page_size};
 
   // open correct input file
   std::FILE* infile = fopen(input_filename.c_str(), "rb");
   if (infile == nullptr) {
     throw std::runtime_error{"file cannot be opened: " + input_filename};
   }
+  if (std::fseek(infile, header.ByteSize(), SEEK_SET) != 0) {
+    throw std::runtime_error{"cannot skip the header of: " + input_filename};
+  }
 
   // process input
   size_t nr_keys = 0;
   size_t nr_pages = 0;
   while (nr_keys < nr_target_keys) {
-    size_t bytes_read = fread(page.Data(), 1, cas::PAGE_SZ, infile);
-    if (bytes_read < cas::PAGE_SZ) {
+    size_t bytes_read = fread(page.Data(), 1, page_size, infile);
+    if (bytes_read < page_size) {
       break;
     }
     for (const auto& bkey : page) {
@@ -47,7 +53,8 @@ int main_(int argc, char** argv) {
 
   std::cout << "nr_keys:  " << nr_keys << "\n";
   std::cout << "nr_pages: " << nr_pages << "\n";
-  std::cout << "input_size: " << (nr_pages * cas::PAGE_SZ) << "\n";
+  std::cout << "page_size: " << page_size << "\n";
+  std::cout << "input_size: " << (nr_pages * page_size) << "\n";
 
   return 0;
 }
@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <cas/common_prefix.hpp>
 #include <cas/key.hpp>
 #include <cas/key_encoder.hpp>
 #include <cas/memory_page.hpp>
+#include <cas/partition_header.hpp>
 #include <cas/swh_pid.hpp>
 #include <cas/types.hpp>
 #include <cstdio>
@@ -42,10 +45,10 @@ cas::Key<cas::vint64_t> ParseInputLine(
 }
 
 
-void Csv2Partition() {
+void Csv2Partition(size_t page_size) {
   // create page as buffer
-  std::vector<std::byte> buffer{cas::PAGE_SZ, std::byte{0}};
-  cas::MemoryPage page{&buffer[0]};
+  std::vector<std::byte> buffer{page_size, std::byte{0}};
+  cas::MemoryPage page{&buffer[0], page_size};
   std::array<std::byte, cas::PAGE_SZ> key_buffer;
   cas::BinaryKey bkey(key_buffer.data());
   std::array<std::byte, cas::PAGE_SZ> ref_key_buffer;
@@ -57,6 +60,16 @@ void Csv2Partition() {
   // - key len_path:  2B
   // - key len_value: 2B
   const size_t key_header_size = 32;
+  // the same keys are written for every page size
+  const size_t max_key_size = std::min(page_size, cas::PAGE_SZ);
+
+  // the header records the page size (see PartitionHeader)
+  cas::PartitionHeader header;
+  header.page_size_ = page_size;
+  header.present_ = true;
+  header.Write(page.Data());
+  std::fwrite(page.Data(), 1, page_size, stdout);
+  page.Reset();
 
   size_t nr_keys  = 0;
   size_t nr_pages = 0;
@@ -76,9 +89,9 @@ void Csv2Partition() {
       continue;
     }
 
-    // skip keys that are close to PAGE_SZ long
+    // skip keys that are close to a page (at most PAGE_SZ) long
     // this makes sure that every key fits into a page
-    if (key.Size() + key_header_size > cas::PAGE_SZ) {
+    if (key.Size() + key_header_size > max_key_size) {
       continue;
     }
 
@@ -89,9 +102,9 @@ void Csv2Partition() {
     }
 
     cas::KeyEncoder<cas::vint64_t>::Encode(key, bkey);
-    if (bkey.ByteSize() > page.FreeSpace()) {
+    if (!page.Fits(bkey)) {
       // write page to stdout since it is full
-      std::fwrite(page.Data(), 1, cas::PAGE_SZ, stdout);
+      std::fwrite(page.Data(), 1, page_size, stdout);
       page.Reset();
       ++nr_pages;
     }
@@ -104,14 +117,8 @@ void Csv2Partition() {
       dsc_P = ref_bkey.LenPath();
       dsc_V = ref_bkey.LenValue();
     } else {
-      size_t g_P = 0;
-      size_t g_V = 0;
-      while (g_P < dsc_P && bkey.Path()[g_P] == ref_bkey.Path()[g_P]) {
-        ++g_P;
-      }
-      while (g_V < dsc_V && bkey.Value()[g_V] == ref_bkey.Value()[g_V]) {
-        ++g_V;
-      }
+      size_t g_P = cas::CommonPrefix(bkey.Path(), ref_bkey.Path(), dsc_P);
+      size_t g_V = cas::CommonPrefix(bkey.Value(), ref_bkey.Value(), dsc_V);
       dsc_P = g_P;
       dsc_V = g_V;
       if (g_P == 0) {
@@ -123,7 +130,7 @@ void Csv2Partition() {
   }
 
   // flush last page to stdout
-  std::fwrite(page.Data(), 1, cas::PAGE_SZ, stdout);
+  std::fwrite(page.Data(), 1, page_size, stdout);
   ++nr_pages;
 
   // write statistics to stderr
@@ -140,12 +147,17 @@ int main_(int argc, char** argv) {
 
   std::string input_filename = "";
   bool read_from_file = false;
+  size_t page_size = cas::PAGE_SZ;
 
-  // check if input is coming from stdin or file
-  if (argc >= 2) {
+  // check if input is coming from stdin ("-") or file
+  if (argc >= 2 && std::string{argv[1]} != "-") {
     read_from_file = true;
     input_filename = std::string{argv[1]};
   }
+  if (argc >= 3) {
+    page_size = std::stoul(argv[2]);
+    cas::CheckPageSize(page_size);
+  }
 
   std::ifstream infile(input_filename);
   if (read_from_file) {
@@ -161,7 +173,7 @@ int main_(int argc, char** argv) {
     return 1;
   }
 
-  Csv2Partition();
+  Csv2Partition(page_size);
   if (infile.is_open()) {
     infile.close();
   }
@@ -1,6 +1,7 @@
 #include <cas/key.hpp>
 #include <cas/key_decoder.hpp>
 #include <cas/memory_page.hpp>
+#include <cas/partition_header.hpp>
 #include <cas/swh_pid.hpp>
 #include <cas/types.hpp>
 #include <cstdio>
@@ -19,9 +20,6 @@ int main_(int argc, char** argv) {
     input_filename = std::string{argv[1]};
   }
 
-  // create page as buffer
-  std::vector<std::byte> buffer{cas::PAGE_SZ, std::byte{0}};
-  cas::MemoryPage page{&buffer[0]};
   // buffer to store path&values
   cas::QueryBuffer buf_path;
   cas::QueryBuffer buf_value;
@@ -38,12 +36,32 @@ int main_(int argc, char** argv) {
     return 1;
   }
 
-  // process input
+  // the page size is recorded in the header, if any
+  std::byte first_bytes[cas::PartitionHeader::SZ];
+  size_t nr_read = fread(first_bytes, 1, sizeof(first_bytes), infile);
+  auto header = cas::PartitionHeader::Read(first_bytes, nr_read);
+  size_t page_size = header.page_size_;
+
+  // create page as buffer
+  std::vector<std::byte> buffer{page_size, std::byte{0}};
+  cas::MemoryPage page{&buffer[0], page_size};
+  if (header.present_) {
+    // skip the rest of the header page
+    fread(page.Data(), 1, page_size - nr_read, infile);
+    nr_read = 0;
+  } else {
+    std::memcpy(page.Data(), first_bytes, nr_read);
+  }
+
+  // process input, the first nr_read bytes of the first page have
+  // already been read
   while (true) {
-    size_t bytes_read = fread(page.Data(), 1, cas::PAGE_SZ, infile);
-    if (bytes_read < cas::PAGE_SZ) {
+    size_t bytes_read = fread(page.Data() + nr_read, 1,
+        page_size - nr_read, infile);
+    if (bytes_read < page_size - nr_read) {
       break;
     }
+    nr_read = 0;
     for (const auto& bkey : page) {
       std::memcpy(buf_path.data(), bkey.Path(), bkey.LenPath());
       std::memcpy(buf_value.data(), bkey.Value(), bkey.LenValue());
@@ -59,7 +59,7 @@ private:
     skey.Dump();
     bool reverse_paths = false;
     auto bkey = cas::KeyEncoder<cas::vint64_t>::Encode(skey, reverse_paths);
-    auto stats = index_.Query(bkey, cas::kNullEmitter);
+    auto stats = index_.Count(bkey);
 
     std::cout << "\n";
     stats.Dump();
@@ -70,7 +70,7 @@ private:
   void ExecuteConcise(const cas::SearchKey<VType>& skey) {
     bool reverse_paths = false;
     auto bkey = cas::KeyEncoder<cas::vint64_t>::Encode(skey, reverse_paths);
-    auto stats = index_.Query(bkey, cas::kNullEmitter);
+    auto stats = index_.Count(bkey);
 
     std::printf("%zu;", stats.nr_matches_);
     std::cout << std::flush;
@@ -31,6 +31,10 @@ void VaryMemorySize(cas::Context context) {
     cas::MemoryPlacement::FrontLoading,
   };
 
+  std::vector<cas::PageFormat> page_formats = {
+    context.page_format_,
+  };
+
   std::vector<size_t> memory_sizes = {
      16'000'000'000,
      32'000'000'000,
@@ -39,7 +43,11 @@ void VaryMemorySize(cas::Context context) {
     256'000'000'000,
   };
 
-  Exp bm{context, approaches, memory_sizes};
+  std::vector<size_t> write_behind_pages = {
+    context.write_behind_pages_,
+  };
+
+  Exp bm{context, approaches, page_formats, memory_sizes, write_behind_pages};
   bm.Execute();
 }
 
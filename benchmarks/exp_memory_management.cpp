@@ -16,6 +16,12 @@ int main_(int argc, char** argv) {
     cas::MemoryPlacement::AllOrNothing,
   };
 
+  // front-coded pages hold more keys and reduce the partition I/O
+  std::vector<cas::PageFormat> page_formats = {
+    cas::PageFormat::Plain,
+    cas::PageFormat::FrontCoded,
+  };
+
   std::vector<size_t> memory_sizes = {
      16'000'000'000, //  200M keys
      32'000'000'000, //  400M keys
@@ -24,7 +30,14 @@ int main_(int argc, char** argv) {
     256'000'000'000, // 3200M keys
   };
 
-  Exp bm{context, approaches, memory_sizes};
+  // buffering partition writes coalesces them into fewer, larger writes
+  std::vector<size_t> write_behind_pages = {
+      0,
+     64,
+    256,
+  };
+
+  Exp bm{context, approaches, page_formats, memory_sizes, write_behind_pages};
   bm.Execute();
 
   return 0;
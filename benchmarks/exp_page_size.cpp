@@ -0,0 +1,37 @@
+#include "benchmark/exp_page_size.hpp"
+#include "benchmark/option_parser.hpp"
+
+int main_(int argc, char** argv) {
+  using VType = cas::vint64_t;
+  using Exp = benchmark::ExpPageSize<VType>;
+
+  // the input for every page size is created with
+  //   csv2partition <dataset.csv> <page_size> > <input_filename>.<page_size>
+  cas::Context context;
+  benchmark::option_parser::Parse(argc, argv, context);
+
+  std::vector<size_t> page_sizes = {
+    cas::PAGE_SZ_4KB,
+    cas::PAGE_SZ_16KB,
+    cas::PAGE_SZ_64KB,
+    cas::PAGE_SZ_256KB,
+    cas::PAGE_SZ_1MB,
+  };
+
+  Exp bm{context, page_sizes};
+  bm.Execute();
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  try {
+    return main_(argc, argv);
+  } catch (std::exception& e) {
+    std::cerr << "Standard exception. What: " << e.what() << std::endl;
+    return 10;
+  } catch (...) {
+    std::cerr << "Unknown exception." << std::endl;
+    return 11;
+  }
+}
@@ -0,0 +1,37 @@
+#include "benchmark/exp_parallel_construction.hpp"
+#include "benchmark/option_parser.hpp"
+
+int main_(int argc, char** argv) {
+  using VType = cas::vint64_t;
+  using Exp = benchmark::ExpParallelConstruction<VType>;
+
+  cas::Context context;
+  benchmark::option_parser::Parse(argc, argv, context);
+
+  std::vector<size_t> thread_counts = {
+     1,
+     2,
+     4,
+     8,
+    16,
+    32,
+    64,
+  };
+
+  Exp bm{context, thread_counts};
+  bm.Execute();
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  try {
+    return main_(argc, argv);
+  } catch (std::exception& e) {
+    std::cerr << "Standard exception. What: " << e.what() << std::endl;
+    return 10;
+  } catch (...) {
+    std::cerr << "Unknown exception." << std::endl;
+    return 11;
+  }
+}
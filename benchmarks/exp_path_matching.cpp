@@ -0,0 +1,136 @@
+#include "cas/key_encoder.hpp"
+#include "cas/path_matcher.hpp"
+#include "cas/search_key.hpp"
+#include "cas/util.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Compares the backtracking path_matcher with the compiled PathAutomaton
+// on patterns whose wildcards must absorb long substrings of the paths.
+
+
+std::vector<std::string> GeneratePaths(size_t nr_paths) {
+  std::mt19937 rng{42};
+  std::vector<std::string> segments = {
+    "Documentation", "arm", "arch", "a", "aa", "aaa", "aaaa", "drivers",
+    "include", "ab", "aab", "arm64", "ar", "x"};
+  std::vector<std::string> paths;
+  paths.reserve(nr_paths);
+  for (size_t i = 0; i < nr_paths; ++i) {
+    std::string path = "/Documentation";
+    size_t depth = 4 + rng() % 12;
+    for (size_t d = 0; d < depth; ++d) {
+      path += "/" + segments[rng() % segments.size()];
+    }
+    path += "/" + std::string(4 + rng() % 24, 'a') + (rng() % 2 ? ".txt" : ".tx");
+    paths.push_back(path);
+  }
+  return paths;
+}
+
+
+void Benchmark(const std::string& pattern,
+    const std::vector<cas::QueryBuffer>& paths,
+    const std::vector<size_t>& lengths,
+    int nr_repetitions) {
+  using Clock = std::chrono::high_resolution_clock;
+  cas::SearchKey<cas::vint64_t> skey{pattern, 0, 0};
+  auto t_compile = Clock::now();
+  cas::BinarySK key = cas::KeyEncoder<cas::vint64_t>::Encode(skey);
+  double compile_mus = std::chrono::duration<double, std::micro>(
+      Clock::now() - t_compile).count();
+
+  size_t matches_backtracking = 0;
+  size_t matches_automaton = 0;
+  auto t_start = Clock::now();
+  for (int r = 0; r < nr_repetitions; ++r) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      matches_backtracking += cas::path_matcher::MatchPath(
+          paths[i], key.path_, lengths[i]);
+    }
+  }
+  auto t_mid = Clock::now();
+  for (int r = 0; r < nr_repetitions; ++r) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      matches_automaton += cas::path_matcher::MatchPath(
+          paths[i], key, lengths[i]);
+    }
+  }
+  auto t_end = Clock::now();
+  if (matches_backtracking != matches_automaton) {
+    throw std::runtime_error{"matchers disagree on pattern " + pattern};
+  }
+
+  double nr_matches = static_cast<double>(paths.size()) * nr_repetitions;
+  double ns_backtracking = std::chrono::duration<double, std::nano>(
+      t_mid - t_start).count() / nr_matches;
+  double ns_automaton = std::chrono::duration<double, std::nano>(
+      t_end - t_mid).count() / nr_matches;
+  std::cout << std::fixed << pattern << ";"
+    << (key.automaton_ ? key.automaton_->NrStates() : 0) << ";"
+    << compile_mus << ";"
+    << (matches_automaton / nr_repetitions) << ";"
+    << ns_backtracking << ";"
+    << ns_automaton << "\n";
+}
+
+
+int main_(int argc, char** argv) {
+  // every path needs its own QueryBuffer
+  size_t nr_paths = 2'000;
+  int nr_repetitions = 50;
+  if (argc > 1) {
+    nr_paths = std::stoul(argv[1]);
+  }
+  if (argc > 2) {
+    nr_repetitions = std::stoi(argv[2]);
+  }
+
+  std::vector<std::string> patterns = {
+    "/Documentation/**/arm/**/*.txt",
+    "/Documentation/**/arm/**/x/**/*.txt",
+    "/**/a*a*a*a*a*b",
+    "/**/*a*a*a*.txt",
+    "/**/arm/*/*/*/*.txt",
+    "/Documentation/**/aab/**",
+    "/**/drivers/**/include/**/a*.tx",
+  };
+
+  cas::util::Log("Generating " + std::to_string(nr_paths) + " paths\n");
+  std::vector<std::string> paths = GeneratePaths(nr_paths);
+  std::vector<cas::QueryBuffer> buffers(paths.size());
+  std::vector<size_t> lengths(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    cas::Key<cas::vint64_t> key{paths[i], 0, cas::ref_t{}};
+    cas::BinaryKey bkey{&buffers[i][0]};
+    cas::KeyEncoder<cas::vint64_t>::Encode(key, bkey);
+    lengths[i] = bkey.LenPath();
+    // BinaryKey keeps the path after its header, MatchPath expects
+    // it at the beginning of the buffer
+    std::memmove(&buffers[i][0], bkey.Path(), lengths[i]);
+  }
+
+  std::cout << "nr_paths: " << nr_paths << "\n";
+  std::cout << "nr_repetitions: " << nr_repetitions << "\n\n";
+  std::cout << "pattern;nr_states;compile_mus;nr_matches;backtracking_ns;automaton_ns\n";
+  for (const auto& pattern : patterns) {
+    Benchmark(pattern, buffers, lengths, nr_repetitions);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  try {
+    return main_(argc, argv);
+  } catch (std::exception& e) {
+    std::cerr << "Standard exception. What: " << e.what() << std::endl;
+    return 10;
+  } catch (...) {
+    std::cerr << "Unknown exception." << std::endl;
+    return 11;
+  }
+}
@@ -0,0 +1,121 @@
+#include "benchmark/exp_query_throughput.hpp"
+#include "cas/search_key.hpp"
+#include "cas/util.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <getopt.h>
+
+
+int main_(int argc, char** argv) {
+  using VType = cas::vint64_t;
+  using Exp = benchmark::ExpQueryThroughput<VType>;
+
+  const int OPT_PIPELINE_DIR = 1;
+  const int OPT_QUERY_DIR = 2;
+  const int OPT_QUERY_FILE = 3;
+  const int OPT_NR_WORKERS = 4;
+  const int OPT_NR_REPETITIONS = 5;
+  static struct option long_options[] = {
+    {"pipeline_dir",   required_argument, nullptr, OPT_PIPELINE_DIR},
+    {"query_dir",      required_argument, nullptr, OPT_QUERY_DIR},
+    {"query_file",     required_argument, nullptr, OPT_QUERY_FILE},
+    {"nr_workers",     required_argument, nullptr, OPT_NR_WORKERS},
+    {"nr_repetitions", required_argument, nullptr, OPT_NR_REPETITIONS},
+    {0, 0, 0, 0}
+  };
+
+  std::string pipeline_dir;
+  std::string query_dir = "queries/";
+  std::string query_file;
+  size_t nr_workers = std::max(1u, std::thread::hardware_concurrency());
+  int nr_repetitions = 1;
+  while (true) {
+    int option_index;
+    int c = getopt_long(argc, argv, "", long_options, &option_index);
+    if (c == -1) {
+      break;
+    }
+    std::string optvalue{optarg};
+    switch (c) {
+      case OPT_PIPELINE_DIR:
+        pipeline_dir = optvalue;
+        break;
+      case OPT_QUERY_DIR:
+        query_dir = optvalue;
+        break;
+      case OPT_QUERY_FILE:
+        query_file = optvalue;
+        break;
+      case OPT_NR_WORKERS:
+        if (sscanf(optarg, "%zu", &nr_workers) != 1) {
+          std::cerr << "Could not parse option --nr_workers (integer expected)\n";
+          return 1;
+        }
+        break;
+      case OPT_NR_REPETITIONS:
+        if (sscanf(optarg, "%d", &nr_repetitions) != 1 || nr_repetitions < 1) {
+          std::cerr << "Could not parse option --nr_repetitions (positive integer expected)\n";
+          return 1;
+        }
+        break;
+    }
+  }
+
+  if (!std::filesystem::exists(pipeline_dir)) {
+    std::cerr << "specify valid pipeline_dir with --pipeline_dir\n";
+    return 1;
+  }
+
+  // replay a single query file or all query files of query_dir
+  std::vector<std::string> query_files;
+  if (!query_file.empty()) {
+    query_files.push_back(query_file);
+  } else if (std::filesystem::is_directory(query_dir)) {
+    for (const auto& entry : std::filesystem::directory_iterator(query_dir)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+        query_files.push_back(entry.path().string());
+      }
+    }
+    std::sort(query_files.begin(), query_files.end());
+  }
+  std::vector<cas::SearchKey<VType>> queries;
+  for (const auto& filename : query_files) {
+    std::cout << "query_file: " << filename << "\n";
+    auto file_queries = cas::util::ParseQueryFile(filename, ';');
+    queries.insert(queries.end(), file_queries.begin(), file_queries.end());
+  }
+  if (queries.empty()) {
+    std::cerr << "specify valid queries with --query_dir or --query_file\n";
+    return 1;
+  }
+
+  // nr_workers = 0 executes the queries on the client threads
+  std::vector<size_t> client_counts = {
+     1,
+     2,
+     4,
+     8,
+    16,
+    32,
+    64,
+  };
+
+  Exp bm{pipeline_dir, queries, client_counts, nr_workers, nr_repetitions};
+  bm.Execute();
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  try {
+    return main_(argc, argv);
+  } catch (std::exception& e) {
+    std::cerr << "Standard exception. What: " << e.what() << std::endl;
+    return 10;
+  } catch (...) {
+    std::cerr << "Unknown exception." << std::endl;
+    return 11;
+  }
+}
@@ -16,7 +16,13 @@ void ExecuteExperiment(
       const std::string& query_file,
       bool clear_page_cache,
       bool do_warmup,
-      int nr_repetitions)
+      int nr_repetitions,
+      size_t nr_query_threads,
+      size_t parallel_fanout,
+      bool compare_node_formats,
+      size_t limit,
+      cas::QueryOrder order,
+      size_t batch_size)
 {
   using VType = cas::vint64_t;
   using Exp = benchmark::ExpQuerying<VType>;
@@ -26,12 +32,20 @@ void ExecuteExperiment(
   std::cout << "query_file: " << query_file << "\n";
   std::cout << "clear_page_cache: " << clear_page_cache << "\n";
   std::cout << "do_warmup: " << do_warmup << "\n";
+  std::cout << "query_threads: " << nr_query_threads << "\n";
+  std::cout << "parallel_fanout: " << parallel_fanout << "\n";
+  std::cout << "compare_node_formats: " << compare_node_formats << "\n";
+  std::cout << "limit: " << limit << "\n";
+  std::cout << "order: " << cas::ToString(order) << "\n";
+  std::cout << "batch_size: " << batch_size << "\n";
 
   // parse queries
   auto queries = cas::util::ParseQueryFile(query_file, ',');
 
   // execute experiment
-  Exp bm{pipeline_dir, queries, clear_page_cache, do_warmup, nr_repetitions};
+  Exp bm{pipeline_dir, queries, clear_page_cache, do_warmup, nr_repetitions,
+    nr_query_threads, parallel_fanout, compare_node_formats, limit, order,
+    batch_size};
   bm.Execute();
 }
 
@@ -42,12 +56,24 @@ int main_(int argc, char** argv) {
   const int OPT_NR_REPETITIONS = 3;
   const int OPT_CLEAR_PAGE_CACHE = 4;
   const int OPT_WARMUP = 5;
+  const int OPT_QUERY_THREADS = 6;
+  const int OPT_PARALLEL_FANOUT = 7;
+  const int OPT_COMPARE_NODE_FORMATS = 8;
+  const int OPT_LIMIT = 9;
+  const int OPT_ORDER = 10;
+  const int OPT_BATCH_SIZE = 11;
   static struct option long_options[] = {
     {"pipeline_dir",     required_argument, nullptr, OPT_PIPELINE_DIR},
     {"query_file",       required_argument, nullptr, OPT_QUERY_FILE},
     {"nr_repetitions",   required_argument, nullptr, OPT_NR_REPETITIONS},
     {"clear_page_cache", required_argument, nullptr, OPT_CLEAR_PAGE_CACHE},
     {"warmup",           required_argument, nullptr, OPT_WARMUP},
+    {"query_threads",    required_argument, nullptr, OPT_QUERY_THREADS},
+    {"parallel_fanout",  required_argument, nullptr, OPT_PARALLEL_FANOUT},
+    {"compare_node_formats", required_argument, nullptr, OPT_COMPARE_NODE_FORMATS},
+    {"limit",            required_argument, nullptr, OPT_LIMIT},
+    {"order",            required_argument, nullptr, OPT_ORDER},
+    {"batch_size",       required_argument, nullptr, OPT_BATCH_SIZE},
     {0, 0, 0, 0}
   };
 
@@ -56,6 +82,12 @@ int main_(int argc, char** argv) {
   int nr_repetitions = 1;
   bool clear_page_cache = false;
   bool do_warmup = false;
+  size_t nr_query_threads = 0;
+  size_t parallel_fanout = 32;
+  bool compare_node_formats = false;
+  size_t limit = 0;
+  cas::QueryOrder order = cas::QueryOrder::Unordered;
+  size_t batch_size = 0;
   while (true) {
     int option_index;
     int c = getopt_long(argc, argv, "", long_options, &option_index);
@@ -82,6 +114,45 @@ int main_(int argc, char** argv) {
       case OPT_WARMUP:
         do_warmup = (optvalue == "1" || optvalue == "t");
         break;
+      case OPT_QUERY_THREADS:
+        if (sscanf(optarg, "%zu", &nr_query_threads) != 1) {
+          std::cerr << "Could not parse option --query_threads (integer expected)\n";
+          return 1;
+        }
+        break;
+      case OPT_PARALLEL_FANOUT:
+        if (sscanf(optarg, "%zu", &parallel_fanout) != 1 || parallel_fanout == 0) {
+          std::cerr << "Could not parse option --parallel_fanout (positive integer expected)\n";
+          return 1;
+        }
+        break;
+      case OPT_COMPARE_NODE_FORMATS:
+        compare_node_formats = (optvalue == "1" || optvalue == "t");
+        break;
+      case OPT_LIMIT:
+        if (sscanf(optarg, "%zu", &limit) != 1) {
+          std::cerr << "Could not parse option --limit (integer expected)\n";
+          return 1;
+        }
+        break;
+      case OPT_ORDER:
+        if (optvalue == "unordered") {
+          order = cas::QueryOrder::Unordered;
+        } else if (optvalue == "value_asc") {
+          order = cas::QueryOrder::ValueAsc;
+        } else if (optvalue == "value_desc") {
+          order = cas::QueryOrder::ValueDesc;
+        } else {
+          std::cerr << "Could not parse option --order (unordered, value_asc, or value_desc expected)\n";
+          return 1;
+        }
+        break;
+      case OPT_BATCH_SIZE:
+        if (sscanf(optarg, "%zu", &batch_size) != 1) {
+          std::cerr << "Could not parse option --batch_size (integer expected)\n";
+          return 1;
+        }
+        break;
     }
   }
 
@@ -98,7 +169,9 @@ int main_(int argc, char** argv) {
     return 1;
   }
 
-  ExecuteExperiment(pipeline_dir, query_file, clear_page_cache, do_warmup, nr_repetitions);
+  ExecuteExperiment(pipeline_dir, query_file, clear_page_cache, do_warmup, nr_repetitions,
+      nr_query_threads, parallel_fanout, compare_node_formats, limit, order,
+      batch_size);
   return 0;
 }
 
@@ -2,6 +2,7 @@
 
 #include "cas/bulk_loader_stats.hpp"
 #include "cas/context.hpp"
+#include "cas/types.hpp"
 #include <vector>
 
 namespace benchmark {
@@ -14,6 +15,13 @@ class ExpDscComputation {
   const std::vector<size_t>& memory_sizes_;
   std::vector<cas::BulkLoaderStats> results_;
 
+  struct KernelResult {
+    cas::PrefixKernel kernel_;
+    size_t bytes_compared_ = 0;
+    double runtime_ms_ = 0;
+  };
+  std::vector<KernelResult> kernel_results_;
+
 public:
   ExpDscComputation(
       const cas::Context& context,
@@ -25,6 +33,7 @@ public:
 
 private:
   void ExecuteMethod(cas::DscComputation method, size_t memory_size);
+  void BenchmarkPrefixKernels();
   void PrintOutput();
 };
 
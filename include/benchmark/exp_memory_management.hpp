@@ -11,20 +11,26 @@ template<class VType>
 class ExpMemoryManagement {
   cas::Context context_;
   const std::vector<cas::MemoryPlacement>& approaches_;
+  const std::vector<cas::PageFormat>& page_formats_;
   const std::vector<size_t>& memory_sizes_;
+  const std::vector<size_t>& write_behind_pages_;
   std::vector<cas::BulkLoaderStats> results_;
 
 public:
   ExpMemoryManagement(
       const cas::Context& context,
       const std::vector<cas::MemoryPlacement>& approaches,
-      const std::vector<size_t>& memory_size
+      const std::vector<cas::PageFormat>& page_formats,
+      const std::vector<size_t>& memory_size,
+      const std::vector<size_t>& write_behind_pages
   );
 
   void Execute();
 
 private:
-  void ExecuteMethod(cas::MemoryPlacement method, size_t memory_size);
+  void ExecuteMethod(cas::MemoryPlacement method,
+      cas::PageFormat page_format, size_t memory_size,
+      size_t write_behind_pages);
   void PrintOutput();
 };
 
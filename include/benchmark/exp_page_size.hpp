@@ -0,0 +1,33 @@
+#pragma once
+
+#include "cas/bulk_loader_stats.hpp"
+#include "cas/context.hpp"
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+
+// bulk-loads the same dataset with different page sizes; the input for
+// page size p is read from <input_filename>.<p> (see csv2partition)
+template<class VType>
+class ExpPageSize {
+  cas::Context context_;
+  const std::vector<size_t>& page_sizes_;
+  std::vector<cas::BulkLoaderStats> results_;
+
+public:
+  ExpPageSize(
+      const cas::Context& context,
+      const std::vector<size_t>& page_sizes
+  );
+
+  void Execute();
+
+private:
+  void Execute(size_t page_size);
+  std::string InputFilename(size_t page_size) const;
+  void PrintOutput();
+};
+
+}; // namespace benchmark
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "cas/bulk_loader_stats.hpp"
+#include "cas/context.hpp"
+#include <vector>
+
+namespace benchmark {
+
+
+template<class VType>
+class ExpParallelConstruction {
+  cas::Context context_;
+  const std::vector<size_t>& thread_counts_;
+  std::vector<cas::BulkLoaderStats> results_;
+
+public:
+  ExpParallelConstruction(
+      const cas::Context& context,
+      const std::vector<size_t>& thread_counts
+  );
+
+  void Execute();
+
+private:
+  void Execute(size_t nr_threads);
+  void PrintOutput();
+};
+
+}; // namespace benchmark
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "cas/search_key.hpp"
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+
+template<class VType>
+class ExpQueryThroughput {
+  struct Result {
+    size_t nr_clients_ = 0;
+    size_t nr_queries_ = 0;
+    size_t nr_matches_ = 0;
+    double runtime_ms_ = 0;
+  };
+
+  const std::string& pipeline_dir_;
+  const std::vector<size_t>& client_counts_;
+  const size_t nr_workers_;
+  const int nr_repetitions_;
+
+  std::vector<cas::BinarySK> encoded_queries_;
+  std::vector<Result> results_;
+
+public:
+  ExpQueryThroughput(
+      const std::string& pipeline_dir,
+      const std::vector<cas::SearchKey<VType>>& queries,
+      const std::vector<size_t>& client_counts,
+      size_t nr_workers,
+      int nr_repetitions = 1
+  );
+
+  void Execute();
+
+private:
+  void Execute(size_t nr_clients);
+  void PrintOutput();
+};
+
+}; // namespace benchmark
@@ -17,9 +17,43 @@ class ExpQuerying {
   const bool clear_page_cache_;
   const bool do_warmup_;
   int nr_repetitions_;
+  const size_t nr_query_threads_;
+  const size_t parallel_fanout_;
+  const bool compare_node_formats_;
+  // if > 0, the queries are additionally executed with a pushed-down limit
+  const size_t limit_;
+  const cas::QueryOrder order_;
+  // if > 0, the queries are additionally executed in batches of this size
+  const size_t batch_size_;
 
   std::vector<cas::BinarySK> encoded_queries_;
   std::vector<cas::QueryStats> results_;
+  // end-to-end latencies (in microseconds) of every query execution
+  // with and without a persistent IndexReader, and with the
+  // IndexReader and the specialized QueryEngine
+  std::vector<double> latencies_per_query_mapping_;
+  std::vector<double> latencies_index_reader_;
+  std::vector<double> latencies_query_engine_;
+  // totals of Query and QueryEngine (both with IndexReader)
+  cas::QueryStats totals_query_;
+  cas::QueryStats totals_query_engine_;
+  // Query on a pool of nr_query_threads_ (with IndexReader)
+  std::vector<double> latencies_parallel_;
+  cas::QueryStats totals_parallel_;
+  // totals and latencies of the queries with a limit
+  cas::QueryStats totals_limit_;
+  std::vector<double> latencies_limit_;
+  // totals of the batches (nodes read once per batch)
+  cas::QueryStats totals_batch_;
+
+  struct FormatResult {
+    cas::NodeFormat format_;
+    double read_nodes_ = 0;
+    double runtime_ms_ = 0;
+    double p50_mus_ = 0;
+    double p99_mus_ = 0;
+  };
+  std::vector<FormatResult> format_results_;
 
 public:
   ExpQuerying(
@@ -27,7 +61,13 @@ public:
       const std::vector<cas::SearchKey<VType>>& queries,
       bool clear_page_cache = false,
       bool do_warmup = false,
-      int nr_repetitions = 1
+      int nr_repetitions = 1,
+      size_t nr_query_threads = 0,
+      size_t parallel_fanout = 32,
+      bool compare_node_formats = false,
+      size_t limit = 0,
+      cas::QueryOrder order = cas::QueryOrder::Unordered,
+      size_t batch_size = 0
   );
 
   void Execute();
@@ -39,7 +79,18 @@ public:
 
 private:
   void DoWarmUp();
+  void Execute(bool use_index_reader, bool use_query_engine,
+      std::vector<double>& latencies);
+  void Execute(const std::string& pipeline_dir, bool use_index_reader,
+      bool use_query_engine, std::vector<double>& latencies,
+      size_t nr_query_threads, size_t limit = 0);
+  void ExecuteParallel();
+  void ExecuteBatches();
+  void CompareNodeFormats();
+  static void ConvertIndexFile(const std::string& src, const std::string& dst,
+      cas::NodeFormat format);
   void PrintOutput();
+  static double Percentile(std::vector<double> values, double percentile);
 };
 
 }; // namespace benchmark
@@ -19,6 +19,14 @@ public:
   void Execute();
 
 private:
+  // builds the index with and without ref dictionary and leaf
+  // compression and prints the size of each index file
+  void CompareIndexSizes();
+
+  // builds the index with absolute and relative child pointers and
+  // prints the average width of the inner nodes
+  void CompareInnerNodeWidths();
+
   void PrintOutput(
       const cas::Histogram& histogram,
       int nr_bins,
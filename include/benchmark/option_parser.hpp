@@ -50,6 +50,28 @@ void Parse(int argc, char** argv, cas::Context& context) {
   const int OPT_DIRECT_IO = 9;
   const int OPT_PARTITIONING_DSC = 10;
   const int OPT_MEMORY_PLACEMENT = 11;
+  const int OPT_THREADS = 12;
+  const int OPT_IO_QUEUE_DEPTH = 13;
+  const int OPT_INDEX_READER = 14;
+  const int OPT_INDEX_ADVICE = 15;
+  const int OPT_QUERY_PARALLEL_FANOUT = 16;
+  const int OPT_NODE_FORMAT = 17;
+  const int OPT_QUERY_ENGINE = 18;
+  const int OPT_SUBTREE_STATS = 19;
+  const int OPT_PAGE_FORMAT = 20;
+  const int OPT_PARTITION_COMPRESSION = 21;
+  const int OPT_REF_DICTIONARY = 22;
+  const int OPT_LEAF_COMPRESSION = 23;
+  const int OPT_LEAF_COMPRESSION_THRESHOLD = 24;
+  const int OPT_RELATIVE_POINTERS = 25;
+  const int OPT_VARINT_HEADERS = 26;
+  const int OPT_PARALLEL_PARTITIONING = 27;
+  const int OPT_READ_AHEAD_DEPTH = 28;
+  const int OPT_WRITE_BEHIND_PAGES = 29;
+  const int OPT_PAGE_SIZE = 30;
+  const int OPT_HUGE_PAGES = 31;
+  const int OPT_PREFAULT_MEMORY = 32;
+  const int OPT_NUMA_INTERLEAVE = 33;
   static struct option long_options[] = {
     {"input_filename",         required_argument, nullptr, OPT_INPUT_FILENAME},
     {"partition_folder",       required_argument, nullptr, OPT_PARTITION_FOLDER},
@@ -62,6 +84,28 @@ void Parse(int argc, char** argv, cas::Context& context) {
     {"direct_io",              required_argument, nullptr, OPT_DIRECT_IO},
     {"partitioning_dsc",       required_argument, nullptr, OPT_PARTITIONING_DSC},
     {"memory_placement",       required_argument, nullptr, OPT_MEMORY_PLACEMENT},
+    {"threads",                required_argument, nullptr, OPT_THREADS},
+    {"io_queue_depth",         required_argument, nullptr, OPT_IO_QUEUE_DEPTH},
+    {"index_reader",           required_argument, nullptr, OPT_INDEX_READER},
+    {"index_advice",           required_argument, nullptr, OPT_INDEX_ADVICE},
+    {"query_parallel_fanout",  required_argument, nullptr, OPT_QUERY_PARALLEL_FANOUT},
+    {"node_format",            required_argument, nullptr, OPT_NODE_FORMAT},
+    {"query_engine",           required_argument, nullptr, OPT_QUERY_ENGINE},
+    {"subtree_stats",          required_argument, nullptr, OPT_SUBTREE_STATS},
+    {"page_format",            required_argument, nullptr, OPT_PAGE_FORMAT},
+    {"partition_compression",  required_argument, nullptr, OPT_PARTITION_COMPRESSION},
+    {"ref_dictionary",         required_argument, nullptr, OPT_REF_DICTIONARY},
+    {"leaf_compression",       required_argument, nullptr, OPT_LEAF_COMPRESSION},
+    {"leaf_compression_threshold", required_argument, nullptr, OPT_LEAF_COMPRESSION_THRESHOLD},
+    {"relative_pointers",      required_argument, nullptr, OPT_RELATIVE_POINTERS},
+    {"varint_headers",         required_argument, nullptr, OPT_VARINT_HEADERS},
+    {"parallel_partitioning",  required_argument, nullptr, OPT_PARALLEL_PARTITIONING},
+    {"read_ahead_depth",       required_argument, nullptr, OPT_READ_AHEAD_DEPTH},
+    {"write_behind_pages",     required_argument, nullptr, OPT_WRITE_BEHIND_PAGES},
+    {"page_size",              required_argument, nullptr, OPT_PAGE_SIZE},
+    {"huge_pages",             required_argument, nullptr, OPT_HUGE_PAGES},
+    {"prefault_memory",        required_argument, nullptr, OPT_PREFAULT_MEMORY},
+    {"numa_interleave",        required_argument, nullptr, OPT_NUMA_INTERLEAVE},
     {0, 0, 0, 0}
   };
 
@@ -128,6 +172,136 @@ void Parse(int argc, char** argv, cas::Context& context) {
           exit(-1);
         }
         break;
+      case OPT_THREADS:
+        ParseSizeT(optarg, context.nr_threads_, long_options[option_index].name);
+        break;
+      case OPT_IO_QUEUE_DEPTH:
+        ParseSizeT(optarg, context.io_queue_depth_, long_options[option_index].name);
+        break;
+      case OPT_INDEX_READER:
+        ParseBool(optvalue, context.use_index_reader_, long_options[option_index].name);
+        break;
+      case OPT_INDEX_ADVICE:
+        if (optvalue == "normal") {
+          context.index_advice_ = cas::IndexAdvice::Normal;
+        } else if (optvalue == "random") {
+          context.index_advice_ = cas::IndexAdvice::Random;
+        } else if (optvalue == "sequential") {
+          context.index_advice_ = cas::IndexAdvice::Sequential;
+        } else if (optvalue == "willneed") {
+          context.index_advice_ = cas::IndexAdvice::WillNeed;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {normal,random,sequential,willneed})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_QUERY_PARALLEL_FANOUT:
+        ParseSizeT(optarg, context.query_parallel_fanout_, long_options[option_index].name);
+        break;
+      case OPT_QUERY_ENGINE:
+        ParseBool(optvalue, context.use_query_engine_, long_options[option_index].name);
+        break;
+      case OPT_SUBTREE_STATS:
+        ParseBool(optvalue, context.subtree_stats_, long_options[option_index].name);
+        break;
+      case OPT_NODE_FORMAT:
+        if (optvalue == "interleaved") {
+          context.node_format_ = cas::NodeFormat::Interleaved;
+        } else if (optvalue == "key_array") {
+          context.node_format_ = cas::NodeFormat::KeyArray;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {interleaved,key_array})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_PAGE_FORMAT:
+        if (optvalue == "plain") {
+          context.page_format_ = cas::PageFormat::Plain;
+        } else if (optvalue == "front_coded") {
+          context.page_format_ = cas::PageFormat::FrontCoded;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {plain,front_coded})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_PARTITION_COMPRESSION:
+        if (optvalue == "none") {
+          context.partition_compression_ = cas::Compression::None;
+        } else if (optvalue == "lz4") {
+          context.partition_compression_ = cas::Compression::Lz4;
+        } else if (optvalue == "zstd") {
+          context.partition_compression_ = cas::Compression::Zstd;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {none,lz4,zstd})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_REF_DICTIONARY:
+        ParseBool(optvalue, context.ref_dictionary_, long_options[option_index].name);
+        break;
+      case OPT_LEAF_COMPRESSION:
+        if (optvalue == "none") {
+          context.leaf_compression_ = cas::Compression::None;
+        } else if (optvalue == "lz4") {
+          context.leaf_compression_ = cas::Compression::Lz4;
+        } else if (optvalue == "zstd") {
+          context.leaf_compression_ = cas::Compression::Zstd;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {none,lz4,zstd})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_LEAF_COMPRESSION_THRESHOLD:
+        ParseSizeT(optarg, context.leaf_compression_threshold_, long_options[option_index].name);
+        break;
+      case OPT_RELATIVE_POINTERS:
+        ParseBool(optvalue, context.relative_pointers_, long_options[option_index].name);
+        break;
+      case OPT_VARINT_HEADERS:
+        ParseBool(optvalue, context.varint_headers_, long_options[option_index].name);
+        break;
+      case OPT_PARALLEL_PARTITIONING:
+        ParseBool(optvalue, context.parallel_partitioning_, long_options[option_index].name);
+        break;
+      case OPT_READ_AHEAD_DEPTH:
+        ParseSizeT(optarg, context.read_ahead_depth_, long_options[option_index].name);
+        break;
+      case OPT_WRITE_BEHIND_PAGES:
+        ParseSizeT(optarg, context.write_behind_pages_, long_options[option_index].name);
+        break;
+      case OPT_PAGE_SIZE:
+        ParseSizeT(optarg, context.page_size_, long_options[option_index].name);
+        break;
+      case OPT_HUGE_PAGES:
+        if (optvalue == "none") {
+          context.huge_pages_ = cas::HugePages::None;
+        } else if (optvalue == "transparent") {
+          context.huge_pages_ = cas::HugePages::Transparent;
+        } else if (optvalue == "explicit") {
+          context.huge_pages_ = cas::HugePages::Explicit;
+        } else {
+          std::cerr << "Could not parse option --"
+            << std::string{long_options[option_index].name}
+            << "=" << optvalue << " (expected {none,transparent,explicit})\n";
+          exit(-1);
+        }
+        break;
+      case OPT_PREFAULT_MEMORY:
+        ParseBool(optvalue, context.prefault_memory_, long_options[option_index].name);
+        break;
+      case OPT_NUMA_INTERLEAVE:
+        ParseBool(optvalue, context.numa_interleave_, long_options[option_index].name);
+        break;
     }
   }
 }
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "cas/path_matcher.hpp"
+#include "cas/query.hpp"
+#include "cas/query_engine.hpp"
+#include "cas/query_stats.hpp"
+#include "cas/search_key.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+namespace cas {
+
+
+// Evaluates a batch of queries with a single traversal of the trie.
+//
+// Every node is read at most once for the whole batch. Along with it the
+// traversal carries the queries whose path and value prefixes still
+// match, each with its own matching state. A child is only visited if
+// its byte lies in the child range of at least one of these queries, and
+// only those queries are passed on to it. Matches are routed to the
+// emitter of their query.
+//
+// Stats() counts the nodes read by the batch, StatsPerQuery() the nodes
+// that each query would have read on its own (i.e., the same numbers as
+// with Query) and its matches.
+template<class NodeT>
+class BatchQuery {
+  using Access = NodeAccess<NodeT>;
+  using Handle = typename Access::Handle;
+
+  // a query that is still active in the current subtree; the prefixes
+  // matched so far are the same for all queries and kept in the buffers
+  struct Active {
+    uint32_t query_;
+    path_matcher::State pm_state_;
+    uint16_t vl_pos_ = 0;
+    uint16_t vh_pos_ = 0;
+    std::byte low_ = cas::kNullByte;
+    std::byte high_ = cas::kNullByte;
+  };
+
+  const NodeT* root_;
+  const std::vector<BinarySK>& keys_;
+  const std::vector<BinaryKeyEmitter>& emitters_;
+  std::unique_ptr<QueryBuffer> buf_pat_;
+  std::unique_ptr<QueryBuffer> buf_val_;
+  // active queries of a node and those routed to a child, per depth
+  // (deques such that growing them keeps references valid)
+  std::deque<std::vector<Active>> active_;
+  std::deque<std::vector<Active>> routed_;
+  QueryStats stats_;
+  std::vector<QueryStats> query_stats_;
+
+public:
+  BatchQuery(const NodeT* root,
+      const std::vector<BinarySK>& keys,
+      const std::vector<BinaryKeyEmitter>& emitters);
+
+  void Execute();
+
+  const QueryStats& Stats() const {
+    return stats_;
+  }
+
+  const std::vector<QueryStats>& StatsPerQuery() const {
+    return query_stats_;
+  }
+
+private:
+  void Evaluate(const Handle& handle, const std::vector<Active>& parent,
+      uint16_t len_pat, uint16_t len_val, int depth);
+  void EvaluateLeafNode(const NodeT& node, const std::vector<Active>& active,
+      uint16_t len_pat, uint16_t len_val, int depth);
+  static void UpdateStats(QueryStats& stats, cas::Dimension dimension);
+};
+
+
+} // namespace cas
+
+
+template<class NodeT>
+cas::BatchQuery<NodeT>::BatchQuery(
+        const NodeT* root,
+        const std::vector<BinarySK>& keys,
+        const std::vector<BinaryKeyEmitter>& emitters)
+    : root_(root)
+    , keys_(keys)
+    , emitters_(emitters)
+    , buf_pat_(std::make_unique<QueryBuffer>())
+    , buf_val_(std::make_unique<QueryBuffer>())
+    , query_stats_(keys.size())
+{
+  if (keys.size() != emitters.size()) {
+    throw std::runtime_error{"every query of a batch needs an emitter"};
+  }
+}
+
+
+template<class NodeT>
+void cas::BatchQuery<NodeT>::Execute() {
+  const auto& t_start = std::chrono::high_resolution_clock::now();
+  if (root_ != nullptr && !keys_.empty()) {
+    std::vector<Active> all(keys_.size());
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      all[i].query_ = static_cast<uint32_t>(i);
+    }
+    Evaluate(Access::Root(root_), all, 0, 0, 0);
+  }
+  const auto& t_end = std::chrono::high_resolution_clock::now();
+  stats_.runtime_mus_ +=
+    std::chrono::duration_cast<std::chrono::microseconds>(t_end-t_start).count();
+}
+
+
+template<class NodeT>
+void cas::BatchQuery<NodeT>::Evaluate(
+    const Handle& handle,
+    const std::vector<Active>& parent,
+    uint16_t len_pat,
+    uint16_t len_val,
+    int depth) {
+  const NodeT& node = Access::Get(handle);
+  cas::Dimension dimension = Access::Dimension(node);
+  UpdateStats(stats_, dimension);
+
+  // the parent's byte has already been appended
+  size_t len_p = Access::LenPath(node);
+  size_t len_v = Access::LenValue(node);
+  std::memcpy(&buf_pat_->at(len_pat), Access::Path(node),  len_p);
+  std::memcpy(&buf_val_->at(len_val), Access::Value(node), len_v);
+  len_pat += len_p;
+  len_val += len_v;
+
+  if (active_.size() <= static_cast<size_t>(depth)) {
+    active_.resize(depth + 1);
+    routed_.resize(depth + 1);
+  }
+  auto& active = active_[depth];
+  active.clear();
+  for (const auto& query : parent) {
+    UpdateStats(query_stats_[query.query_], dimension);
+    Active a = query;
+    const auto& key = keys_[a.query_];
+    auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key,
+        len_pat, a.pm_state_);
+    auto match_val = Query::MatchValue(key, *buf_val_, len_val,
+        a.vl_pos_, a.vh_pos_);
+    if (match_pat == path_matcher::PrefixMatch::MISMATCH ||
+        match_val == path_matcher::PrefixMatch::MISMATCH) {
+      continue;
+    }
+    if (dimension != cas::Dimension::LEAF &&
+        match_pat == path_matcher::PrefixMatch::MATCH &&
+        match_val == path_matcher::PrefixMatch::MATCH) {
+      throw std::runtime_error{"an inner node cannot MATCH"};
+    }
+    active.push_back(a);
+  }
+  if (active.empty()) {
+    return;
+  }
+
+  if (dimension == cas::Dimension::LEAF) {
+    EvaluateLeafNode(node, active, len_pat, len_val, depth);
+    return;
+  }
+
+  // the children in the union of the active queries' child ranges
+  std::byte low = std::byte{0xFF};
+  std::byte high = cas::kNullByte;
+  for (auto& a : active) {
+    if (dimension == cas::Dimension::PATH) {
+      Query::PathChildRange(keys_[a.query_], a.pm_state_, a.low_, a.high_);
+    } else {
+      Query::ValueChildRange(keys_[a.query_], len_val,
+          a.vl_pos_, a.vh_pos_, a.low_, a.high_);
+    }
+    low = std::min(low, a.low_);
+    high = std::max(high, a.high_);
+  }
+  if (low > high) {
+    return;
+  }
+
+  auto& routed = routed_[depth];
+  auto cursor = Access::FirstChild(node, static_cast<uint8_t>(low));
+  uint8_t byte = 0;
+  while (auto child = Access::NextChild(node, cursor, static_cast<uint8_t>(high), byte)) {
+    routed.clear();
+    for (const auto& a : active) {
+      if (a.low_ <= std::byte{byte} && std::byte{byte} <= a.high_) {
+        routed.push_back(a);
+      }
+    }
+    if (routed.empty()) {
+      continue;
+    }
+    if (dimension == cas::Dimension::PATH) {
+      (*buf_pat_)[len_pat] = std::byte{byte};
+      Evaluate(*child, routed, len_pat + 1, len_val, depth + 1);
+    } else {
+      (*buf_val_)[len_val] = std::byte{byte};
+      Evaluate(*child, routed, len_pat, len_val + 1, depth + 1);
+    }
+  }
+}
+
+
+template<class NodeT>
+void cas::BatchQuery<NodeT>::EvaluateLeafNode(
+    const NodeT& node,
+    const std::vector<Active>& active,
+    uint16_t len_pat,
+    uint16_t len_val,
+    int depth) {
+  auto cursor = Access::FirstSuffix(node);
+  while (Access::NextSuffix(node, cursor, [&](
+        size_t len_p, const uint8_t* path,
+        size_t len_v, const uint8_t* value,
+        cas::ref_t ref) {
+    if (len_p > 0) {
+      std::memcpy(&buf_pat_->at(len_pat), path, len_p);
+    }
+    if (len_v > 0) {
+      std::memcpy(&buf_val_->at(len_val), value, len_v);
+    }
+    uint16_t len_pat_suffix = len_pat + len_p;
+    uint16_t len_val_suffix = len_val + len_v;
+    for (const auto& query : active) {
+      // we need to copy the state since it is mutated
+      Active a = query;
+      const auto& key = keys_[a.query_];
+      auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key,
+          len_pat_suffix, a.pm_state_);
+      auto match_val = Query::MatchValue(key, *buf_val_, len_val_suffix,
+          a.vl_pos_, a.vh_pos_);
+      if (match_pat == path_matcher::PrefixMatch::MATCH &&
+          match_val == path_matcher::PrefixMatch::MATCH) {
+        auto& stats = query_stats_[a.query_];
+        ++stats.nr_matches_;
+        stats.sum_depth_ += depth;
+        ++stats_.nr_matches_;
+        stats_.sum_depth_ += depth;
+        emitters_[a.query_](*buf_pat_, len_pat_suffix, *buf_val_, len_val_suffix, ref);
+      }
+    }
+  })) {
+  }
+}
+
+
+template<class NodeT>
+void cas::BatchQuery<NodeT>::UpdateStats(QueryStats& stats, cas::Dimension dimension) {
+  ++stats.read_nodes_;
+  switch (dimension) {
+  case cas::Dimension::PATH:
+    ++stats.read_path_nodes_;
+    break;
+  case cas::Dimension::VALUE:
+    ++stats.read_value_nodes_;
+    break;
+  case cas::Dimension::LEAF:
+    ++stats.read_leaf_nodes_;
+    break;
+  }
+}
@@ -24,6 +24,9 @@ class BinaryKey {
   std::byte* data_;
 
 public:
+  // size of the longest key
+  static constexpr size_t MAX_BYTE_SIZE = POS_DATA + 2 * UINT16_MAX;
+
   BinaryKey(std::byte* data) : data_(data) {}
   ~BinaryKey() {}
 
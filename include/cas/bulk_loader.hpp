@@ -3,6 +3,7 @@
 #include "cas/binary_key.hpp"
 #include "cas/bulk_loader_stats.hpp"
 #include "cas/context.hpp"
+#include "cas/io_engine.hpp"
 #include "cas/key.hpp"
 #include "cas/memory_pool.hpp"
 #include "cas/partition.hpp"
@@ -11,6 +12,11 @@
 #include <deque>
 #include <iostream>
 #include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace cas {
 
@@ -19,14 +25,76 @@ class BulkLoader {
   const Context& context_;
   BulkLoaderStats& stats_;
   MemoryPools mpool_;
+  IoEngine io_;
   Pager pager_;
   long partition_counter_ = 0;
-  std::array<std::unique_ptr<std::array<std::byte, cas::PAGE_SZ>>, cas::BYTE_MAX> ref_keys_;
-  std::unique_ptr<std::array<std::byte, cas::PAGE_SZ>> shortened_key_buffer_;
-  std::unique_ptr<std::array<uint8_t, 10'000'000>> serialization_buffer_;
+  // keys are not longer than a page (see KeyBuffer)
+  std::array<std::unique_ptr<std::vector<std::byte>>, cas::BYTE_MAX> ref_keys_;
+  std::unique_ptr<std::vector<std::byte>> shortened_key_buffer_;
+  // holds a serialized node, grows to the size of the largest node
+  static constexpr size_t SERIALIZATION_BUFFER_SZ = 10'000'000;
+  std::unique_ptr<std::vector<uint8_t>> serialization_buffer_;
+  std::vector<std::byte> compression_buffer_;
 
   std::chrono::time_point<std::chrono::high_resolution_clock> start_time_global;
 
+  // helpers that construct subtrees in parallel (see ConstructParallel)
+  struct Worker {
+    Context context_;
+    BulkLoaderStats stats_;
+    std::unique_ptr<BulkLoader> loader_;
+    size_t file_pos_ = 0;
+  };
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // share of a worker in partitioning the root partition (see
+  // PsiPartitionParallel)
+  struct ScatterTask {
+    std::vector<MemoryPage> memory_pages_;
+    size_t first_page_nr_ = 0;
+    size_t last_page_nr_ = 0;
+    // the worker's output page, discriminative bytes (relative to the
+    // worker's reference key), and key bytes of every partition
+    std::vector<MemoryPage> pages_;
+    std::array<size_t, cas::BYTE_MAX> dsc_p_{};
+    std::array<size_t, cas::BYTE_MAX> dsc_v_{};
+    std::array<size_t, cas::BYTE_MAX> key_bytes_{};
+  };
+
+  // index-wide dictionary of the references in the leaves (see
+  // Context::ref_dictionary_), shared with the workers. The ids are
+  // assigned in the order in which references are first seen.
+  struct RefDictionary {
+    // references are hashes, their first bytes are a good hash value
+    struct Hash {
+      size_t operator()(const ref_t& ref) const {
+        size_t hash;
+        std::memcpy(&hash, &ref, sizeof(size_t));
+        return hash;
+      }
+    };
+    std::mutex mutex_;
+    std::unordered_map<ref_t, uint32_t, Hash> ids_;
+    std::vector<ref_t> refs_;
+
+    // appends the ids of the suffixes' references to ids
+    void Lookup(const std::vector<MemoryKey>& suffixes,
+        std::vector<uint32_t>& ids);
+  };
+  std::shared_ptr<RefDictionary> ref_dictionary_;
+
+
+  // number of keys and smallest/largest value of a subtree; the values
+  // are relative to the complete value prefix of the subtree's root
+  struct SubtreeStats {
+    size_t nr_keys_ = 0;
+    std::vector<std::byte> min_value_;
+    std::vector<std::byte> max_value_;
+
+    void Add(const std::byte* value, size_t len);
+    // merges the statistics of a child whose values start after prefix
+    void Merge(const SubtreeStats& child, const std::vector<std::byte>& prefix);
+  };
 
   struct Node {
     cas::Dimension dimension_ = cas::Dimension::PATH;
@@ -34,6 +102,19 @@ class BulkLoader {
     std::vector<std::byte> value_;
     std::vector<std::tuple<std::byte,size_t>> children_pointers_;
     std::vector<MemoryKey> suffixes_;
+    // ids of the suffixes' references if the index has a ref dictionary
+    std::vector<uint32_t> ref_ids_;
+    // serialized in the extended header of inner nodes if
+    // Context::subtree_stats_ is set
+    SubtreeStats subtree_;
+    bool has_subtree_stats_ = false;
+    size_t len_subtree_values_ = 0;
+    // leaves start with a marker if Context::leaf_compression_ is set
+    bool has_leaf_marker_ = false;
+    // bytes per child pointer, 6: absolute, 1/2/4: relative to the node
+    int pointer_width_ = 6;
+    // see Context::varint_headers_
+    bool varint_header_ = false;
 
     size_t ByteSize(int nr_children) const;
     void Dump() const;
@@ -44,26 +125,95 @@ public:
   BulkLoader(const Context& context, BulkLoaderStats& stats);
   void Load();
   void Load(Partition& partition);
+  // partitions the root partition into table, e.g., to inspect the
+  // child partitions; table must be destroyed before the bulk-loader
+  void PartitionRoot(PartitionTable& table, cas::Dimension dimension);
   BulkLoaderStats& Stats() { return stats_; }
 
 private:
+  // constructor of a worker, its pools are a slice of parent_pools
+  BulkLoader(const Context& context, BulkLoaderStats& stats,
+      MemoryPools& parent_pools);
+
+  // a buffer for the longest key of a page
+  std::unique_ptr<std::vector<std::byte>> KeyBuffer() const;
+
+  // backing of the memory pools as configured in the context
+  static MemoryBacking PoolBacking(const Context& context);
+
+  void InitializeWorkers();
+  void ReleaseWorkers();
+
+  // the statistics of the subtree are merged into parent_stats
   size_t Construct(
       cas::Partition& partition,
       cas::Dimension dimension,
       cas::Dimension par_dimension,
       int depth = 0,
-      size_t offset = 0);
+      size_t offset = 0,
+      SubtreeStats* parent_stats = nullptr);
+
+  size_t ConstructParallel(
+      Node& node,
+      PartitionTable& table,
+      cas::Dimension dimension,
+      cas::Dimension par_dimension,
+      int depth,
+      size_t offset);
+
+  void RelocateSubtree(
+      const uint8_t* src,
+      size_t begin,
+      size_t end,
+      size_t offset);
 
   void PsiPartition(
       PartitionTable& table,
       Partition& partition,
       const cas::Dimension dimension);
 
+  void PsiPartitionParallel(
+      PartitionTable& table,
+      Partition& partition,
+      const cas::Dimension dimension,
+      bool use_memory_pages);
+
+  void Scatter(
+      BulkLoader& parent,
+      PartitionTable& table,
+      Partition& partition,
+      const cas::Dimension dimension,
+      ScatterTask& task,
+      std::mutex& mutex,
+      bool use_memory_pages);
+
+  int ShortenKey(
+      const Partition& partition,
+      const BinaryKey& key,
+      BinaryKey& shortened,
+      const cas::Dimension dimension) const;
+
+  void SpillOutputPage(
+      PartitionTable& table,
+      int b,
+      MemoryPage& page,
+      bool use_memory_pages);
+
+  void RefillPool(MemoryPool& pool, PartitionTable& table);
+
   void ConstructLeafNode(
       Node& node,
       cas::Partition& partition);
 
-  size_t SerializeNode(Node& node);
+  size_t SerializeNode(Node& node, size_t node_pos);
+
+  size_t SubtreeBound(Partition& partition) const;
+
+  int RelativePointerWidth(const Node& node, PartitionTable& table) const;
+
+  size_t CompressLeaf(size_t marker_pos, size_t end);
+
+  void WriteTrailer(size_t nodes_end);
 
   void CopyToSerializationBuffer(
       size_t& offset, const void* src, size_t count);
@@ -72,9 +222,14 @@ private:
   void UpdatePartitionStats(const Partition& partition);
 
   void InitializeRootPartition(Partition& partition);
+  void RootDscBytes(Partition& partition);
 
   void DscByte(Partition& partition);
   void DscByteByByte(Partition& partition);
+  void UpdateDscBytes(Partition& partition,
+      const BinaryKey& key, const BinaryKey& ref_key);
+  void UpdateDscBytes(size_t& dsc_p, size_t& dsc_v,
+      const BinaryKey& key, const BinaryKey& ref_key);
 };
 
 }
@@ -10,6 +10,11 @@ namespace cas {
 struct Timer {
   size_t count_{0};
   std::chrono::microseconds time_{0};
+
+  void Merge(const Timer& other) {
+    count_ += other.count_;
+    time_ += other.time_;
+  }
 };
 
 
@@ -27,9 +32,17 @@ struct BulkLoaderStats {
   size_t index_bytes_read_{0};
   size_t mem_pages_read_{0};
   size_t mem_pages_written_{0};
+  // pwrite/pwritev calls and io_uring writes of partition pages
+  size_t partition_write_requests_{0};
   size_t nr_path_nodes_{0};
   size_t nr_value_nodes_{0};
   size_t nr_leaf_nodes_{0};
+  // leaves whose suffixes are compressed (see Context::leaf_compression_)
+  size_t nr_compressed_leaves_{0};
+  // distinct references in the index (see Context::ref_dictionary_)
+  size_t nr_dictionary_refs_{0};
+  // bytes compared to compute discriminative bytes (see CommonPrefix)
+  size_t dsc_bytes_compared_{0};
   Timer runtime_;
   Timer runtime_root_partition_;
   Timer runtime_construction_;
@@ -39,6 +52,12 @@ struct BulkLoaderStats {
   Timer runtime_partitioning_disk_only_;
   Timer runtime_partition_disk_read_;
   Timer runtime_partition_disk_write_;
+  Timer runtime_partition_io_submit_;
+  Timer runtime_partition_io_wait_;
+  Timer runtime_partition_compression_;
+  Timer runtime_partition_decompression_;
+  // time a cursor waits for the pages read ahead (see Partition::Cursor)
+  Timer runtime_partition_read_ahead_wait_;
   Timer runtime_construct_leaf_node_;
   Timer runtime_dsc_computation_;
   Timer runtime_insertion_;
@@ -51,6 +70,9 @@ struct BulkLoaderStats {
   size_t IoOverhead() const;
   size_t DiskIo() const;
 
+  // adds the counters of other (e.g., those of a worker thread)
+  void Merge(const BulkLoaderStats& other);
+
   void Dump() const;
 
 private:
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "cas/types.hpp"
+#include <cstddef>
+
+
+namespace cas {
+
+namespace detail {
+using CommonPrefixFn = size_t (*)(const std::byte* a, const std::byte* b, size_t len);
+// the fastest kernel supported by the CPU, selected at startup
+extern const CommonPrefixFn kCommonPrefix;
+} // namespace detail
+
+
+// Length of the longest common prefix of a and b, but at most len.
+// Both buffers must be readable up to len bytes. Short comparisons
+// (e.g., of values) are inlined, longer ones use vector instructions
+// if the CPU supports them.
+inline size_t CommonPrefix(const std::byte* a, const std::byte* b, size_t len) {
+  if (len < 16) {
+    size_t i = 0;
+    while (i < len && a[i] == b[i]) {
+      ++i;
+    }
+    return i;
+  }
+  return detail::kCommonPrefix(a, b, len);
+}
+
+// CommonPrefix with a specific kernel (which must be supported)
+size_t CommonPrefix(PrefixKernel kernel,
+    const std::byte* a, const std::byte* b, size_t len);
+
+bool IsSupported(PrefixKernel kernel);
+
+// the kernel used by CommonPrefix
+PrefixKernel ActivePrefixKernel();
+
+} // namespace cas
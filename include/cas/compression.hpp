@@ -0,0 +1,28 @@
+#pragma once
+
+#include "cas/types.hpp"
+#include <cstddef>
+
+
+namespace cas {
+
+// Codecs for the pages of partition files and the leaves of index files
+// (see IndexLayout). LZ4 and zstd are only available if the library was
+// built with them (see src/CMakeLists.txt).
+
+bool IsSupported(Compression compression);
+
+// maximum size of the compressed representation of len bytes
+size_t CompressBound(Compression compression, size_t len);
+
+// compresses src into dst and returns the compressed size
+size_t Compress(Compression compression,
+    const std::byte* src, size_t len,
+    std::byte* dst, size_t capacity);
+
+// decompresses src into dst and returns the decompressed size
+size_t Decompress(Compression compression,
+    const std::byte* src, size_t len,
+    std::byte* dst, size_t capacity);
+
+} // namespace cas
@@ -29,6 +29,28 @@ struct Context {
   int root_dsc_P_ = 0;
   int root_dsc_V_ = 0;
   bool delete_root_partition_ = false;
+  size_t nr_threads_ = 1;
+  size_t io_queue_depth_ = 0; // 0: synchronous pread/pwrite
+  bool use_index_reader_ = true;
+  IndexAdvice index_advice_ = cas::IndexAdvice::Random;
+  size_t query_parallel_fanout_ = 0; // 0: sequential queries
+  NodeFormat node_format_ = cas::NodeFormat::Interleaved;
+  bool use_query_engine_ = false; // see QueryEngine, not yet faster than Query
+  bool subtree_stats_ = false; // key count, min/max value per inner node
+  PageFormat page_format_ = cas::PageFormat::Plain; // of partition pages
+  Compression partition_compression_ = cas::Compression::None; // of partition files
+  bool ref_dictionary_ = false; // leaves store ids into an index-wide ref dictionary
+  Compression leaf_compression_ = cas::Compression::None; // of large index leaves
+  size_t leaf_compression_threshold_ = 4096; // min. bytes of suffixes to compress
+  bool relative_pointers_ = false; // 1/2/4-byte child pointers relative to the node
+  bool varint_headers_ = false; // node format version 2 without length/count limits
+  bool parallel_partitioning_ = false; // the workers partition the root partition
+  size_t read_ahead_depth_ = 0; // pages a cursor reads ahead in the background
+  size_t write_behind_pages_ = 0; // pages buffered to coalesce partition writes
+  size_t page_size_ = cas::PAGE_SZ; // of memory pages and partition files
+  HugePages huge_pages_ = cas::HugePages::None; // backing of the memory pools
+  bool prefault_memory_ = false; // fault in the memory pools up front
+  bool numa_interleave_ = false; // spread the work pool over NUMA nodes if nr_threads_ > 1
 
   void Dump() {
     std::cout << "Context:";
@@ -55,6 +77,28 @@ struct Context {
     std::cout << "\nroot_dsc_P_: " << root_dsc_P_;
     std::cout << "\nroot_dsc_V_: " << root_dsc_V_;
     std::cout << "\ndelete_root_partition_: " << delete_root_partition_;
+    std::cout << "\nnr_threads_: " << nr_threads_;
+    std::cout << "\nio_queue_depth_: " << io_queue_depth_;
+    std::cout << "\nuse_index_reader_: " << use_index_reader_;
+    std::cout << "\nindex_advice_: " << ToString(index_advice_);
+    std::cout << "\nquery_parallel_fanout_: " << query_parallel_fanout_;
+    std::cout << "\nnode_format_: " << ToString(node_format_);
+    std::cout << "\nuse_query_engine_: " << use_query_engine_;
+    std::cout << "\nsubtree_stats_: " << subtree_stats_;
+    std::cout << "\npage_format_: " << ToString(page_format_);
+    std::cout << "\npartition_compression_: " << ToString(partition_compression_);
+    std::cout << "\nref_dictionary_: " << ref_dictionary_;
+    std::cout << "\nleaf_compression_: " << ToString(leaf_compression_);
+    std::cout << "\nleaf_compression_threshold_: " << leaf_compression_threshold_;
+    std::cout << "\nrelative_pointers_: " << relative_pointers_;
+    std::cout << "\nvarint_headers_: " << varint_headers_;
+    std::cout << "\nparallel_partitioning_: " << parallel_partitioning_;
+    std::cout << "\nread_ahead_depth_: " << read_ahead_depth_;
+    std::cout << "\nwrite_behind_pages_: " << write_behind_pages_;
+    std::cout << "\npage_size_: " << page_size_;
+    std::cout << "\nhuge_pages_: " << ToString(huge_pages_);
+    std::cout << "\nprefault_memory_: " << prefault_memory_;
+    std::cout << "\nnuma_interleave_: " << numa_interleave_;
     std::cout << "\n";
   }
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <map>
 
 namespace cas {
@@ -12,6 +13,8 @@ public:
     ++data_[value];
   }
 
+  void Merge(const Histogram& other);
+
   void Print(int nr_bins) const;
   void Print(int nr_bins, size_t upper_bound) const;
   void PrintStats() const;
@@ -2,10 +2,16 @@
 
 #include "cas/bulk_loader_stats.hpp"
 #include "cas/context.hpp"
+#include "cas/index_reader.hpp"
 #include "cas/mem/node.hpp"
 #include "cas/query.hpp"
+#include "cas/query_cursor.hpp"
 #include "cas/search_key.hpp"
+#include "cas/thread_pool.hpp"
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 
 namespace cas {
@@ -17,6 +23,9 @@ class Index {
   cas::BulkLoaderStats stats_;
   cas::mem::Node* root_ = nullptr;
   size_t nr_memory_keys_ = 0;
+  std::shared_ptr<const IndexReader> reader_;
+  std::mutex reader_mutex_;
+  ThreadPool* query_pool_ = nullptr;
 
 public:
 
@@ -25,10 +34,42 @@ public:
   { }
 
   void Insert(BinaryKey key);
+  // queries may run concurrently with each other, but not with
+  // Insert, BulkLoad, or FlushMemoryResidentKeys (see QueryService)
   QueryStats Query(const SearchKey<VType>& key, const BinaryKeyEmitter emitter);
   QueryStats Query(const BinarySK& key, const BinaryKeyEmitter emitter);
+  // counts the matches (QueryStats::nr_matches_) without emitting them;
+  // subtrees that match completely are counted from the statistics in
+  // their root (see Context::subtree_stats_) without being read
+  QueryStats Count(const SearchKey<VType>& key);
+  QueryStats Count(const BinarySK& key);
+  // emits at most limit matches in the given order; the limit is pushed
+  // into the traversal, with an order by value as TopKQuery
+  QueryStats Query(const SearchKey<VType>& key, const BinaryKeyEmitter emitter,
+      size_t limit, QueryOrder order = QueryOrder::Unordered);
+  QueryStats Query(const BinarySK& key, const BinaryKeyEmitter emitter,
+      size_t limit, QueryOrder order = QueryOrder::Unordered);
+  // returns a cursor that evaluates the query lazily while its matches
+  // are pulled (see QueryCursor); cursors always traverse the mapped
+  // index files of Reader() sequentially
+  QueryCursor Query(const SearchKey<VType>& key,
+      size_t limit = QueryCursor::kNoLimit);
+  QueryCursor Query(const BinarySK& key,
+      size_t limit = QueryCursor::kNoLimit);
+  // evaluates keys[i] with emitters[i] for all i with a single traversal
+  // of every index (see BatchQuery); returns the nodes read by the batch
+  // and, if query_stats is set, the stats of each query
+  QueryStats QueryBatch(const std::vector<BinarySK>& keys,
+      const std::vector<BinaryKeyEmitter>& emitters,
+      std::vector<QueryStats>* query_stats = nullptr);
   void BulkLoad();
 
+  // if set and Context::query_parallel_fanout_ > 0, queries
+  // evaluate broad subtrees as separate tasks on pool
+  void QueryPool(ThreadPool* pool) {
+    query_pool_ = pool;
+  }
+
   cas::BulkLoaderStats& Stats() {
     return stats_;
   }
@@ -39,6 +80,10 @@ public:
 
   void ClearPipelineFiles();
 
+  // returns the mapped disk-based indexes, they are
+  // remapped only if the pipeline directory changed
+  std::shared_ptr<const IndexReader> Reader();
+
 private:
   void HandleOverflow();
   void DeleteNodesRecursively(INode *node);
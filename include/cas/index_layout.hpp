@@ -0,0 +1,71 @@
+#pragma once
+
+#include "cas/ref.hpp"
+#include "cas/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace cas {
+
+
+// File-wide encoding of an index file that is not recorded in the
+// nodes. By default an index file only contains nodes. If the nodes
+// use a reference dictionary, compressed leaves, or varint headers, the
+// file ends with
+//   [dictionary: nr refs * sizeof(ref_t)]
+//   [trailer: offset of the dictionary (8 bytes), nr refs (8 bytes),
+//             flags (4 bytes), leaf compression (4 bytes), magic (8 bytes)]
+// and the nodes occupy the bytes before the dictionary.
+//
+// With a dictionary, every suffix stores a varint id into the
+// dictionary instead of its reference. With leaf compression, the
+// suffixes of every leaf are preceded by a marker byte:
+//   0: the suffixes follow uncompressed
+//   1: varint raw size, varint compressed size, compressed suffixes
+struct IndexLayout {
+  static constexpr size_t TRAILER_SZ = 32;
+  static constexpr uint64_t MAGIC = 0x3130'5844'4953'4143; // "CASIDX01"
+  static constexpr uint32_t FLAG_REF_IDS = 1;
+  static constexpr uint32_t FLAG_VARINT_HEADERS = 2;
+  static constexpr uint8_t LEAF_RAW = 0;
+  static constexpr uint8_t LEAF_COMPRESSED = 1;
+
+  // the nodes occupy the bytes [0, nodes_end_)
+  size_t nodes_end_ = 0;
+  bool ref_ids_ = false;
+  const uint8_t* refs_ = nullptr;
+  size_t nr_refs_ = 0;
+  Compression leaf_compression_ = Compression::None;
+  // the nodes use the varint header (see NodeReader), i.e., version 2
+  // of the node format
+  bool varint_headers_ = false;
+
+  bool HasTrailer() const {
+    return ref_ids_ || leaf_compression_ != Compression::None || varint_headers_;
+  }
+
+  inline ref_t Ref(size_t id) const {
+    ref_t ref;
+    std::memcpy(&ref, refs_ + id * sizeof(ref_t), sizeof(ref_t));
+    return ref;
+  }
+
+  // parses the trailer of the index file data[0, size), if any
+  static IndexLayout Read(const uint8_t* data, size_t size);
+
+  // serializes the trailer of a file whose dictionary starts at
+  // nodes_end_ into dst (TRAILER_SZ bytes)
+  void WriteTrailer(uint8_t* dst) const;
+};
+
+
+// decompresses the suffixes of a leaf, data points to its marker
+// (LEAF_COMPRESSED)
+void DecompressLeaf(Compression compression, const uint8_t* data,
+    std::vector<uint8_t>& suffixes);
+
+
+} // namespace cas
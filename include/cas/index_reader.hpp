@@ -0,0 +1,81 @@
+#pragma once
+
+#include "cas/index_layout.hpp"
+#include "cas/node_reader.hpp"
+#include "cas/query.hpp"
+#include "cas/query_engine.hpp"
+#include "cas/query_stats.hpp"
+#include "cas/thread_pool.hpp"
+#include "cas/types.hpp"
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace cas {
+
+
+// Maps every index file of a pipeline directory once and keeps the
+// mappings for its entire lifetime. After construction the reader is
+// read-only and can be queried concurrently from multiple threads.
+// If the directory changes (IsStale), a new reader needs to be created.
+class IndexReader {
+  struct File {
+    std::string filename_;
+    uint8_t* data_;
+    size_t size_;
+    IndexLayout layout_;
+  };
+
+  const std::string pipeline_dir_;
+  std::vector<File> files_;
+  struct timespec dir_mtime_{0, 0};
+  bool dir_exists_ = false;
+
+public:
+  explicit IndexReader(const std::string& pipeline_dir,
+      IndexAdvice advice = IndexAdvice::Random);
+  ~IndexReader();
+
+  /* delete copy/move constructors/assignments */
+  IndexReader(const IndexReader& other) = delete;
+  IndexReader(IndexReader&& other) = delete;
+  IndexReader& operator=(const IndexReader& other) = delete;
+  IndexReader& operator=(IndexReader&& other) = delete;
+
+  // with a pool, broad queries are split into tasks (see Query::Parallelize)
+  QueryStats Execute(const BinarySK& key, const BinaryKeyEmitter& emitter,
+      ThreadPool* pool = nullptr, size_t min_fanout = 0) const;
+
+  // like Execute, but evaluates the query with a QueryEngine that is
+  // specialized for NodeReader and Emitter
+  template<class Emitter>
+  QueryStats ExecuteInlined(const BinarySK& key, Emitter& emitter) const {
+    std::vector<cas::QueryStats> stats;
+    stats.reserve(files_.size());
+    for (const auto& file : files_) {
+      cas::NodeReader root{file.data_, 0, &file.layout_};
+      cas::QueryEngine<cas::NodeReader, Emitter> query{&root, key, emitter};
+      query.Execute();
+      stats.push_back(query.Stats());
+    }
+    return cas::QueryStats::Sum(stats);
+  }
+
+  // counts the matches without emitting them (see QueryEngine::CountOnly)
+  QueryStats Count(const BinarySK& key) const;
+
+  // true if files were added to, or removed from, the pipeline directory
+  bool IsStale() const;
+
+  size_t NrFiles() const { return files_.size(); }
+  NodeReader Root(size_t i) const {
+    return NodeReader{files_[i].data_, 0, &files_[i].layout_};
+  }
+  const std::string& PipelineDir() const { return pipeline_dir_; }
+
+private:
+  void Map(const std::string& filename, IndexAdvice advice);
+};
+
+
+} // namespace cas
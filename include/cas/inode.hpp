@@ -3,6 +3,7 @@
 #include "cas/dimension.hpp"
 #include "cas/types.hpp"
 #include <functional>
+#include <memory>
 
 
 namespace cas {
@@ -41,6 +42,33 @@ public:
 
   virtual void ForEachChild(const ChildCallback& callback) const = 0;
   virtual void ForEachSuffix(const SuffixCallback& callback) const = 0;
+
+  // visits only the children whose byte is in [low, high]
+  virtual void ForEachChildInRange(uint8_t low, uint8_t high,
+      const ChildCallback& callback) const {
+    ForEachChild([&](uint8_t byte, INode* child) {
+      if (low <= byte && byte <= high) {
+        callback(byte, child);
+      }
+    });
+  }
+
+  // visits the child with the given byte, returns false if there is none
+  virtual bool LookupChild(uint8_t byte, const ChildCallback& callback) const {
+    bool found = false;
+    ForEachChildInRange(byte, byte, [&](uint8_t b, INode* child) {
+      found = true;
+      callback(b, child);
+    });
+    return found;
+  }
+
+  // children passed to a ChildCallback may only be valid during the
+  // callback; Detach returns a copy that outlives it, or a nullptr if
+  // the node itself is long-lived (e.g., in-memory nodes)
+  virtual std::unique_ptr<INode> Detach() const {
+    return nullptr;
+  }
 };
 
 
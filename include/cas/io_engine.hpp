@@ -0,0 +1,143 @@
+#pragma once
+
+#include "cas/bulk_loader_stats.hpp"
+#include "cas/memory_page.hpp"
+#include "cas/types.hpp"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/uio.h>
+
+namespace cas {
+
+
+// Asynchronous page I/O for partition files based on io_uring.
+//
+// Reads: a single read-ahead stream keeps up to queue_depth reads of
+// consecutive pages in flight ahead of the consumer. The window starts
+// with one page and doubles with every page that is consumed in order.
+//
+// Writes: pages are copied into a free slot and submitted in batches.
+// The caller can reuse its page immediately. Flush(fd) waits until the
+// writes of fd are durable in the page cache (or on disk with O_DIRECT).
+//
+// If io_uring is not available, IsAsync() returns false and the caller
+// needs to fall back to pread/pwrite.
+//
+// Write-behind: if io_uring is not used and write_behind_pages > 0,
+// WritePage() copies pages into a buffer of write_behind_pages pages
+// instead. If the buffer is full, the pending pages of the file with
+// the most pending pages are sorted and written with one pwritev per
+// run of consecutive pages. Files are preallocated in growing extents
+// ahead of the written pages (see Preallocate()).
+class IoEngine {
+  enum class SlotState : uint8_t {
+    FREE,
+    READING,    // read submitted, owned by the read-ahead stream
+    READ,       // read completed, owned by the read-ahead stream
+    DISCARDED,  // read submitted, dropped from the read-ahead stream
+    WRITING,
+  };
+
+  struct Slot {
+    std::byte* buffer_ = nullptr;
+    SlotState state_ = SlotState::FREE;
+    int fd_ = -1;
+    size_t page_nr_ = 0;
+    int result_ = 0;
+  };
+
+  struct FileWrites {
+    size_t nr_pending_ = 0;
+    size_t nr_failed_ = 0;
+  };
+
+  struct Ring;
+
+  BulkLoaderStats& stats_;
+  const size_t queue_depth_;
+  const size_t page_size_;
+  std::unique_ptr<Ring> ring_;
+  std::byte* buffers_ = nullptr;
+  std::vector<Slot> slots_; // [0,queue_depth) reads, [queue_depth,2*queue_depth) writes
+  size_t nr_unsubmitted_ = 0;
+  size_t nr_unsubmitted_writes_ = 0;
+  size_t nr_in_flight_ = 0;
+  std::unordered_map<int, FileWrites> writes_; // files with pending or failed writes
+  /* read-ahead stream */
+  std::deque<size_t> stream_;
+  int stream_fd_ = -1;
+  size_t stream_next_page_nr_ = 0;
+  size_t stream_last_page_nr_ = 0;
+  size_t stream_window_ = 0;
+  /* write-behind buffer */
+  struct File {
+    std::vector<std::pair<size_t, size_t>> pages_; // (page_nr, buffer)
+    size_t reserved_pages_ = 0; // preallocated with fallocate
+  };
+  const size_t write_behind_pages_;
+  std::byte* write_buffers_ = nullptr;
+  std::vector<size_t> free_write_buffers_;
+  std::unordered_map<int, File> files_;
+
+public:
+  IoEngine(size_t queue_depth, BulkLoaderStats& stats,
+      size_t write_behind_pages = 0, size_t page_size = PAGE_SZ);
+  ~IoEngine();
+
+  /* delete copy/move constructors/assignments */
+  IoEngine(const IoEngine& other) = delete;
+  IoEngine(IoEngine&& other) = delete;
+  IoEngine& operator=(const IoEngine& other) = delete;
+  IoEngine& operator=(IoEngine&& other) = delete;
+
+  bool IsAsync() const { return ring_ != nullptr; }
+  // pages are written with WritePage() and Flush(), either
+  // asynchronously or by the write-behind buffer
+  bool BuffersWrites() const {
+    return IsAsync() || write_buffers_ != nullptr;
+  }
+  size_t QueueDepth() const { return queue_depth_; }
+
+  // reads page page_nr of fd into page and schedules the reads of the
+  // following pages up to (excluding) last_page_nr; returns the number
+  // of bytes read (like pread)
+  int ReadPage(int fd, MemoryPage& page, size_t page_nr, size_t last_page_nr);
+
+  // copies page and schedules writing it to page page_nr of fd; returns
+  // the page size or -1 if a previously scheduled write of fd failed
+  // (like pwrite)
+  int WritePage(int fd, const MemoryPage& page, size_t page_nr);
+
+  // waits for the scheduled writes of fd and drops the read-ahead of fd
+  // that might have overtaken them, returns immediately if fd has no
+  // scheduled writes; returns false if a write of fd failed
+  bool Flush(int fd);
+
+  // whether fd has buffered, scheduled, or failed writes, i.e., whether
+  // Flush(fd) has anything to do
+  bool HasPendingWrites(int fd) const;
+
+  // flushes fd and drops its read-ahead and write-behind state, needs to
+  // be called before fd is closed; returns false if a write of fd failed
+  bool Close(int fd);
+
+  // reserves disk space for the first nr_pages pages of fd without
+  // changing its size; failures are ignored since the pages are then
+  // allocated when they are written
+  void Preallocate(int fd, size_t nr_pages);
+
+private:
+  int BufferPage(int fd, const MemoryPage& page, size_t page_nr);
+  bool WriteBack(int fd, File& file);
+  bool WriteRun(int fd, iovec* iov, int iovcnt, size_t page_nr);
+  void Prepare(size_t slot, uint8_t opcode);
+  void Enter(size_t min_complete);
+  void Reap();
+  void FillStream();
+  void CancelStream();
+};
+
+
+} // namespace cas
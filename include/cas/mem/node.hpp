@@ -53,6 +53,16 @@ public:
   virtual Node* Grow() = 0;
   virtual void ReplaceBytePointer(uint8_t key_byte, Node* child) = 0;
 
+  bool LookupChild(uint8_t key_byte,
+      const cas::INode::ChildCallback& callback) const override {
+    Node* child = nr_children_ == 0 ? nullptr : LocateChild(key_byte);
+    if (child == nullptr) {
+      return false;
+    }
+    callback(key_byte, child);
+    return true;
+  }
+
   virtual void ForEachSuffix(const RefCallback&) const {
     // NO-OP
   }
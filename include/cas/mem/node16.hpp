@@ -23,7 +23,11 @@ public:
 
   // traversing
   Node* LocateChild(uint8_t key_byte) const override;
+  // position of the first key that is not less than key_byte
+  int LowerBound(uint8_t key_byte) const;
   void ForEachChild(const ChildCallback& callback) const override;
+  void ForEachChildInRange(uint8_t low, uint8_t high,
+      const ChildCallback& callback) const override;
 
   // updating
   void Put(uint8_t key_byte, Node* child) override;
@@ -26,6 +26,8 @@ public:
   // traversing
   Node* LocateChild(uint8_t key_byte) const override;
   void ForEachChild(const ChildCallback& callback) const override;
+  void ForEachChildInRange(uint8_t low, uint8_t high,
+      const ChildCallback& callback) const override;
 
   // updating
   void Put(uint8_t key_byte, Node* child) override;
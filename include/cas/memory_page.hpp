@@ -1,9 +1,10 @@
 #pragma once
 
 #include "cas/binary_key.hpp"
-#include <array>
+#include "cas/types.hpp"
 #include <iostream>
 #include <memory>
+#include <vector>
 
 
 namespace cas {
@@ -16,19 +17,37 @@ enum class MemoryPageType : uint8_t {
 };
 
 
+// A page stores its number of keys followed by the keys. In the
+// FrontCoded format every key only stores the bytes of its path and
+// value that are not shared with the previous key in the page:
+//   varint shared_p, varint suffix_p, varint shared_v, varint suffix_v,
+//   ref, path[shared_p:], value[shared_v:]
+// The format is recorded in the page itself (highest bit of the key
+// count), plain pages are unchanged. Pages are PAGE_SZ bytes large
+// unless another size is given (see Context::page_size_).
 class MemoryPage {
 private:
   static const size_t OFFSET_NR_KEYS = 0;
   static const size_t OFFSET_DATA = OFFSET_NR_KEYS + sizeof(uint16_t);
+  static const uint16_t FLAG_FRONT_CODED = 1u << 15;
+  // the key count has 15 bits, large pages might hold more keys
+  static const uint16_t MAX_NR_KEYS = FLAG_FRONT_CODED - 1;
 
   std::byte* data_;
+  size_t size_;
   size_t tail_pos_ = OFFSET_DATA;
   MemoryPageType type_ = MemoryPageType::WORK;
+  /* last key pushed to a front-coded page */
+  std::vector<std::byte> last_path_;
+  std::vector<std::byte> last_value_;
 
 public:
-  MemoryPage(std::byte* data) : data_(data) {
+  MemoryPage(std::byte* data, size_t size = PAGE_SZ)
+    : data_(data)
+    , size_(size)
+  {
     if (data != nullptr) {
-      NrKeys() = 0;
+      Header() = 0;
     }
   }
 
@@ -40,36 +59,64 @@ public:
   MemoryPage& operator=(MemoryPage&& other) = default;
 
   void Push(const BinaryKey& key);
+  // true if key can still be pushed to this page
+  bool Fits(const BinaryKey& key) const {
+    return NrKeys() < MAX_NR_KEYS && EncodedSize(key) <= FreeSpace();
+  }
+  // number of bytes key occupies when pushed to this page
+  size_t EncodedSize(const BinaryKey& key) const;
 
-  uint16_t& NrKeys() const {
-    return *reinterpret_cast<uint16_t*>(data_ + OFFSET_NR_KEYS);
+  uint16_t NrKeys() const {
+    return Header() & ~FLAG_FRONT_CODED;
+  }
+  PageFormat Format() const {
+    return (Header() & FLAG_FRONT_CODED) != 0
+      ? PageFormat::FrontCoded
+      : PageFormat::Plain;
   }
 
   std::byte* Data() { return data_; }
   const std::byte* Data() const { return data_; }
-  inline size_t Size() const { return PAGE_SZ; }
-  inline size_t FreeSpace() const { return PAGE_SZ - tail_pos_; }
+  inline size_t Size() const { return size_; }
+  inline size_t FreeSpace() const { return size_ - tail_pos_; }
+  // bytes occupied by the header and the keys added with Push()
+  inline size_t UsedSpace() const { return tail_pos_; }
   MemoryPageType Type() const { return type_; }
   void Type(MemoryPageType type) { type_ = type; }
 
   bool IsNull() { return data_ == nullptr; }
 
+  // empties the page, but keeps its format
   void Reset() {
-    NrKeys() = 0;
+    Reset(Format());
+  }
+
+  void Reset(PageFormat format) {
+    Header() = format == PageFormat::FrontCoded ? FLAG_FRONT_CODED : 0;
     tail_pos_ = OFFSET_DATA;
+    last_path_.clear();
+    last_value_.clear();
   }
 
   void Dump();
 
   /* iterator implementation */
   class iterator;
-  iterator begin() { return iterator(data_ + OFFSET_DATA, 0); }
+  iterator begin() {
+    return iterator(data_ + OFFSET_DATA, 0, NrKeys(), Format(), size_);
+  }
   iterator end() { return iterator(data_ + OFFSET_DATA, NrKeys()); }
 
+  // Keys of front-coded pages are decoded into a buffer that is
+  // shared by all copies of the iterator, i.e., a key is only
+  // valid until the iterator is incremented.
   class iterator {
+    struct Buffer;
     cas::BinaryKey key_;
     std::byte* data_;
     uint16_t key_nr_;
+    uint16_t nr_keys_ = 0;
+    Buffer* buffer_ = nullptr;
 
   public:
     using iterator_category = std::forward_iterator_tag;
@@ -83,18 +130,56 @@ public:
       , data_(data)
       , key_nr_(key_nr)
     { }
-    iterator operator++() {
-      iterator i = *this;
+    iterator(std::byte* data, uint16_t key_nr, uint16_t nr_keys,
+        PageFormat format, size_t page_size)
+      : key_(data)
+      , data_(data)
+      , key_nr_(key_nr)
+      , nr_keys_(nr_keys)
+    {
+      if (format == PageFormat::FrontCoded) {
+        // decoded keys are not longer than the page
+        buffer_ = Acquire(page_size);
+        key_ = BinaryKey(BufferData(buffer_));
+        key_.LenPath(0);
+        key_.LenValue(0);
+        if (key_nr_ < nr_keys_) {
+          Decode();
+        }
+      }
+    }
+    iterator(const iterator& other);
+    iterator& operator=(const iterator& other);
+    ~iterator();
+
+    iterator& operator++() {
       ++key_nr_;
-      data_ += key_.ByteSize();
-      key_ = BinaryKey(data_);
-      return i;
+      if (buffer_ == nullptr) {
+        data_ += key_.ByteSize();
+        key_ = BinaryKey(data_);
+      } else if (key_nr_ < nr_keys_) {
+        Decode();
+      }
+      return *this;
     }
     pointer operator->()  { return &key_; }
     reference operator*() { return key_; }
     bool operator==(const iterator& rhs) { return key_nr_ == rhs.key_nr_; }
     bool operator!=(const iterator& rhs) { return key_nr_ != rhs.key_nr_; }
+
+  private:
+    // decodes the front-coded key at data_ into buffer_
+    void Decode();
+    static std::vector<std::unique_ptr<Buffer>>& FreeBuffers();
+    static Buffer* Acquire(size_t size);
+    static void Release(Buffer* buffer);
+    static std::byte* BufferData(Buffer* buffer);
   };
+
+private:
+  uint16_t& Header() const {
+    return *reinterpret_cast<uint16_t*>(data_ + OFFSET_NR_KEYS);
+  }
 };
 
 
@@ -8,14 +8,39 @@
 
 namespace cas {
 
+// how the memory of a pool is obtained from the OS. Requests that the
+// OS cannot satisfy are downgraded: explicit huge pages fall back to
+// transparent ones, those to base pages, and NUMA interleaving is
+// dropped on single-node machines. A pool records what it got.
+struct MemoryBacking {
+  HugePages huge_pages_ = HugePages::None;
+  // touch every page at construction instead of on first use
+  bool prefault_ = false;
+  // interleave the pages across all NUMA nodes (MPOL_INTERLEAVE) such
+  // that threads on every socket see the same share of local memory
+  bool numa_interleave_ = false;
+  // threads that touch the pages if prefault_ is set
+  size_t nr_threads_ = 1;
+};
+
+
 class MemoryPool {
   const size_t max_pages_;
   const MemoryPageType type_;
+  const size_t page_size_;
   std::vector<MemoryPage> pages_;
   std::byte* address_;
+  /* bytes mapped at address_, rounded up to huge pages if explicit */
+  size_t mapped_size_ = 0;
+  MemoryBacking backing_;
+  /* pool from which the pages were borrowed (if any) */
+  MemoryPool* source_ = nullptr;
 
 public:
-  MemoryPool(size_t max_pages, MemoryPageType type);
+  MemoryPool(size_t max_pages, MemoryPageType type,
+      size_t page_size = PAGE_SZ, const MemoryBacking& backing = {});
+  MemoryPool(MemoryPool& source, size_t nr_pages, size_t max_pages,
+      MemoryPageType type);
   ~MemoryPool();
 
   /* delete copy/move constructor/assignment */
@@ -24,16 +49,28 @@ public:
   MemoryPool& operator=(const MemoryPool& other) = delete;
   MemoryPool& operator=(MemoryPool&& other) = delete;
 
-  MemoryPage Get();
+  // hands out an empty page of the given format
+  MemoryPage Get(PageFormat format = PageFormat::Plain);
   void Release(MemoryPage&& page);
+  void Borrow(size_t nr_pages);
 
   size_t NrFreePages() { return pages_.size(); }
   size_t NrUsedPages() { return max_pages_ - pages_.size(); }
   bool HasFreePage() { return pages_.size() > 0; }
   size_t Capacity() { return max_pages_; }
+  size_t PageSize() const { return page_size_; }
   bool Full() { return pages_.size() == max_pages_; }
+  // the backing of the pages, borrowed pages have that of their source
+  const MemoryBacking& Backing() const {
+    return source_ != nullptr ? source_->Backing() : backing_;
+  }
 
   void FillWithZeros();
+
+private:
+  void Map(const MemoryBacking& backing);
+  void InterleaveNumaNodes();
+  void Prefault(size_t nr_threads);
 };
 
 
@@ -43,18 +80,29 @@ private:
       size_t input_sz,
       size_t output_sz,
       size_t work_sz,
-      size_t cache_killer_sz
+      size_t cache_killer_sz,
+      size_t page_size,
+      const MemoryBacking& backing,
+      const MemoryBacking& work_backing
   )
-    : input_(input_sz, MemoryPageType::INPUT)
-    , output_(output_sz, MemoryPageType::OUTPUT)
-    , work_(work_sz, MemoryPageType::WORK)
-    , cache_killer_(cache_killer_sz, MemoryPageType::CACHE_KILLER)
+    : input_(input_sz, MemoryPageType::INPUT, page_size, backing)
+    , output_(output_sz, MemoryPageType::OUTPUT, page_size, backing)
+    , work_(work_sz, MemoryPageType::WORK, page_size, work_backing)
+    , cache_killer_(cache_killer_sz, MemoryPageType::CACHE_KILLER, page_size)
   {
     // make sure that the cache_killer_ pages are actually
     // allocated by the OS
     cache_killer_.FillWithZeros();
   }
 
+  /* slice of another set of pools, see Slice() */
+  MemoryPools(MemoryPool& source, size_t input_sz)
+    : input_(source, input_sz, input_sz, MemoryPageType::INPUT)
+    , output_(source, cas::BYTE_MAX, cas::BYTE_MAX, MemoryPageType::OUTPUT)
+    , work_(source, 0, source.Capacity(), MemoryPageType::WORK)
+    , cache_killer_(0, MemoryPageType::CACHE_KILLER, source.PageSize())
+  { }
+
   /* delete copy/move constructor/assignment */
   MemoryPools(const MemoryPools& other) = delete;
   MemoryPools(MemoryPools&& other) = delete;
@@ -67,9 +115,28 @@ public:
   MemoryPool work_;
   MemoryPool cache_killer_;
 
+  // the input pool has 1 + read_ahead_depth pages, the additional
+  // pages are borrowed by cursors to read ahead (see Partition::Cursor);
+  // all pools consist of pages of page_size bytes. Only the work pool,
+  // whose pages are shared by the workers, is interleaved across NUMA
+  // nodes.
   static MemoryPools Construct(
       size_t max_memory,
-      size_t memory_capacity = 0);
+      size_t memory_capacity = 0,
+      size_t read_ahead_depth = 0,
+      size_t page_size = PAGE_SZ,
+      const MemoryBacking& backing = {});
+
+  // carves 1 + read_ahead_depth input pages and BYTE_MAX output pages
+  // out of the work pool of pools. The work pool of the slice is
+  // initially empty and can borrow more pages with work_.Borrow(). All
+  // pages are returned to pools.work_ when the slice is destroyed.
+  static MemoryPools Slice(MemoryPools& pools, size_t read_ahead_depth = 0);
+
+  // number of work pages needed to create a Slice()
+  static constexpr size_t SliceSize(size_t read_ahead_depth = 0) {
+    return 1 + read_ahead_depth + cas::BYTE_MAX;
+  }
 
   void Dump();
 };
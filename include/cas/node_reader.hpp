@@ -1,37 +1,82 @@
 #pragma once
 
 #include "cas/dimension.hpp"
+#include "cas/index_layout.hpp"
 #include "cas/inode.hpp"
 #include "cas/types.hpp"
 #include "cas/util.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <stdexcept>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 namespace cas {
 
 
-class NodeReader : public INode {
+class NodeReader final : public INode {
   // 32-bit header: [dimension: 2 bits, len path: 12 bits, len value: 2 bits, m: 14 bits]
   static constexpr uint32_t k_mask_d  = 0b11'000000000000'0000'00000000000000;
   static constexpr uint32_t k_mask_lp = 0b00'111111111111'0000'00000000000000;
   static constexpr uint32_t k_mask_lv = 0b00'000000000000'1111'00000000000000;
   static constexpr uint32_t k_mask_m  = 0b00'000000000000'0000'11111111111111;
-  // beginning of payload
+  // inner nodes have at most 256 children, the highest bit of m is used
+  // as format flag: 0 => interleaved (b:1, ptr:6) records, 1 => an array
+  // of all bytes followed by an array of all pointers (NodeFormat::KeyArray)
+  static constexpr uint32_t k_flag_key_array = 0b00'000000000000'0000'10000000000000;
+  // the next bit flags an extended header with statistics of the subtree
+  // that follows the 32-bit header: [nr keys: 6 bytes, len: 1 byte,
+  // min value: len bytes, max value: len bytes]
+  static constexpr uint32_t k_flag_subtree_stats = 0b00'000000000000'0000'01000000000000;
+  // the next two bits encode the width of the child pointers: 0 => absolute
+  // 6-byte offsets, 1/2/3 => 1/2/4-byte offsets relative to the node
+  static constexpr uint32_t k_mask_pointer_width = 0b00'000000000000'0000'00110000000000;
+  static constexpr uint32_t k_mask_children      = 0b00'000000000000'0000'00001111111111;
+  static constexpr int k_shift_pointer_width = 10;
+  static constexpr uint32_t k_mask_flags =
+    k_flag_key_array | k_flag_subtree_stats | k_mask_pointer_width;
+  // beginning of the extended header or payload
   static constexpr int POS_P = 4;
+  // Files with varint headers (IndexLayout::varint_headers_) lift the
+  // limits of the lengths and counts. Their header is
+  //   [flags: 1 byte, len path: varint, len value: varint, m: varint]
+  // where the flags byte holds the dimension and the flags of the
+  // 32-bit header (see VarintHeaderFlags). The length of the subtree
+  // values and the lengths of the suffixes are varints as well.
 
   const uint8_t* head_;
   const uint8_t* buffer_;
+  // encoding of the nodes (see IndexLayout), nullptr for files
+  // without trailer
+  const IndexLayout* layout_;
+  // suffixes of a compressed leaf, decompressed on first access and
+  // shared by the copies of this reader
+  mutable std::shared_ptr<std::vector<uint8_t>> suffixes_;
+  // dimension and flags in the bits of the 32-bit header, the
+  // lengths and counts are decoded once into the fields below
   uint32_t header_;
+  uint32_t nr_entries_;
+  uint16_t len_path_;
+  uint16_t len_value_;
+  uint16_t len_subtree_values_ = 0;
+  uint8_t header_size_;
+  uint32_t payload_pos_;
 
 public:
-  NodeReader(const uint8_t* head, size_t pos)
+  NodeReader(const uint8_t* head, size_t pos,
+      const IndexLayout* layout = nullptr)
     : head_{head}
     , buffer_{head + pos}
+    , layout_{layout}
   {
-    std::memcpy(&header_, buffer_, 4);
+    if (HasVarintHeader()) {
+      DecodeVarintHeader();
+    } else {
+      DecodeHeader();
+    }
   }
 
   inline cas::Dimension Dimension() const override {
@@ -40,15 +85,87 @@ public:
   }
 
   inline size_t LenPath() const override {
-    return (k_mask_lp & header_) >> 18;
+    return len_path_;
   }
 
   inline size_t LenValue() const override {
-    return (k_mask_lv & header_) >> 14;
+    return len_value_;
   }
 
   inline size_t NrEntries() const {
-    return k_mask_m & header_;
+    return nr_entries_;
+  }
+
+  inline bool HasKeyArray() const {
+    return Dimension() != cas::Dimension::LEAF && (k_flag_key_array & header_) != 0;
+  }
+
+  // header flag of an inner node serialized with the given format
+  static constexpr uint32_t FormatFlag(NodeFormat format) {
+    return format == NodeFormat::KeyArray ? k_flag_key_array : 0;
+  }
+
+  static constexpr uint32_t SubtreeStatsFlag() {
+    return k_flag_subtree_stats;
+  }
+
+  // flags byte of the varint header of a node whose 32-bit header only
+  // holds the dimension and flags (bits 6-7: dimension, bits 2-5: flags),
+  // the lengths and m would overlap with them
+  static constexpr uint8_t VarintHeaderFlags(uint32_t header) {
+    return static_cast<uint8_t>(
+        ((header & k_mask_d) >> 24) | ((header & k_mask_flags) >> 8));
+  }
+
+  // header bits of an inner node whose child pointers have the given
+  // width (1, 2, 4: relative, 6: absolute)
+  static constexpr uint32_t PointerWidthFlag(int width) {
+    uint32_t code = width == 1 ? 1 : width == 2 ? 2 : width == 4 ? 3 : 0;
+    return code << k_shift_pointer_width;
+  }
+
+  // number of bytes per child pointer
+  inline size_t PointerWidth() const {
+    constexpr uint8_t widths[] = {6, 1, 2, 4};
+    return widths[(k_mask_pointer_width & header_) >> k_shift_pointer_width];
+  }
+
+  // child pointers are relative to the node (instead of the file)
+  inline bool HasRelativePointers() const {
+    return (k_mask_pointer_width & header_) != 0;
+  }
+
+  inline bool HasSubtreeStats() const {
+    return Dimension() != cas::Dimension::LEAF && (k_flag_subtree_stats & header_) != 0;
+  }
+
+  // number of keys in the subtree (requires HasSubtreeStats)
+  inline size_t SubtreeKeys() const {
+    size_t nr_keys = 0;
+    for (int i = 0; i < 6; ++i) {
+      nr_keys = (nr_keys << 8) | buffer_[header_size_ + i];
+    }
+    return nr_keys;
+  }
+
+  // length of the smallest and largest value in the subtree
+  inline size_t LenSubtreeValues() const {
+    return len_subtree_values_;
+  }
+
+  // smallest and largest value in the subtree, without the value
+  // prefixes of the node and its ancestors
+  inline const uint8_t* MinSubtreeValue() const {
+    return &buffer_[payload_pos_ - 2 * len_subtree_values_];
+  }
+
+  inline const uint8_t* MaxSubtreeValue() const {
+    return &buffer_[payload_pos_ - len_subtree_values_];
+  }
+
+  // position of the prefixes relative to the node
+  inline size_t PayloadPos() const {
+    return payload_pos_;
   }
 
   inline size_t NrChildren() const override {
@@ -64,45 +181,203 @@ public:
   }
 
   inline const uint8_t* Path() const override {
-    return &buffer_[POS_P];
+    return &buffer_[PayloadPos()];
   }
 
   inline const uint8_t* Value() const override {
-    return &buffer_[POS_P + LenPath()];
+    return &buffer_[PayloadPos() + LenPath()];
   }
 
-  void ForEachChild(const INode::ChildCallback& callback) const override {
-    size_t offset = POS_P + LenPath() + LenValue();
-    for (uint16_t i = 0, sz = NrChildren(); i < sz; ++i) {
-      uint8_t b = buffer_[offset++];
-      size_t ptr = 0;
-      ptr |= (static_cast<size_t>(buffer_[offset++]) << 40);
-      ptr |= (static_cast<size_t>(buffer_[offset++]) << 32);
-      ptr |= (static_cast<size_t>(buffer_[offset++]) << 24);
-      ptr |= (static_cast<size_t>(buffer_[offset++]) << 16);
-      ptr |= (static_cast<size_t>(buffer_[offset++]) <<  8);
-      ptr |= (static_cast<size_t>(buffer_[offset++]) <<  0);
-      NodeReader node{head_, ptr};
-      callback(b, &node);
+  // number of bytes occupied by the serialized node
+  size_t ByteSize() const {
+    size_t offset = PayloadPos() + LenPath() + LenValue();
+    if (!IsLeaf()) {
+      // per child => b:1, ptr: 1-6
+      return offset + (1 + PointerWidth()) * NrChildren();
     }
+    if (HasLeafMarker()) {
+      if (buffer_[offset] == IndexLayout::LEAF_COMPRESSED) {
+        size_t raw_size;
+        size_t compressed_size;
+        const uint8_t* src = &buffer_[offset + 1];
+        src = cas::util::ReadVarint(src, raw_size);
+        src = cas::util::ReadVarint(src, compressed_size);
+        return (src - buffer_) + compressed_size;
+      }
+      ++offset;
+    }
+    for (size_t i = 0, sz = NrSuffixes(); i < sz; ++i) {
+      size_t len_p;
+      size_t len_v;
+      offset = ReadSuffixSizes(buffer_, offset, len_p, len_v);
+      offset += len_p + len_v;
+      if (HasRefIds()) {
+        size_t id;
+        offset = cas::util::ReadVarint(&buffer_[offset], id) - buffer_;
+      } else {
+        offset += sizeof(cas::ref_t);
+      }
+    }
+    return offset;
   }
 
-  void ForEachSuffix(const INode::SuffixCallback& callback) const override {
-    size_t offset = POS_P + LenPath() + LenValue();
-    for (uint16_t i = 0, sz = NrSuffixes(); i < sz; ++i) {
-      uint16_t len_data = 0;
-      len_data |= static_cast<uint16_t>(buffer_[offset++] << 8);
-      len_data |= static_cast<uint16_t>(buffer_[offset++] << 0);
-      auto [len_p, len_v] = cas::util::DecodeSizes(len_data);
-      const uint8_t* path  = &buffer_[offset];
-      offset += len_p;
-      const uint8_t* value = &buffer_[offset];
-      offset += len_v;
-      cas::ref_t ref;
-      std::memcpy(&ref, &buffer_[offset], sizeof(cas::ref_t));
+  // true if the leaf's suffixes are compressed
+  inline bool IsCompressed() const {
+    return HasLeafMarker() && IsLeaf() &&
+      buffer_[PayloadPos() + LenPath() + LenValue()] == IndexLayout::LEAF_COMPRESSED;
+  }
+
+  // position of the i-th child's byte relative to the node
+  inline size_t ChildBytePos(size_t i) const {
+    size_t offset = PayloadPos() + LenPath() + LenValue();
+    return HasKeyArray() ? offset + i : offset + (1 + PointerWidth()) * i;
+  }
+
+  // position of the i-th child's pointer relative to the node
+  inline size_t ChildPointerPos(size_t i) const {
+    size_t offset = PayloadPos() + LenPath() + LenValue();
+    size_t width = PointerWidth();
+    return HasKeyArray()
+      ? offset + NrChildren() + width * i
+      : offset + (1 + width) * i + 1;
+  }
+
+  // the children are sorted by their bytes, i.e., with a key array we
+  // can binary search for the first child and only touch the pointers
+  // we follow
+
+  // index of the first child whose byte is not less than byte
+  inline size_t LowerBound(uint8_t byte) const {
+    size_t sz = NrChildren();
+    if (HasKeyArray()) {
+      const uint8_t* keys = &buffer_[ChildBytePos(0)];
+      return std::lower_bound(keys, keys + sz, byte) - keys;
+    }
+    size_t i = 0;
+    while (i < sz && buffer_[ChildBytePos(i)] < byte) {
+      ++i;
+    }
+    return i;
+  }
+
+  inline uint8_t ChildByte(size_t i) const {
+    return buffer_[ChildBytePos(i)];
+  }
+
+  inline NodeReader Child(size_t i) const {
+    return NodeReader{head_, ReadPointer(ChildPointerPos(i)), layout_};
+  }
+
+  // position of the first suffix relative to Suffixes(), i.e., relative
+  // to the node unless its suffixes are compressed
+  inline size_t FirstSuffixPos() const {
+    size_t offset = PayloadPos() + LenPath() + LenValue();
+    if (!HasLeafMarker() || !IsLeaf()) {
+      return offset;
+    }
+    return buffer_[offset] == IndexLayout::LEAF_COMPRESSED ? 0 : offset + 1;
+  }
+
+  // the buffer the suffix offsets refer to
+  inline const uint8_t* Suffixes() const {
+    if (!HasLeafMarker()) {
+      return buffer_;
+    }
+    if (suffixes_ == nullptr && IsCompressed()) {
+      suffixes_ = std::make_shared<std::vector<uint8_t>>();
+      cas::DecompressLeaf(layout_->leaf_compression_,
+          &buffer_[PayloadPos() + LenPath() + LenValue()], *suffixes_);
+    }
+    return suffixes_ == nullptr ? buffer_ : suffixes_->data();
+  }
+
+  // the Visit* functions take any callable fn, i.e., they can be
+  // inlined into the caller; the INode interface wraps them for
+  // std::function callbacks
+
+  // visits the children with low <= byte <= high as fn(byte, child)
+  template<class Fn>
+  void VisitChildrenInRange(uint8_t low, uint8_t high, Fn&& fn) const {
+    for (size_t i = LowerBound(low), sz = NrChildren(); i < sz; ++i) {
+      uint8_t byte = ChildByte(i);
+      if (byte > high) {
+        break;
+      }
+      NodeReader node = Child(i);
+      fn(byte, node);
+    }
+  }
+
+  template<class Fn>
+  bool VisitChild(uint8_t byte, Fn&& fn) const {
+    size_t i = LowerBound(byte);
+    if (i == NrChildren() || ChildByte(i) != byte) {
+      return false;
+    }
+    NodeReader node = Child(i);
+    fn(byte, node);
+    return true;
+  }
+
+  // visits the suffix at offset as fn(len_p, path, len_v, value, ref)
+  // and returns the offset of the next suffix
+  template<class Fn>
+  size_t VisitSuffixAt(size_t offset, Fn&& fn) const {
+    const uint8_t* suffixes = Suffixes();
+    size_t len_p;
+    size_t len_v;
+    offset = ReadSuffixSizes(suffixes, offset, len_p, len_v);
+    const uint8_t* path  = &suffixes[offset];
+    offset += len_p;
+    const uint8_t* value = &suffixes[offset];
+    offset += len_v;
+    cas::ref_t ref;
+    if (HasRefIds()) {
+      size_t id;
+      offset = cas::util::ReadVarint(&suffixes[offset], id) - suffixes;
+      ref = layout_->Ref(id);
+    } else {
+      std::memcpy(&ref, &suffixes[offset], sizeof(cas::ref_t));
       offset += sizeof(cas::ref_t);
-      callback(len_p, path, len_v, value, ref);
     }
+    fn(len_p, path, len_v, value, ref);
+    return offset;
+  }
+
+  template<class Fn>
+  void VisitSuffixes(Fn&& fn) const {
+    size_t offset = FirstSuffixPos();
+    for (size_t i = 0, sz = NrSuffixes(); i < sz; ++i) {
+      offset = VisitSuffixAt(offset, fn);
+    }
+  }
+
+  void ForEachChild(const INode::ChildCallback& callback) const override {
+    VisitChildrenInRange(0x00, 0xFF, [&](uint8_t byte, NodeReader& node) {
+      callback(byte, &node);
+    });
+  }
+
+  void ForEachChildInRange(uint8_t low, uint8_t high,
+      const INode::ChildCallback& callback) const override {
+    VisitChildrenInRange(low, high, [&](uint8_t byte, NodeReader& node) {
+      callback(byte, &node);
+    });
+  }
+
+  bool LookupChild(uint8_t byte,
+      const INode::ChildCallback& callback) const override {
+    return VisitChild(byte, [&](uint8_t b, NodeReader& node) {
+      callback(b, &node);
+    });
+  }
+
+  void ForEachSuffix(const INode::SuffixCallback& callback) const override {
+    VisitSuffixes(callback);
+  }
+
+  std::unique_ptr<INode> Detach() const override {
+    return std::make_unique<NodeReader>(*this);
   }
 
   void Dump() {
@@ -129,7 +404,16 @@ public:
         printf("\n        Revision: %s\n", cas::ToString(ref).c_str());
       });
     } else {
-      std::cout << "NrChildren: " << NrChildren() << "\n";
+      if (HasSubtreeStats()) {
+        std::cout << "SubtreeKeys: " << SubtreeKeys() << "\n";
+        std::cout << "SubtreeValues: ";
+        cas::util::DumpHexValues(MinSubtreeValue(), 0, LenSubtreeValues());
+        std::cout << " - ";
+        cas::util::DumpHexValues(MaxSubtreeValue(), 0, LenSubtreeValues());
+        std::cout << "\n";
+      }
+      std::cout << "NrChildren: " << NrChildren()
+        << (HasKeyArray() ? " (key array)" : " (interleaved)") << "\n";
       int i = 0;
       ForEachChild([&i](uint8_t byte, INode* child) -> void {
         auto c = static_cast<NodeReader*>(child);
@@ -139,6 +423,94 @@ public:
   }
 
 private:
+  inline bool HasVarintHeader() const {
+    return layout_ != nullptr && layout_->varint_headers_;
+  }
+
+  void DecodeHeader() {
+    std::memcpy(&header_, buffer_, 4);
+    len_path_ = (k_mask_lp & header_) >> 18;
+    len_value_ = (k_mask_lv & header_) >> 14;
+    nr_entries_ = Dimension() == cas::Dimension::LEAF
+      ? k_mask_m & header_
+      : k_mask_children & header_;
+    header_size_ = POS_P;
+    payload_pos_ = POS_P;
+    if (HasSubtreeStats()) {
+      // [nr keys: 6 bytes, len: 1 byte, min value, max value]
+      len_subtree_values_ = buffer_[POS_P + 6];
+      payload_pos_ += 7 + 2 * len_subtree_values_;
+    }
+  }
+
+  void DecodeVarintHeader() {
+    uint8_t flags = buffer_[0];
+    header_ = (static_cast<uint32_t>(flags & 0xC0) << 24)
+      | (static_cast<uint32_t>(flags & 0x3C) << 8);
+    size_t len_path;
+    size_t len_value;
+    size_t m;
+    const uint8_t* src = buffer_ + 1;
+    src = cas::util::ReadVarint(src, len_path);
+    src = cas::util::ReadVarint(src, len_value);
+    src = cas::util::ReadVarint(src, m);
+    len_path_ = static_cast<uint16_t>(len_path);
+    len_value_ = static_cast<uint16_t>(len_value);
+    nr_entries_ = static_cast<uint32_t>(m);
+    header_size_ = static_cast<uint8_t>(src - buffer_);
+    payload_pos_ = header_size_;
+    if (HasSubtreeStats()) {
+      // [nr keys: 6 bytes, len: varint, min value, max value]
+      size_t len;
+      src = cas::util::ReadVarint(src + 6, len);
+      len_subtree_values_ = static_cast<uint16_t>(len);
+      payload_pos_ = static_cast<uint32_t>((src - buffer_) + 2 * len);
+    }
+  }
+
+  // reads the lengths of the suffix at offset and returns the offset
+  // of its path
+  inline size_t ReadSuffixSizes(const uint8_t* suffixes, size_t offset,
+      size_t& len_p, size_t& len_v) const {
+    if (HasVarintHeader()) {
+      const uint8_t* src = &suffixes[offset];
+      src = cas::util::ReadVarint(src, len_p);
+      src = cas::util::ReadVarint(src, len_v);
+      return src - suffixes;
+    }
+    uint16_t len_data = 0;
+    len_data |= static_cast<uint16_t>(suffixes[offset++] << 8);
+    len_data |= static_cast<uint16_t>(suffixes[offset++] << 0);
+    auto [plen, vlen] = cas::util::DecodeSizes(len_data);
+    len_p = plen;
+    len_v = vlen;
+    return offset;
+  }
+
+  // suffixes store varint ids into the reference dictionary
+  inline bool HasRefIds() const {
+    return layout_ != nullptr && layout_->ref_ids_;
+  }
+
+  // leaves start with a marker byte (raw or compressed)
+  inline bool HasLeafMarker() const {
+    return layout_ != nullptr && layout_->leaf_compression_ != Compression::None;
+  }
+
+  inline size_t ReadPointer(size_t pos) const {
+    if (!HasRelativePointers()) {
+      size_t ptr = 0;
+      ptr |= (static_cast<size_t>(buffer_[pos + 0]) << 40);
+      ptr |= (static_cast<size_t>(buffer_[pos + 1]) << 32);
+      ptr |= (static_cast<size_t>(buffer_[pos + 2]) << 24);
+      ptr |= (static_cast<size_t>(buffer_[pos + 3]) << 16);
+      ptr |= (static_cast<size_t>(buffer_[pos + 4]) <<  8);
+      ptr |= (static_cast<size_t>(buffer_[pos + 5]) <<  0);
+      return ptr;
+    }
+    return cas::util::ReadRelativePointer(&buffer_[pos], buffer_ - head_, PointerWidth());
+  }
+
   void CopyFromBuffer(size_t& offset, void* dst, size_t count) {
     std::memcpy(dst, buffer_ + offset, count);
     offset += count;
@@ -3,21 +3,23 @@
 #include "cas/types.hpp"
 #include <fstream>
 #include <memory>
+#include <vector>
 
 namespace cas {
 
 
-using IdxPage = std::array<std::byte, cas::PAGE_SZ>;
+using IdxPage = std::vector<std::byte>;
 
 
 
 class Pager {
   const std::string filename_;
+  const size_t page_size_;
   std::fstream file_;
 
 public:
 
-  explicit Pager(const std::string& filename);
+  explicit Pager(const std::string& filename, size_t page_size = PAGE_SZ);
   ~Pager();
 
   // delete copy/move constructors/assignments
@@ -30,7 +32,7 @@ public:
   void Close() { CloseFile(); };
 
   inline std::shared_ptr<IdxPage> NewIdxPage() const {
-    return std::make_shared<IdxPage>();
+    return std::make_shared<IdxPage>(page_size_);
   }
 
   std::shared_ptr<IdxPage> Fetch(cas::page_nr_t page_nr);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cas/context.hpp"
+#include "cas/io_engine.hpp"
 #include "cas/memory_page.hpp"
 #include "cas/memory_pool.hpp"
 #include "cas/bulk_loader_stats.hpp"
@@ -8,6 +9,8 @@
 #include <fstream>
 #include <memory>
 #include <forward_list>
+#include <mutex>
+#include <vector>
 
 namespace cas {
 
@@ -20,13 +23,30 @@ class Partition {
   /* file meta information */
   std::string filename_;
   size_t fptr_write_page_nr_ = 0;
+  size_t page_size_;
+  /* files of root partitions start with a PartitionHeader page,
+   * page i of the partition is page i + header_pages_ of the file */
+  size_t header_pages_ = 0;
+  /* compressed files store every page in a variable-sized frame,
+   * frames_ is the offset table of the pages written by this partition */
+  struct Frame {
+    size_t offset_;
+    uint32_t size_;     // compressed size
+    uint32_t raw_size_; // the frame is not compressed if size_ == raw_size_
+  };
+  Compression compression_;
+  std::vector<Frame> frames_;
+  size_t fptr_write_offset_ = 0;
   /* record statistics */
   size_t nr_keys_ = 0;
+  size_t key_bytes_ = 0; // uncompressed size of the keys (see PsiPartition)
   size_t nr_pages_ = 0;
   size_t nr_memory_pages_ = 0;
   size_t nr_disk_pages_ = 0;
-  BulkLoaderStats& stats_;
+  BulkLoaderStats* stats_;
   const Context& context_;
+  IoEngine* io_ = nullptr;
+  MemoryPool* read_ahead_pool_ = nullptr;
   /* needed only for the root partition */
   size_t fptr_cursor_first_page_nr_ = 0;
   size_t fptr_cursor_last_page_nr_ = std::numeric_limits<std::size_t>::max();
@@ -47,6 +67,14 @@ public:
   void PushToMemory(MemoryPage&& page);
   MemoryPage PopFromMemory();
   void PushToDisk(const MemoryPage& page);
+  // appends page to the file and counts it in NrPages. Several threads
+  // can append to the same partition at once: mutex is only held to
+  // reserve the position of the page in the file, the page is
+  // compressed and written with pwrite by the calling thread (bypassing
+  // the write-behind buffer of the IoEngine) and its write is recorded
+  // in stats.
+  void AppendToDisk(const MemoryPage& page, std::mutex& mutex,
+      BulkLoaderStats& stats);
 
   /* Getters/Setters */
   void DscP(int dsc_p) { dsc_p_ = dsc_p; }
@@ -59,6 +87,12 @@ public:
   void FptrCursorLastPageNr(size_t val) {
     fptr_cursor_last_page_nr_ = val;
   }
+  size_t FptrCursorFirstPageNr() const {
+    return fptr_cursor_first_page_nr_;
+  }
+  size_t FptrCursorLastPageNr() const {
+    return fptr_cursor_last_page_nr_;
+  }
   void IsRootPartition(bool is_root_partition) {
     is_root_partition_ = is_root_partition;
   }
@@ -66,40 +100,91 @@ public:
     return is_root_partition_;
   }
   BulkLoaderStats& Stats() const {
-    return stats_;
+    return *stats_;
+  }
+  void Stats(BulkLoaderStats& stats) {
+    stats_ = &stats;
   }
+  // pages are read with io (if asynchronous) and written with io (if
+  // it buffers writes), otherwise with pread/pwrite
+  void Io(IoEngine* io);
+  // cursors borrow up to Context::read_ahead_depth_ free pages of pool
+  // to read ahead if the pages are read with pread (see Cursor)
+  void ReadAhead(MemoryPool* pool) { read_ahead_pool_ = pool; }
 
   inline size_t& NrKeys() { return nr_keys_; }
+  inline size_t& KeyBytes() { return key_bytes_; }
   inline size_t& NrPages() { return nr_pages_; }
   inline size_t& NrMemoryPages() { return nr_memory_pages_; }
   inline size_t& NrDiskPages() { return nr_disk_pages_; }
   inline const std::string& Filename() const { return filename_; }
+  inline size_t PageSize() const { return page_size_; }
+  // number of pages in the file
+  size_t NrFilePages() const;
 
+  // opens the file (if it exists) for reading and waits for the
+  // outstanding writes to it
+  void Open();
   void Close() { CloseFile(); }
+  // reserves disk space for nr_pages pages once the size of the file
+  // is known (if io buffers writes)
+  void Preallocate(size_t nr_pages);
   void DeleteFile();
   void Dump();
   void DumpDetailed(MemoryPage& io_page);
 
 
 public:
+  // Iterates over the memory pages and then over the disk pages of a
+  // partition. Disk pages are read into io_page. If they are read with
+  // pread and the partition has a read-ahead pool, a background thread
+  // reads the next pages into pages borrowed from the pool while the
+  // current page is processed. It is started with the second disk page,
+  // i.e., cursors that only peek at the first page do not read ahead.
+  // Pages are passed on by swapping them with io_page, i.e., io_page may
+  // point to a different page of the pool afterwards.
   class Cursor {
+    struct ReadAhead;
+
     Partition& p_;
     typename std::forward_list<MemoryPage>::iterator mptr_it_;
     typename std::forward_list<MemoryPage>::iterator mptr_it_prev_;
     MemoryPage& io_page_;
     size_t fptr_read_page_nr_;
     size_t fptr_last_page_nr_;
+    IoEngine* io_;
+    BulkLoaderStats* stats_;
+    MemoryPool* read_ahead_pool_;
+    bool has_fetched_ = false;
+    std::unique_ptr<ReadAhead> read_ahead_;
 
   public:
     Cursor(Partition& partition,
         MemoryPage& io_page,
         size_t fptr_read_page_nr,
         size_t fptr_last_page_nr);
+    Cursor(Partition& partition,
+        MemoryPage& io_page,
+        size_t fptr_read_page_nr,
+        size_t fptr_last_page_nr,
+        IoEngine* io,
+        BulkLoaderStats& stats,
+        MemoryPool* read_ahead_pool);
+    ~Cursor();
+
+    /* delete copy/move constructors/assignments */
+    Cursor(const Cursor& other) = delete;
+    Cursor(Cursor&& other) = delete;
+    Cursor& operator=(const Cursor& other) = delete;
+    Cursor& operator=(Cursor&& other) = delete;
 
     bool HasNext();
     bool FetchNextDiskPage();
     MemoryPage& NextPage();
     MemoryPage RemoveNextPage();
+
+  private:
+    void StartReadAhead();
   };
 
   Cursor Cursor(MemoryPage& io_page) {
@@ -111,6 +196,27 @@ public:
     };
   }
 
+  // cursor over the disk pages [first_page_nr, last_page_nr) only that
+  // reads with io (reading ahead with read_ahead_pool) and records the
+  // reads in stats. Cursors over disjoint page ranges can be used
+  // concurrently once the file is Open().
+  class Cursor DiskCursor(MemoryPage& io_page,
+      size_t first_page_nr,
+      size_t last_page_nr,
+      IoEngine* io,
+      BulkLoaderStats& stats,
+      MemoryPool* read_ahead_pool) {
+    return {
+      *this,
+      io_page,
+      first_page_nr,
+      last_page_nr,
+      io,
+      stats,
+      read_ahead_pool
+    };
+  }
+
   bool IsMemoryOnly() const;
   bool IsDiskOnly() const;
   bool IsHybrid() const;
@@ -120,7 +226,14 @@ private:
   void OpenFile();
   void CloseFile();
   int FWritePage(const MemoryPage& page, size_t page_nr);
-  int FReadPage(MemoryPage& page, size_t page_nr);
+  int FReadPage(MemoryPage& page, size_t page_nr, size_t last_page_nr,
+      IoEngine* io, BulkLoaderStats& stats);
+  int FWriteFrame(const MemoryPage& page, size_t page_nr);
+  int FReadFrame(MemoryPage& page, size_t page_nr, BulkLoaderStats& stats);
+  bool IsCompressed() const { return !frames_.empty(); }
+  void ReadHeader();
+  void WriteHeader();
+  bool BuffersWrites() const { return io_ != nullptr && io_->BuffersWrites(); }
 };
 
 } // namespace cas
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cas/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace cas {
+
+
+// Partition files that are passed between programs (the output of
+// csv2partition and the root partitions of Index) record their page
+// size in a header:
+//   [magic (8 bytes), page size (8 bytes), zeros up to the page size]
+// The header occupies one page such that the pages that follow stay
+// aligned for O_DIRECT. Files without a header consist of PAGE_SZ
+// pages. The partitions that the BulkLoader creates while loading are
+// only read by the same BulkLoader and have no header.
+struct PartitionHeader {
+  static constexpr size_t SZ = 16;
+  static constexpr uint64_t MAGIC = 0x3130'5452'5053'4143; // "CASPRT01"
+
+  size_t page_size_ = PAGE_SZ;
+  bool present_ = false;
+
+  // bytes before the first page
+  size_t ByteSize() const { return present_ ? page_size_ : 0; }
+
+  // parses the first size bytes of a partition file
+  static PartitionHeader Read(const std::byte* data, size_t size);
+
+  // reads the header of the partition file filename
+  static PartitionHeader Read(const std::string& filename);
+
+  // serializes the header into dst (page_size_ bytes)
+  void Write(std::byte* dst) const;
+};
+
+
+} // namespace cas
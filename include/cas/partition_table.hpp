@@ -12,12 +12,16 @@ class PartitionTable {
   long& partition_counter_;
   const cas::Context& context_;
   BulkLoaderStats& stats_;
+  IoEngine* io_;
+  MemoryPool* read_ahead_pool_;
 
 public:
   explicit PartitionTable(
       long& partition_counter,
       const cas::Context& context,
-      BulkLoaderStats& stats);
+      BulkLoaderStats& stats,
+      IoEngine* io = nullptr,
+      MemoryPool* read_ahead_pool = nullptr);
   ~PartitionTable() = default;
 
   /* delete copy/move constructors/assignments */
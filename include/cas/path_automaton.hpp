@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace cas {
+
+
+// Deterministic automaton of an encoded query path.
+//
+// The query path is translated into an NFA (literal bytes, * as a
+// sequence of non-separator bytes, /** as an optional path suffix), which
+// is then determinized with the subset construction. The input bytes are
+// mapped to a small number of classes (one per distinct byte of the query
+// path and one for all other bytes), i.e., the transition table has
+// NrStates() * NrClasses() entries.
+//
+// State kDead is the only state from which no path can be accepted,
+// every match is advanced with exactly one table lookup per path byte.
+// The end of a path (kNullByte) is not a transition, it is accepted if
+// IsAccepting is true for the current state.
+class PathAutomaton {
+  // upper bound on the number of DFA states of a query path, more complex
+  // query paths are evaluated with the backtracking path_matcher
+  static constexpr size_t kMaxStates = 4096;
+
+  std::array<uint8_t, 256> classes_;
+  size_t nr_classes_ = 0;
+  std::vector<uint16_t> transitions_;
+  std::vector<uint8_t> flags_;
+  // range of child bytes that can lead to a match, per state
+  std::vector<uint8_t> low_;
+  std::vector<uint8_t> high_;
+
+  static constexpr uint8_t kFlagAccepting   = 1 << 0;
+  static constexpr uint8_t kFlagAnyExtension = 1 << 1;
+
+public:
+  static constexpr uint16_t kDead  = 0;
+  static constexpr uint16_t kStart = 1;
+
+  // returns nullptr if the query path needs more than kMaxStates states
+  static std::shared_ptr<const PathAutomaton> Compile(
+      const std::vector<std::byte>& query_path);
+
+  uint16_t Next(uint16_t state, std::byte byte) const {
+    return transitions_[state * nr_classes_ + classes_[static_cast<uint8_t>(byte)]];
+  }
+
+  // true if the path read so far matches
+  bool IsAccepting(uint16_t state) const {
+    return (flags_[state] & kFlagAccepting) != 0;
+  }
+
+  // true if every path that extends the path read so far matches
+  bool AcceptsAnyExtension(uint16_t state) const {
+    return (flags_[state] & kFlagAnyExtension) != 0;
+  }
+
+  std::byte LowChild(uint16_t state) const { return std::byte{low_[state]}; }
+  std::byte HighChild(uint16_t state) const { return std::byte{high_[state]}; }
+
+  size_t NrStates() const { return flags_.size(); }
+  size_t NrClasses() const { return nr_classes_; }
+
+  void Dump() const;
+};
+
+
+} // namespace cas
@@ -18,6 +18,9 @@ std::string ToString(PrefixMatch m);
 
 struct State {
   uint16_t ppos_ = 0;
+  // state of the key's PathAutomaton (if any)
+  uint16_t dfa_state_ = cas::PathAutomaton::kStart;
+  // state of the backtracking matcher
   uint16_t qpos_ = 0;
   uint16_t desc_ppos_ = 0;
   int16_t  desc_qpos_ = -1;
@@ -27,15 +30,39 @@ struct State {
   void Dump() const;
 };
 
+// advances the match of the path to len_path with the key's
+// PathAutomaton, keys without automaton are matched by backtracking
+PrefixMatch MatchPathIncremental(
+    const cas::QueryBuffer& path,
+    const cas::BinarySK& key,
+    size_t len_path,
+    State& state);
+
+// matches by backtracking on * and ** (which may rescan the path)
 PrefixMatch MatchPathIncremental(
     const cas::QueryBuffer& path,
     const std::vector<std::byte>& query_path,
     size_t len_path,
     State& state);
 
+bool MatchPath(
+    const cas::QueryBuffer& path,
+    const cas::BinarySK& key,
+    size_t len_path);
+
 bool MatchPath(
     const cas::QueryBuffer& path,
     const std::vector<std::byte>& query_path,
     size_t len_path);
 
+// true if every path that extends the prefix matched into state matches,
+// i.e., only a trailing descendant-or-self axis (/**) of the query is left
+bool MatchesAnyExtension(
+    const cas::BinarySK& key,
+    const State& state);
+
+bool MatchesAnyExtension(
+    const std::vector<std::byte>& query_path,
+    const State& state);
+
 } // namespace cas::path_matcher
@@ -7,9 +7,14 @@
 #include "cas/path_matcher.hpp"
 #include "cas/query_stats.hpp"
 #include "cas/search_key.hpp"
+#include "cas/thread_pool.hpp"
 
+#include <atomic>
 #include <deque>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <set>
 #include <list>
@@ -56,12 +61,26 @@ class Query {
     void Dump() const;
   };
 
+  // a subtree that is evaluated on the thread pool (see DescendNode)
+  struct Task {
+    std::unique_ptr<INode> node_;
+    State state_;
+    std::unique_ptr<Query> query_;
+    std::atomic<bool> claimed_{false};
+    std::future<void> done_;
+  };
+
   const INode* root_;
   const BinarySK& key_;
   const BinaryKeyEmitter emitter_;
   std::unique_ptr<QueryBuffer> buf_pat_;
   std::unique_ptr<QueryBuffer> buf_val_;
   QueryStats stats_;
+  /* intra-query parallelism */
+  ThreadPool* pool_ = nullptr;
+  size_t min_fanout_ = 0;
+  std::shared_ptr<std::mutex> emitter_mutex_;
+  std::vector<std::shared_ptr<Task>> tasks_;
 
 
 public:
@@ -69,13 +88,45 @@ public:
       const BinarySK& key,
       const BinaryKeyEmitter emitter);
 
+  // evaluates the children of nodes with a fanout of at least min_fanout
+  // as separate tasks on pool; the emitter is then called under a lock
+  void Parallelize(ThreadPool& pool, size_t min_fanout);
+
   void Execute();
 
   const QueryStats& Stats() const {
     return stats_;
   }
 
+  /* matching rules shared with QueryEngine */
+
+  // matches the value prefix buf_val[0, len_val) against [key.low_, key.high_];
+  // vl_pos/vh_pos are the lengths of the common prefixes with low/high
+  static path_matcher::PrefixMatch MatchValue(const BinarySK& key,
+      const QueryBuffer& buf_val, uint16_t len_val,
+      uint16_t& vl_pos, uint16_t& vh_pos);
+
+  // true if every value with the prefix buf_val[0, len_val) lies in
+  // [key.low_, key.high_] (requires that MatchValue did not MISMATCH)
+  static bool ValueRangeCovers(const BinarySK& key,
+      const QueryBuffer& buf_val, uint16_t len_val,
+      uint16_t vl_pos, uint16_t vh_pos);
+
+  // the range of child bytes of a path node that can match
+  static void PathChildRange(const BinarySK& key,
+      const path_matcher::State& pm_state, std::byte& low, std::byte& high);
+
+  // the range of child bytes of a value node that can match
+  static void ValueChildRange(const BinarySK& key, uint16_t len_val,
+      uint16_t vl_pos, uint16_t vh_pos, std::byte& low, std::byte& high);
+
 private:
+  // creates a task that continues the evaluation of parent at state s
+  Query(const Query& parent, const State& s);
+
+  void Spawn(State s, const cas::INode* child);
+  void CompleteTasks();
+
   void EvaluateQuery(State& s);
   void EvaluateInnerNode(State& s, const cas::INode* node);
   void EvaluateLeafNode(State& s, const cas::INode* node);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "cas/index_reader.hpp"
+#include "cas/key.hpp"
+#include "cas/key_decoder.hpp"
+#include "cas/mem/node.hpp"
+#include "cas/node_reader.hpp"
+#include "cas/query_engine.hpp"
+#include "cas/query_stats.hpp"
+#include "cas/search_key.hpp"
+#include "cas/types.hpp"
+#include <limits>
+#include <memory>
+#include <vector>
+
+
+namespace cas {
+
+
+// Pull-based access to the matches of a query.
+//
+// The cursor evaluates the query lazily with QueryEngines that are
+// suspended after each match: first over the in-memory index, then over
+// every mapped index file. The traversal only advances while the
+// consumer calls Next or Skip, i.e., abandoning the cursor or reaching
+// the limit stops the query without materializing further matches.
+//
+// The order of the matches is the same as with Index::Query. The cursor
+// keeps the mappings of its IndexReader alive, but like any query it
+// must not be used concurrently with modifications of the in-memory
+// index (Insert, BulkLoad, FlushMemoryResidentKeys).
+class QueryCursor {
+  // copies the current match out of the traversal buffers
+  struct Collector {
+    bool copy_ = true;
+    std::unique_ptr<QueryBuffer> path_;
+    std::unique_ptr<QueryBuffer> value_;
+    size_t len_path_ = 0;
+    size_t len_value_ = 0;
+    ref_t ref_;
+
+    void operator()(const QueryBuffer& path, size_t len_path,
+        const QueryBuffer& value, size_t len_value, ref_t ref);
+  };
+
+  using MemEngine  = QueryEngine<mem::Node, Collector>;
+  using FileEngine = QueryEngine<NodeReader, Collector>;
+
+  // engines keep references to the key, the collector, and the roots,
+  // they are allocated separately such that the cursor can be moved
+  std::unique_ptr<const BinarySK> key_;
+  std::unique_ptr<Collector> collector_;
+  std::unique_ptr<MemEngine> mem_engine_;
+  std::shared_ptr<const IndexReader> reader_;
+  size_t next_file_ = 0;
+  std::unique_ptr<NodeReader> file_root_;
+  std::unique_ptr<FileEngine> file_engine_;
+  size_t limit_;
+  size_t nr_returned_ = 0;
+  QueryStats stats_;
+
+public:
+  static constexpr size_t kNoLimit = std::numeric_limits<size_t>::max();
+
+  // root and reader may be null if there is no in-memory or
+  // disk-based index, respectively
+  QueryCursor(const mem::Node* root,
+      std::shared_ptr<const IndexReader> reader,
+      const BinarySK& key,
+      size_t limit = kNoLimit);
+
+  QueryCursor(QueryCursor&& other) = default;
+  QueryCursor& operator=(QueryCursor&& other) = default;
+
+  // advances to the next match; returns false if the query is exhausted
+  // or limit matches have been returned
+  bool Next();
+
+  // discards up to n matches without copying them and returns the
+  // number of discarded matches; they do not count towards the limit
+  size_t Skip(size_t n);
+
+  /* the current match (valid after Next returned true) */
+
+  const QueryBuffer& Path() const { return *collector_->path_; }
+  size_t LenPath() const { return collector_->len_path_; }
+  const QueryBuffer& Value() const { return *collector_->value_; }
+  size_t LenValue() const { return collector_->len_value_; }
+  ref_t Ref() const { return collector_->ref_; }
+
+  template<class VType>
+  Key<VType> Decode() const {
+    return KeyDecoder<VType>::Decode(Path(), LenPath(),
+        Value(), LenValue(), Ref());
+  }
+
+  // number of matches returned by Next so far
+  size_t NrReturned() const { return nr_returned_; }
+
+  // statistics of the traversal so far
+  QueryStats Stats() const;
+
+private:
+  // resumes the traversal until n matches were emitted
+  // or all indexes are exhausted
+  size_t Advance(size_t n);
+};
+
+
+} // namespace cas
@@ -0,0 +1,550 @@
+#pragma once
+
+#include "cas/mem/node.hpp"
+#include "cas/mem/node0.hpp"
+#include "cas/mem/node4.hpp"
+#include "cas/mem/node16.hpp"
+#include "cas/mem/node48.hpp"
+#include "cas/mem/node256.hpp"
+#include "cas/node_reader.hpp"
+#include "cas/path_matcher.hpp"
+#include "cas/query.hpp"
+#include "cas/query_stats.hpp"
+#include "cas/search_key.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+
+namespace cas {
+
+
+// Non-virtual access to the nodes of a trie for the QueryEngine.
+// A Handle refers to a node and is kept on the traversal stack.
+// A Cursor points to the next child or suffix of a node:
+//   FirstChild(node, low) positions a cursor at the first child >= low,
+//   NextChild(node, cursor, high, byte) returns the child at the cursor
+//     if its byte is <= high and advances the cursor,
+//   NextSuffix(node, cursor, fn) calls fn(len_p, path, len_v, value, ref)
+//     for the suffix at the cursor and advances the cursor.
+// SubtreeKeys and SubtreeValueRange return the statistics of a subtree
+// if they are known without reading the subtree.
+template<class NodeT>
+struct NodeAccess;
+
+
+// NodeReader is final, i.e., none of these calls is virtual
+template<>
+struct NodeAccess<NodeReader> {
+  using Handle = NodeReader;
+
+  struct Cursor {
+    // leaves with varint headers may exceed 2**16 suffixes
+    uint32_t pos_ = 0;
+    uint32_t offset_ = 0;
+  };
+
+  static const NodeReader& Get(const Handle& handle) {
+    return handle;
+  }
+  static Handle Root(const NodeReader* root) {
+    return *root;
+  }
+
+  static cas::Dimension Dimension(const NodeReader& node) {
+    return node.Dimension();
+  }
+  static size_t LenPath(const NodeReader& node) {
+    return node.LenPath();
+  }
+  static size_t LenValue(const NodeReader& node) {
+    return node.LenValue();
+  }
+  static const uint8_t* Path(const NodeReader& node) {
+    return node.Path();
+  }
+  static const uint8_t* Value(const NodeReader& node) {
+    return node.Value();
+  }
+
+  static Cursor FirstChild(const NodeReader& node, uint8_t low) {
+    return Cursor{static_cast<uint32_t>(node.LowerBound(low)), 0};
+  }
+
+  static std::optional<Handle> NextChild(const NodeReader& node,
+      Cursor& cursor, uint8_t high, uint8_t& byte) {
+    if (cursor.pos_ >= node.NrChildren() || node.ChildByte(cursor.pos_) > high) {
+      return std::nullopt;
+    }
+    byte = node.ChildByte(cursor.pos_);
+    return node.Child(cursor.pos_++);
+  }
+
+  static Cursor FirstSuffix(const NodeReader& node) {
+    return Cursor{0, static_cast<uint32_t>(node.FirstSuffixPos())};
+  }
+
+  template<class Fn>
+  static bool NextSuffix(const NodeReader& node, Cursor& cursor, Fn&& fn) {
+    if (cursor.pos_ >= node.NrSuffixes()) {
+      return false;
+    }
+    cursor.offset_ = node.VisitSuffixAt(cursor.offset_, fn);
+    ++cursor.pos_;
+    return true;
+  }
+
+  static bool SubtreeKeys(const NodeReader& node, size_t& nr_keys) {
+    if (node.Dimension() == cas::Dimension::LEAF) {
+      nr_keys = node.NrSuffixes();
+      return true;
+    }
+    if (node.HasSubtreeStats()) {
+      nr_keys = node.SubtreeKeys();
+      return true;
+    }
+    return false;
+  }
+
+  static bool SubtreeValueRange(const NodeReader& node,
+      const uint8_t*& min, const uint8_t*& max, size_t& len) {
+    if (!node.HasSubtreeStats()) {
+      return false;
+    }
+    min = node.MinSubtreeValue();
+    max = node.MaxSubtreeValue();
+    len = node.LenSubtreeValues();
+    return true;
+  }
+};
+
+
+// in-memory nodes are dispatched on their width once per child instead
+// of calling through the INode interface; for Node48 and Node256 the
+// cursor is the next byte
+template<>
+struct NodeAccess<mem::Node> {
+  using Handle = const mem::Node*;
+
+  struct Cursor {
+    uint16_t pos_ = 0;
+  };
+
+  static const mem::Node& Get(const Handle& handle) {
+    return *handle;
+  }
+  static Handle Root(const mem::Node* root) {
+    return root;
+  }
+
+  static cas::Dimension Dimension(const mem::Node& node) {
+    return node.dimension_;
+  }
+  static size_t LenPath(const mem::Node& node) {
+    return node.separator_pos_;
+  }
+  static size_t LenValue(const mem::Node& node) {
+    return node.prefixes_.size() - node.separator_pos_;
+  }
+  static const uint8_t* Path(const mem::Node& node) {
+    return node.prefixes_.data();
+  }
+  static const uint8_t* Value(const mem::Node& node) {
+    return node.prefixes_.data() + node.separator_pos_;
+  }
+
+  static Cursor FirstChild(const mem::Node& node, uint8_t low) {
+    switch (node.NodeWidth()) {
+    case 4: {
+      const auto& n = static_cast<const mem::Node4&>(node);
+      uint16_t pos = 0;
+      while (pos < n.nr_children_ && n.keys_[pos] < low) {
+        ++pos;
+      }
+      return Cursor{pos};
+    }
+    case 16:
+      return Cursor{static_cast<uint16_t>(
+          static_cast<const mem::Node16&>(node).LowerBound(low))};
+    default:
+      return Cursor{low};
+    }
+  }
+
+  static std::optional<Handle> NextChild(const mem::Node& node,
+      Cursor& cursor, uint8_t high, uint8_t& byte) {
+    switch (node.NodeWidth()) {
+    case 4: {
+      const auto& n = static_cast<const mem::Node4&>(node);
+      if (cursor.pos_ >= n.nr_children_ || n.keys_[cursor.pos_] > high) {
+        return std::nullopt;
+      }
+      byte = n.keys_[cursor.pos_];
+      return n.children_[cursor.pos_++];
+    }
+    case 16: {
+      const auto& n = static_cast<const mem::Node16&>(node);
+      if (cursor.pos_ >= n.nr_children_ || n.keys_[cursor.pos_] > high) {
+        return std::nullopt;
+      }
+      byte = n.keys_[cursor.pos_];
+      return n.children_[cursor.pos_++];
+    }
+    case 48: {
+      const auto& n = static_cast<const mem::Node48&>(node);
+      while (cursor.pos_ <= high && n.indexes_[cursor.pos_] == mem::kEmptyIndex) {
+        ++cursor.pos_;
+      }
+      if (cursor.pos_ > high) {
+        return std::nullopt;
+      }
+      byte = static_cast<uint8_t>(cursor.pos_);
+      return n.children_[n.indexes_[cursor.pos_++]];
+    }
+    case 256: {
+      const auto& n = static_cast<const mem::Node256&>(node);
+      while (cursor.pos_ <= high && n.children_[cursor.pos_] == nullptr) {
+        ++cursor.pos_;
+      }
+      if (cursor.pos_ > high) {
+        return std::nullopt;
+      }
+      byte = static_cast<uint8_t>(cursor.pos_);
+      return n.children_[cursor.pos_++];
+    }
+    default:
+      // Node0 has no children
+      return std::nullopt;
+    }
+  }
+
+  static Cursor FirstSuffix(const mem::Node& /* node */) {
+    return Cursor{0};
+  }
+
+  template<class Fn>
+  static bool NextSuffix(const mem::Node& node, Cursor& cursor, Fn&& fn) {
+    if (node.NodeWidth() != 0) {
+      return false;
+    }
+    const auto& refs = static_cast<const mem::Node0&>(node).refs_;
+    if (cursor.pos_ >= refs.size()) {
+      return false;
+    }
+    fn(0, nullptr, 0, nullptr, refs[cursor.pos_++]);
+    return true;
+  }
+
+  // in-memory nodes keep no statistics, only the size of leaves is known
+  static bool SubtreeKeys(const mem::Node& node, size_t& nr_keys) {
+    if (node.NodeWidth() != 0) {
+      return false;
+    }
+    nr_keys = static_cast<const mem::Node0&>(node).refs_.size();
+    return true;
+  }
+
+  static bool SubtreeValueRange(const mem::Node& /* node */,
+      const uint8_t*& /* min */, const uint8_t*& /* max */, size_t& /* len */) {
+    return false;
+  }
+};
+
+
+// Compile-time specialized counterpart of Query for a single node type
+// (NodeReader or mem::Node) and emitter type (e.g., a lambda). Children,
+// suffixes, and matches are visited without virtual calls or
+// std::function wrappers such that the traversal can be inlined.
+//
+// The trie is traversed iteratively with an explicit stack that holds
+// one frame per level of the current path, i.e., its memory is bounded
+// by the depth of the trie. The traversal can be suspended after any
+// number of matches (Next) and resumed later. The results, their order,
+// and the statistics are identical to those of Query, which remains the
+// type-erased front end (e.g., for intra-query parallelism).
+template<class NodeT, class Emitter>
+class QueryEngine {
+  using Access = NodeAccess<NodeT>;
+  using Handle = typename Access::Handle;
+  using Cursor = typename Access::Cursor;
+
+  struct State {
+    // length of the prefixes matched so far
+    uint16_t len_pat_ = 0;
+    uint16_t len_val_ = 0;
+    // state needed for the path matching
+    path_matcher::State pm_state_;
+    // state needed for the value matching
+    uint16_t vl_pos_ = 0;
+    uint16_t vh_pos_ = 0;
+    int depth_ = 0;
+  };
+
+  // a node whose prefixes matched, but whose children (inner node)
+  // or suffixes (leaf) are not completely evaluated yet
+  struct Frame {
+    Handle node_;
+    State state_;
+    Cursor cursor_;
+    cas::Dimension dimension_;
+    uint8_t high_;
+  };
+
+  const NodeT* root_;
+  const BinarySK& key_;
+  Emitter& emitter_;
+  std::unique_ptr<QueryBuffer> buf_pat_;
+  std::unique_ptr<QueryBuffer> buf_val_;
+  std::vector<Frame> stack_;
+  bool started_ = false;
+  bool count_only_ = false;
+  QueryStats stats_;
+
+public:
+  QueryEngine(const NodeT* root, const BinarySK& key, Emitter& emitter);
+
+  // evaluates the (remaining) query
+  void Execute();
+
+  // resumes the traversal until max_results more matches were
+  // emitted or the query is exhausted; returns the number of matches
+  // that were emitted
+  size_t Next(size_t max_results);
+
+  // only counts the matches (Stats().nr_matches_) without emitting them;
+  // subtrees whose keys all match are counted from their statistics
+  // without reading them (their depth is not recorded in sum_depth_)
+  void CountOnly() {
+    count_only_ = true;
+  }
+
+  // true if all matches have been emitted
+  bool Done() const {
+    return started_ && stack_.empty();
+  }
+
+  const QueryStats& Stats() const {
+    return stats_;
+  }
+
+private:
+  void Push(const Handle& handle, State& s);
+  bool CountSubtree(const NodeT& node, const State& s,
+      path_matcher::PrefixMatch match_pat, path_matcher::PrefixMatch match_val);
+  void UpdateStats(cas::Dimension dimension);
+};
+
+
+} // namespace cas
+
+
+template<class NodeT, class Emitter>
+cas::QueryEngine<NodeT, Emitter>::QueryEngine(
+        const NodeT* root,
+        const BinarySK& key,
+        Emitter& emitter)
+    : root_(root)
+    , key_(key)
+    , emitter_(emitter)
+    , buf_pat_(std::make_unique<QueryBuffer>())
+    , buf_val_(std::make_unique<QueryBuffer>())
+{}
+
+
+template<class NodeT, class Emitter>
+void cas::QueryEngine<NodeT, Emitter>::Execute() {
+  Next(std::numeric_limits<size_t>::max());
+}
+
+
+template<class NodeT, class Emitter>
+size_t cas::QueryEngine<NodeT, Emitter>::Next(size_t max_results) {
+  const auto& t_start = std::chrono::high_resolution_clock::now();
+  if (!started_) {
+    started_ = true;
+    if (root_ != nullptr) {
+      State initial_state;
+      Push(Access::Root(root_), initial_state);
+    }
+  }
+
+  size_t nr_emitted = 0;
+  while (!stack_.empty() && nr_emitted < max_results) {
+    Frame& frame = stack_.back();
+    const NodeT& node = Access::Get(frame.node_);
+
+    if (frame.dimension_ == cas::Dimension::LEAF) {
+      // evaluate the suffixes until the leaf is exhausted or enough
+      // matches have been emitted
+      const State& state = frame.state_;
+      auto evaluate_suffix = [&](
+            size_t len_p, const uint8_t* path,
+            size_t len_v, const uint8_t* value,
+            cas::ref_t ref) {
+        // we need to copy the state since it is mutated
+        State s = state;
+        if (len_p > 0) {
+          std::memcpy(&buf_pat_->at(s.len_pat_), path, len_p);
+        }
+        if (len_v > 0) {
+          std::memcpy(&buf_val_->at(s.len_val_), value, len_v);
+        }
+        s.len_pat_ += len_p;
+        s.len_val_ += len_v;
+        auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key_,
+            s.len_pat_, s.pm_state_);
+        auto match_val = Query::MatchValue(key_, *buf_val_, s.len_val_,
+            s.vl_pos_, s.vh_pos_);
+        if (match_pat == path_matcher::PrefixMatch::MATCH &&
+            match_val == path_matcher::PrefixMatch::MATCH) {
+          ++stats_.nr_matches_;
+          stats_.sum_depth_ += s.depth_;
+          ++nr_emitted;
+          if (!count_only_) {
+            emitter_(*buf_pat_, s.len_pat_, *buf_val_, s.len_val_, ref);
+          }
+        }
+      };
+      bool has_suffix = true;
+      while (nr_emitted < max_results &&
+          (has_suffix = Access::NextSuffix(node, frame.cursor_, evaluate_suffix))) {
+      }
+      if (!has_suffix) {
+        stack_.pop_back();
+      }
+      continue;
+    }
+
+    // descend into the next qualifying child
+    uint8_t byte = 0;
+    std::optional<Handle> child = Access::NextChild(node, frame.cursor_, frame.high_, byte);
+    if (!child) {
+      stack_.pop_back();
+      continue;
+    }
+    State s = frame.state_;
+    if (frame.dimension_ == cas::Dimension::PATH) {
+      buf_pat_->at(s.len_pat_++) = static_cast<std::byte>(byte);
+    } else {
+      buf_val_->at(s.len_val_++) = static_cast<std::byte>(byte);
+    }
+    ++s.depth_;
+    Push(*child, s);
+  }
+
+  const auto& t_end = std::chrono::high_resolution_clock::now();
+  stats_.runtime_mus_ +=
+    std::chrono::duration_cast<std::chrono::microseconds>(t_end-t_start).count();
+  return nr_emitted;
+}
+
+
+// matches the prefixes of a node and pushes it if its children or
+// suffixes can contain matches
+template<class NodeT, class Emitter>
+void cas::QueryEngine<NodeT, Emitter>::Push(const Handle& handle, State& s) {
+  const NodeT& node = Access::Get(handle);
+  cas::Dimension dimension = Access::Dimension(node);
+  UpdateStats(dimension);
+
+  // the parent's byte has already been appended
+  size_t len_p = Access::LenPath(node);
+  size_t len_v = Access::LenValue(node);
+  std::memcpy(&buf_pat_->at(s.len_pat_), Access::Path(node),  len_p);
+  std::memcpy(&buf_val_->at(s.len_val_), Access::Value(node), len_v);
+  s.len_pat_ += len_p;
+  s.len_val_ += len_v;
+
+  auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key_,
+      s.len_pat_, s.pm_state_);
+  auto match_val = Query::MatchValue(key_, *buf_val_, s.len_val_,
+      s.vl_pos_, s.vh_pos_);
+  if (match_pat == path_matcher::PrefixMatch::MISMATCH ||
+      match_val == path_matcher::PrefixMatch::MISMATCH) {
+    return;
+  }
+  if (count_only_ && CountSubtree(node, s, match_pat, match_val)) {
+    return;
+  }
+  if (dimension == cas::Dimension::LEAF) {
+    stack_.push_back(Frame{handle, s, Access::FirstSuffix(node), dimension, 0xFF});
+    return;
+  }
+  if (match_pat == path_matcher::PrefixMatch::MATCH &&
+      match_val == path_matcher::PrefixMatch::MATCH) {
+    throw std::runtime_error{"an inner node cannot MATCH"};
+  }
+
+  std::byte low;
+  std::byte high;
+  if (dimension == cas::Dimension::PATH) {
+    Query::PathChildRange(key_, s.pm_state_, low, high);
+  } else {
+    Query::ValueChildRange(key_, s.len_val_, s.vl_pos_, s.vh_pos_, low, high);
+  }
+  stack_.push_back(Frame{handle, s,
+      Access::FirstChild(node, static_cast<uint8_t>(low)),
+      dimension, static_cast<uint8_t>(high)});
+}
+
+
+// counts the keys of the subtree if all of them match
+template<class NodeT, class Emitter>
+bool cas::QueryEngine<NodeT, Emitter>::CountSubtree(
+    const NodeT& node,
+    const State& s,
+    path_matcher::PrefixMatch match_pat,
+    path_matcher::PrefixMatch match_val) {
+  if (match_pat != path_matcher::PrefixMatch::MATCH &&
+      !path_matcher::MatchesAnyExtension(key_, s.pm_state_)) {
+    return false;
+  }
+  size_t nr_keys;
+  if (!Access::SubtreeKeys(node, nr_keys)) {
+    return false;
+  }
+  bool values_match = match_val == path_matcher::PrefixMatch::MATCH ||
+    Query::ValueRangeCovers(key_, *buf_val_, s.len_val_, s.vl_pos_, s.vh_pos_);
+  const uint8_t* min;
+  const uint8_t* max;
+  size_t len;
+  if (!values_match && Access::SubtreeValueRange(node, min, max, len)) {
+    // the statistics exclude the value prefix matched so far, the
+    // buffer behind it is free (it is overwritten by the children)
+    auto begin = buf_val_->begin();
+    auto end = begin + s.len_val_ + len;
+    std::memcpy(&buf_val_->at(s.len_val_), min, len);
+    values_match = !std::lexicographical_compare(begin, end,
+        key_.low_.begin(), key_.low_.end());
+    std::memcpy(&buf_val_->at(s.len_val_), max, len);
+    values_match = values_match && !std::lexicographical_compare(
+        key_.high_.begin(), key_.high_.end(), begin, end);
+  }
+  if (!values_match) {
+    return false;
+  }
+  stats_.nr_matches_ += nr_keys;
+  return true;
+}
+
+
+template<class NodeT, class Emitter>
+void cas::QueryEngine<NodeT, Emitter>::UpdateStats(cas::Dimension dimension) {
+  ++stats_.read_nodes_;
+  switch (dimension) {
+  case cas::Dimension::PATH:
+    ++stats_.read_path_nodes_;
+    break;
+  case cas::Dimension::VALUE:
+    ++stats_.read_value_nodes_;
+    break;
+  case cas::Dimension::LEAF:
+    ++stats_.read_leaf_nodes_;
+    break;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cas/index.hpp"
+#include "cas/query.hpp"
+#include "cas/search_key.hpp"
+#include "cas/thread_pool.hpp"
+#include <future>
+#include <shared_mutex>
+
+
+namespace cas {
+
+
+// Serves queries concurrently over a shared index.
+//
+// Queries only read the in-memory tree and the mapped index files (see
+// IndexReader) and thus run in parallel under a shared lock. Insertions
+// modify the in-memory tree and, on overflow, replace the disk-based
+// indexes. They take the lock exclusively.
+//
+// Queries either run on the caller's thread (Query) or on a fixed-size
+// pool of worker threads (Submit). If Context::query_parallel_fanout_ is
+// set, broad queries are additionally split into subtree tasks that run
+// on the same pool.
+template<class VType>
+class QueryService {
+  Index<VType>& index_;
+  std::shared_mutex index_mutex_;
+  ThreadPool pool_;
+
+public:
+  QueryService(Index<VType>& index, size_t nr_workers);
+  ~QueryService();
+
+  /* delete copy/move constructors/assignments */
+  QueryService(const QueryService& other) = delete;
+  QueryService(QueryService&& other) = delete;
+  QueryService& operator=(const QueryService& other) = delete;
+  QueryService& operator=(QueryService&& other) = delete;
+
+  QueryStats Query(const BinarySK& key, const BinaryKeyEmitter& emitter);
+  std::future<QueryStats> Submit(BinarySK key, BinaryKeyEmitter emitter);
+
+  void Insert(BinaryKey key);
+  void FlushMemoryResidentKeys();
+
+  size_t NrWorkers() const { return pool_.NrThreads(); }
+};
+
+
+} // namespace cas
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "cas/key.hpp"
+#include "cas/path_automaton.hpp"
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -24,6 +26,9 @@ struct BinarySK {
   std::vector<std::byte> path_;
   std::vector<std::byte> low_;
   std::vector<std::byte> high_;
+  // compiled path_ (see KeyEncoder::Encode), null if path_ is
+  // matched with the backtracking path_matcher
+  std::shared_ptr<const PathAutomaton> automaton_;
 
   void Dump() const;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace cas {
+
+
+// A fixed-size pool of worker threads that execute tasks in FIFO order.
+class ThreadPool {
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+
+public:
+  explicit ThreadPool(size_t nr_threads);
+  ~ThreadPool();
+
+  /* delete copy/move constructors/assignments */
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool(ThreadPool&& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+  ThreadPool& operator=(ThreadPool&& other) = delete;
+
+  template<class F>
+  auto Submit(F&& function) -> std::future<decltype(function())> {
+    using T = decltype(function());
+    auto task = std::make_shared<std::packaged_task<T()>>(std::forward<F>(function));
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> guard{mutex_};
+      tasks_.emplace_back([task]() { (*task)(); });
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+  size_t NrThreads() const { return workers_.size(); }
+
+private:
+  void Work();
+  bool RunPendingTask();
+};
+
+
+} // namespace cas
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "cas/path_matcher.hpp"
+#include "cas/query.hpp"
+#include "cas/query_engine.hpp"
+#include "cas/query_stats.hpp"
+#include "cas/search_key.hpp"
+#include "cas/types.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+
+namespace cas {
+
+
+// Evaluates a query and emits its k smallest (QueryOrder::ValueAsc) or
+// largest (QueryOrder::ValueDesc) matches by value, in this order.
+//
+// Values are byte-comparable (see KeyEncoder::EncodeValue), i.e., all
+// values in the subtree of a node start with the node's value prefix.
+// The prefix thus bounds the values of the subtree: from below for
+// ascending order and, padded with 0xFF, from above for descending
+// order. The trie is traversed best-first with a heap of the nodes and
+// matches found so far, ordered by these bounds. A match on top of the
+// heap cannot be beaten by any node that has not been read yet, i.e.,
+// the traversal stops after k matches were taken from the heap and
+// only reads the subtrees whose bounds can still qualify.
+//
+// Matches with equal values are emitted in an unspecified order.
+template<class NodeT, class Emitter>
+class TopKQuery {
+  using Access = NodeAccess<NodeT>;
+  using Handle = typename Access::Handle;
+
+  struct State {
+    // length of the prefixes matched so far
+    uint16_t len_pat_ = 0;
+    uint16_t len_val_ = 0;
+    // state needed for the path matching
+    path_matcher::State pm_state_;
+    // state needed for the value matching
+    uint16_t vl_pos_ = 0;
+    uint16_t vh_pos_ = 0;
+    int depth_ = 0;
+  };
+
+  // an inner node whose prefixes matched (with its range of qualifying
+  // child bytes) or a match; both keep a copy of their prefixes
+  struct Entry {
+    std::optional<Handle> node_;
+    State state_;
+    std::vector<std::byte> path_;
+    std::vector<std::byte> value_;
+    cas::ref_t ref_;
+    uint8_t low_ = 0x00;
+    uint8_t high_ = 0xFF;
+
+    bool IsMatch() const {
+      return !node_.has_value();
+    }
+  };
+
+  const NodeT* root_;
+  const BinarySK& key_;
+  Emitter& emitter_;
+  const size_t k_;
+  const bool descending_;
+  std::unique_ptr<QueryBuffer> buf_pat_;
+  std::unique_ptr<QueryBuffer> buf_val_;
+  std::vector<Entry> heap_;
+  QueryStats stats_;
+
+public:
+  TopKQuery(const NodeT* root, const BinarySK& key, Emitter& emitter,
+      size_t k, QueryOrder order);
+
+  void Execute();
+
+  const QueryStats& Stats() const {
+    return stats_;
+  }
+
+private:
+  void Read(const Handle& handle, State& s);
+  void Expand(const Entry& entry);
+  void PushEntry(Entry&& entry);
+  bool Precedes(const Entry& a, const Entry& b) const;
+  void UpdateStats(cas::Dimension dimension);
+};
+
+
+} // namespace cas
+
+
+template<class NodeT, class Emitter>
+cas::TopKQuery<NodeT, Emitter>::TopKQuery(
+        const NodeT* root,
+        const BinarySK& key,
+        Emitter& emitter,
+        size_t k,
+        QueryOrder order)
+    : root_(root)
+    , key_(key)
+    , emitter_(emitter)
+    , k_(k)
+    , descending_(order == QueryOrder::ValueDesc)
+    , buf_pat_(std::make_unique<QueryBuffer>())
+    , buf_val_(std::make_unique<QueryBuffer>())
+{
+  if (order == QueryOrder::Unordered) {
+    throw std::runtime_error{"TopKQuery requires an order by value"};
+  }
+}
+
+
+template<class NodeT, class Emitter>
+void cas::TopKQuery<NodeT, Emitter>::Execute() {
+  const auto& t_start = std::chrono::high_resolution_clock::now();
+  if (root_ != nullptr && k_ > 0) {
+    State initial_state;
+    Read(Access::Root(root_), initial_state);
+  }
+
+  auto comparator = [this](const Entry& a, const Entry& b) {
+    return Precedes(b, a);
+  };
+  size_t nr_emitted = 0;
+  while (!heap_.empty() && nr_emitted < k_) {
+    std::pop_heap(heap_.begin(), heap_.end(), comparator);
+    Entry entry = std::move(heap_.back());
+    heap_.pop_back();
+    if (entry.IsMatch()) {
+      const State& s = entry.state_;
+      std::memcpy(buf_pat_->data(), entry.path_.data(), s.len_pat_);
+      std::memcpy(buf_val_->data(), entry.value_.data(), s.len_val_);
+      ++stats_.nr_matches_;
+      stats_.sum_depth_ += s.depth_;
+      ++nr_emitted;
+      emitter_(*buf_pat_, s.len_pat_, *buf_val_, s.len_val_, entry.ref_);
+    } else {
+      Expand(entry);
+    }
+  }
+  heap_.clear();
+
+  const auto& t_end = std::chrono::high_resolution_clock::now();
+  stats_.runtime_mus_ +=
+    std::chrono::duration_cast<std::chrono::microseconds>(t_end-t_start).count();
+}
+
+
+// reads the qualifying children of an inner node
+template<class NodeT, class Emitter>
+void cas::TopKQuery<NodeT, Emitter>::Expand(const Entry& entry) {
+  const NodeT& node = Access::Get(*entry.node_);
+  const State& state = entry.state_;
+  std::memcpy(buf_pat_->data(), entry.path_.data(), state.len_pat_);
+  std::memcpy(buf_val_->data(), entry.value_.data(), state.len_val_);
+
+  auto cursor = Access::FirstChild(node, entry.low_);
+  uint8_t byte = 0;
+  while (auto child = Access::NextChild(node, cursor, entry.high_, byte)) {
+    State s = state;
+    if (Access::Dimension(node) == cas::Dimension::PATH) {
+      (*buf_pat_)[s.len_pat_++] = static_cast<std::byte>(byte);
+    } else {
+      (*buf_val_)[s.len_val_++] = static_cast<std::byte>(byte);
+    }
+    ++s.depth_;
+    Read(*child, s);
+  }
+}
+
+
+// matches the prefixes of a node; leaves are evaluated right away and
+// their matches pushed, inner nodes are pushed if they can contain matches
+template<class NodeT, class Emitter>
+void cas::TopKQuery<NodeT, Emitter>::Read(const Handle& handle, State& s) {
+  const NodeT& node = Access::Get(handle);
+  cas::Dimension dimension = Access::Dimension(node);
+  UpdateStats(dimension);
+
+  // the parent's byte has already been appended
+  size_t len_p = Access::LenPath(node);
+  size_t len_v = Access::LenValue(node);
+  std::memcpy(&buf_pat_->at(s.len_pat_), Access::Path(node),  len_p);
+  std::memcpy(&buf_val_->at(s.len_val_), Access::Value(node), len_v);
+  s.len_pat_ += len_p;
+  s.len_val_ += len_v;
+
+  auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key_,
+      s.len_pat_, s.pm_state_);
+  auto match_val = Query::MatchValue(key_, *buf_val_, s.len_val_,
+      s.vl_pos_, s.vh_pos_);
+  if (match_pat == path_matcher::PrefixMatch::MISMATCH ||
+      match_val == path_matcher::PrefixMatch::MISMATCH) {
+    return;
+  }
+
+  if (dimension == cas::Dimension::LEAF) {
+    auto cursor = Access::FirstSuffix(node);
+    while (Access::NextSuffix(node, cursor, [&](
+          size_t len_p, const uint8_t* path,
+          size_t len_v, const uint8_t* value,
+          cas::ref_t ref) {
+      State m = s;
+      if (len_p > 0) {
+        std::memcpy(&buf_pat_->at(m.len_pat_), path, len_p);
+      }
+      if (len_v > 0) {
+        std::memcpy(&buf_val_->at(m.len_val_), value, len_v);
+      }
+      m.len_pat_ += len_p;
+      m.len_val_ += len_v;
+      auto match_pat = path_matcher::MatchPathIncremental(*buf_pat_, key_,
+          m.len_pat_, m.pm_state_);
+      auto match_val = Query::MatchValue(key_, *buf_val_, m.len_val_,
+          m.vl_pos_, m.vh_pos_);
+      if (match_pat == path_matcher::PrefixMatch::MATCH &&
+          match_val == path_matcher::PrefixMatch::MATCH) {
+        Entry entry;
+        entry.state_ = m;
+        entry.path_.assign(buf_pat_->begin(), buf_pat_->begin() + m.len_pat_);
+        entry.value_.assign(buf_val_->begin(), buf_val_->begin() + m.len_val_);
+        entry.ref_ = ref;
+        PushEntry(std::move(entry));
+      }
+    })) {
+    }
+    return;
+  }
+  if (match_pat == path_matcher::PrefixMatch::MATCH &&
+      match_val == path_matcher::PrefixMatch::MATCH) {
+    throw std::runtime_error{"an inner node cannot MATCH"};
+  }
+
+  std::byte low;
+  std::byte high;
+  if (dimension == cas::Dimension::PATH) {
+    Query::PathChildRange(key_, s.pm_state_, low, high);
+  } else {
+    Query::ValueChildRange(key_, s.len_val_, s.vl_pos_, s.vh_pos_, low, high);
+  }
+  Entry entry;
+  entry.node_ = handle;
+  entry.state_ = s;
+  entry.path_.assign(buf_pat_->begin(), buf_pat_->begin() + s.len_pat_);
+  entry.value_.assign(buf_val_->begin(), buf_val_->begin() + s.len_val_);
+  entry.low_ = static_cast<uint8_t>(low);
+  entry.high_ = static_cast<uint8_t>(high);
+  PushEntry(std::move(entry));
+}
+
+
+template<class NodeT, class Emitter>
+void cas::TopKQuery<NodeT, Emitter>::PushEntry(Entry&& entry) {
+  heap_.push_back(std::move(entry));
+  std::push_heap(heap_.begin(), heap_.end(), [this](const Entry& a, const Entry& b) {
+    return Precedes(b, a);
+  });
+}
+
+
+// true if a needs to be taken from the heap before b
+template<class NodeT, class Emitter>
+bool cas::TopKQuery<NodeT, Emitter>::Precedes(const Entry& a, const Entry& b) const {
+  size_t len_a = a.value_.size();
+  size_t len_b = b.value_.size();
+  for (size_t i = 0, len = std::min(len_a, len_b); i < len; ++i) {
+    if (a.value_[i] != b.value_[i]) {
+      return descending_
+        ? a.value_[i] > b.value_[i]
+        : a.value_[i] < b.value_[i];
+    }
+  }
+  if (len_a == len_b) {
+    // a match cannot be beaten by a node with the same bound
+    return a.IsMatch() && !b.IsMatch();
+  }
+  // one value is a proper prefix of the other: in ascending order it is
+  // smaller; in descending order the prefix of a node (padded with 0xFF)
+  // is greater, but a shorter value of a match is smaller
+  const Entry& shorter = len_a < len_b ? a : b;
+  bool shorter_first = !descending_ || !shorter.IsMatch();
+  return (len_a < len_b) == shorter_first;
+}
+
+
+template<class NodeT, class Emitter>
+void cas::TopKQuery<NodeT, Emitter>::UpdateStats(cas::Dimension dimension) {
+  ++stats_.read_nodes_;
+  switch (dimension) {
+  case cas::Dimension::PATH:
+    ++stats_.read_path_nodes_;
+    break;
+  case cas::Dimension::VALUE:
+    ++stats_.read_value_nodes_;
+    break;
+  case cas::Dimension::LEAF:
+    ++stats_.read_leaf_nodes_;
+    break;
+  }
+}
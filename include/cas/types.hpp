@@ -8,13 +8,23 @@
 
 namespace cas {
 
-// info about memory pages used in bulk-loding
+// info about memory pages used in bulk-loding, PAGE_SZ is the default
+// of Context::page_size_
+const size_t PAGE_SZ_1MB   = 1l << 20;
+const size_t PAGE_SZ_256KB = 1l << 18;
 const size_t PAGE_SZ_64KB  = 1l << 16;
 const size_t PAGE_SZ_32KB  = 1l << 15;
 const size_t PAGE_SZ_16KB  = 1l << 14;
 const size_t PAGE_SZ_8KB   = 1l << 13;
 const size_t PAGE_SZ_4KB   = 1l << 12;
 const size_t PAGE_SZ        = PAGE_SZ_16KB;
+// pages are aligned for O_DIRECT
+const size_t PAGE_SZ_MIN    = PAGE_SZ_4KB;
+const size_t PAGE_SZ_MAX    = PAGE_SZ_1MB;
+
+// throws if page_size is not a multiple of PAGE_SZ_MIN
+// between PAGE_SZ_MIN and PAGE_SZ_MAX
+void CheckPageSize(size_t page_size);
 
 // info about index pages
 using page_nr_t = size_t;
@@ -56,9 +66,64 @@ enum class DscComputation {
   Proactive,
 };
 
+// access pattern hint (madvise) for memory-mapped index files
+enum class IndexAdvice {
+  Normal,
+  Random,
+  Sequential,
+  WillNeed,
+};
+
+// layout of the children of a serialized inner node
+enum class NodeFormat {
+  Interleaved, // per child: byte + 48-bit pointer
+  KeyArray,    // all bytes, then all 48-bit pointers
+};
+
+// order in which the matches of a query are emitted
+enum class QueryOrder {
+  Unordered, // traversal order
+  ValueAsc,
+  ValueDesc,
+};
+
+// layout of the keys in a MemoryPage
+enum class PageFormat {
+  Plain,      // complete keys
+  FrontCoded, // keys share a prefix with their predecessor
+};
+
+// compression of the pages in partition files
+enum class Compression {
+  None,
+  Lz4,
+  Zstd,
+};
+
+// backing of the memory pools (see MemoryBacking)
+enum class HugePages {
+  None,        // base pages of the OS
+  Transparent, // madvise(MADV_HUGEPAGE)
+  Explicit,    // MAP_HUGETLB, needs reserved huge pages
+};
+
+// implementation of the longest common prefix (see CommonPrefix)
+enum class PrefixKernel {
+  Scalar, // 8 bytes per step
+  Sse2,   // 16 bytes per step
+  Avx2,   // 32 bytes per step
+};
+
 
 std::string ToString(MemoryPlacement v);
 std::string ToString(DscComputation v);
+std::string ToString(IndexAdvice v);
+std::string ToString(NodeFormat v);
+std::string ToString(QueryOrder v);
+std::string ToString(PageFormat v);
+std::string ToString(Compression v);
+std::string ToString(PrefixKernel v);
+std::string ToString(HugePages v);
 
 //page buffer
 const int query_buffer = 10000;
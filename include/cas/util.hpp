@@ -38,6 +38,66 @@ inline std::pair<uint16_t, uint16_t> DecodeSizes(uint16_t value) {
 }
 
 
+// LEB128: 7 bits per byte, the highest bit marks that more bytes follow
+inline size_t VarintSize(size_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+
+template<class Byte>
+inline Byte* WriteVarint(Byte* dst, size_t value) {
+  while (value >= 0x80) {
+    *dst++ = static_cast<Byte>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  *dst++ = static_cast<Byte>(value);
+  return dst;
+}
+
+
+template<class Byte>
+inline const Byte* ReadVarint(const Byte* src, size_t& value) {
+  value = 0;
+  int shift = 0;
+  uint8_t byte;
+  do {
+    byte = static_cast<uint8_t>(*src++);
+    value |= static_cast<size_t>(byte & 0x7F) << shift;
+    shift += 7;
+  } while ((byte & 0x80) != 0);
+  return src;
+}
+
+
+// child pointers relative to their node: the big-endian distance of
+// width bytes from node_pos to ptr, children follow their parent
+inline uint8_t* WriteRelativePointer(uint8_t* dst,
+    size_t node_pos, size_t ptr, int width) {
+  size_t delta = ptr - node_pos;
+  if (ptr < node_pos || (width < 8 && (delta >> (8 * width)) != 0)) {
+    throw std::runtime_error{"relative pointer exceeds its width"};
+  }
+  for (int shift = 8 * (width - 1); shift >= 0; shift -= 8) {
+    *dst++ = static_cast<uint8_t>((delta >> shift) & 0xFF);
+  }
+  return dst;
+}
+
+
+inline size_t ReadRelativePointer(const uint8_t* src, size_t node_pos, int width) {
+  size_t delta = 0;
+  for (int i = 0; i < width; ++i) {
+    delta = (delta << 8) | src[i];
+  }
+  return node_pos + delta;
+}
+
+
 void DumpHexValues(const std::vector<std::byte>& buffer);
 void DumpHexValues(const std::vector<std::byte>& buffer, size_t size);
 void DumpHexValues(const std::vector<std::byte>& buffer, size_t offset, size_t size);
@@ -51,9 +51,14 @@ void benchmark::ExpDatasetSize<VType>::Execute(size_t dataset_size)
 
 template<class VType>
 void benchmark::ExpDatasetSize<VType>::PrintOutput() {
+  auto ToMs = [](const cas::Timer& timer) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timer.time_).count();
+  };
   std::cout << "\n\n\n";
   cas::util::Log("Summary:\n\n");
-  std::cout << "dataset_size_b;nr_input_keys;runtime_ms;runtime_m;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_gb\n";
+  std::cout << "dataset_size_b;nr_input_keys;runtime_ms;runtime_m;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_gb;"
+    << "io_queue_depth;runtime_disk_read_ms;runtime_disk_write_ms;runtime_io_submit_ms;runtime_io_wait_ms;"
+    << "partition_compression;runtime_compression_ms;runtime_decompression_ms\n";
   int count = 0;
   for (const auto& dataset_size : dataset_sizes_) {
     const auto& stats = results_[count++];
@@ -69,7 +74,15 @@ void benchmark::ExpDatasetSize<VType>::PrintOutput() {
     std::cout << runtime_h << ";";
     std::cout << disk_overhead_b << ";";
     std::cout << disk_overhead_gb << ";";
-    std::cout << stats.DiskIo() / 1'000'000'000.0 << "\n";
+    std::cout << stats.DiskIo() / 1'000'000'000.0 << ";";
+    std::cout << context_.io_queue_depth_ << ";";
+    std::cout << ToMs(stats.runtime_partition_disk_read_) << ";";
+    std::cout << ToMs(stats.runtime_partition_disk_write_) << ";";
+    std::cout << ToMs(stats.runtime_partition_io_submit_) << ";";
+    std::cout << ToMs(stats.runtime_partition_io_wait_) << ";";
+    std::cout << cas::ToString(context_.partition_compression_) << ";";
+    std::cout << ToMs(stats.runtime_partition_compression_) << ";";
+    std::cout << ToMs(stats.runtime_partition_decompression_) << "\n";
   }
 }
 
@@ -1,6 +1,8 @@
 #include "benchmark/exp_dsc_computation.hpp"
 #include "cas/bulk_loader.hpp"
+#include "cas/common_prefix.hpp"
 #include "cas/util.hpp"
+#include <random>
 
 
 template<class VType>
@@ -23,6 +25,7 @@ void benchmark::ExpDscComputation<VType>::Execute() {
       ExecuteMethod(approach, memory_size);
     }
   }
+  BenchmarkPrefixKernels();
   PrintOutput();
 }
 
@@ -55,6 +58,47 @@ void benchmark::ExpDscComputation<VType>::ExecuteMethod(
 }
 
 
+// compares the CommonPrefix kernels on pairs of paths whose common
+// prefixes are as long as those of deep paths in the SWH archive
+template<class VType>
+void benchmark::ExpDscComputation<VType>::BenchmarkPrefixKernels() {
+  const size_t nr_pairs = 1'000'000;
+  const size_t max_len = 256;
+  std::mt19937 rng{42};
+  std::vector<std::byte> a(nr_pairs * max_len);
+  std::vector<std::byte> b(nr_pairs * max_len);
+  std::vector<size_t> lengths(nr_pairs);
+  for (size_t i = 0; i < nr_pairs; ++i) {
+    lengths[i] = 16 + rng() % (max_len - 16);
+    size_t lcp = rng() % (lengths[i] + 1);
+    for (size_t j = 0; j < max_len; ++j) {
+      a[i * max_len + j] = static_cast<std::byte>(rng());
+      b[i * max_len + j] = j < lcp
+        ? a[i * max_len + j]
+        : ~a[i * max_len + j];
+    }
+  }
+
+  for (auto kernel : {cas::PrefixKernel::Scalar,
+                      cas::PrefixKernel::Sse2,
+                      cas::PrefixKernel::Avx2}) {
+    if (!cas::IsSupported(kernel)) {
+      continue;
+    }
+    KernelResult result{kernel};
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < nr_pairs; ++i) {
+      size_t lcp = cas::CommonPrefix(kernel,
+          &a[i * max_len], &b[i * max_len], lengths[i]);
+      result.bytes_compared_ += lcp + (lcp < lengths[i]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.runtime_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+    kernel_results_.push_back(result);
+  }
+}
+
+
 /* template<class VType> */
 /* void benchmark::ExpDscComputation<VType>::PrintOutput() { */
 /*   std::cout << "\n\n\n"; */
@@ -79,7 +123,7 @@ template<class VType>
 void benchmark::ExpDscComputation<VType>::PrintOutput() {
   std::cout << "\n\n\n";
   cas::util::Log("Summary:\n\n");
-  std::cout << "approach;memory_size_;runtime_ms;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_b;disk_io_gb\n";
+  std::cout << "approach;memory_size_;runtime_ms;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_b;disk_io_gb;dsc_bytes_compared;dsc_runtime_ms\n";
   int count = 0;
   for (const auto& memory_size : memory_sizes_) {
     for (const auto& approach : approaches_) {
@@ -96,9 +140,24 @@ void benchmark::ExpDscComputation<VType>::PrintOutput() {
       std::cout << disk_overhead_b << ";";
       std::cout << disk_overhead_gb << ";";
       std::cout << stats.DiskIo() << ";";
-      std::cout << disk_io_gb << "\n";
+      std::cout << disk_io_gb << ";";
+      std::cout << stats.dsc_bytes_compared_ << ";";
+      std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+          stats.runtime_dsc_computation_.time_).count() << "\n";
     }
   }
+
+  std::cout << "\nPrefix kernels (active: "
+    << cas::ToString(cas::ActivePrefixKernel()) << "):\n";
+  std::cout << "kernel;bytes_compared;runtime_ms;bytes_per_s\n";
+  for (const auto& result : kernel_results_) {
+    double bytes_per_s = result.runtime_ms_ == 0 ? 0
+      : result.bytes_compared_ / (result.runtime_ms_ / 1000);
+    std::cout << std::fixed << cas::ToString(result.kernel_) << ";"
+      << result.bytes_compared_ << ";"
+      << result.runtime_ms_ << ";"
+      << bytes_per_s << "\n";
+  }
   std::cout << "\n\n\n";
 }
 
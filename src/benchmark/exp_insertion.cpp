@@ -1,6 +1,7 @@
 #include "benchmark/exp_insertion.hpp"
 #include "cas/bulk_loader.hpp"
 #include "cas/index.hpp"
+#include "cas/partition_header.hpp"
 #include "cas/util.hpp"
 #include <filesystem>
 #include <sstream>
@@ -32,10 +33,11 @@ void benchmark::ExpInsertion<VType>::Execute(double bulkload_fraction)
   auto context_copy = context_;
   size_t file_size = context_copy.dataset_size_ > 0
     ? context_copy.dataset_size_
-    : std::filesystem::file_size(context_copy.input_filename_);
-  size_t nr_total_pages = file_size / cas::PAGE_SZ;
+    : std::filesystem::file_size(context_copy.input_filename_)
+      - cas::PartitionHeader::Read(context_copy.input_filename_).ByteSize();
+  size_t nr_total_pages = file_size / context_copy.page_size_;
   size_t nr_pages_bulkload = nr_total_pages * bulkload_fraction;
-  context_copy.dataset_size_ = nr_pages_bulkload * cas::PAGE_SZ;
+  context_copy.dataset_size_ = nr_pages_bulkload * context_copy.page_size_;
 
   cas::Index<VType> index{context_copy};
   index.ClearPipelineFiles();
@@ -52,10 +54,11 @@ void benchmark::ExpInsertion<VType>::Execute(double bulkload_fraction)
 
   // prepare cursor to read remaining keys
   cas::Partition partition{context_copy.input_filename_, index.Stats(), context_copy};
+  partition.IsRootPartition(true);
   partition.FptrCursorFirstPageNr(nr_pages_bulkload);
   std::vector<std::byte> page_buffer;
-  page_buffer.resize(cas::PAGE_SZ);
-  cas::MemoryPage io_page{&page_buffer[0]};
+  page_buffer.resize(partition.PageSize());
+  cas::MemoryPage io_page{&page_buffer[0], partition.PageSize()};
   auto cursor = partition.Cursor(io_page);
 
   // insert remaining keys
@@ -1,6 +1,7 @@
 #include "benchmark/exp_mem_insertion.hpp"
 #include "cas/bulk_loader.hpp"
 #include "cas/index.hpp"
+#include "cas/partition_header.hpp"
 #include "cas/util.hpp"
 #include "cas/mem/insertion.hpp"
 #include <filesystem>
@@ -24,11 +25,13 @@ void benchmark::ExpMemInsertion<VType>::Execute() {
   cas::Context context;
 
   // prepare cursor to read remaining keys
+  context.page_size_ = cas::PartitionHeader::Read(dataset_path_).page_size_;
   cas::Partition partition{dataset_path_, stats, context};
+  partition.IsRootPartition(true);
   partition.FptrCursorFirstPageNr(0);
   std::vector<std::byte> page_buffer;
-  page_buffer.resize(cas::PAGE_SZ);
-  cas::MemoryPage io_page{&page_buffer[0]};
+  page_buffer.resize(partition.PageSize());
+  cas::MemoryPage io_page{&page_buffer[0], partition.PageSize()};
   auto cursor = partition.Cursor(io_page);
 
   // root of the in-memory RCAS index
@@ -1,6 +1,7 @@
 #include "benchmark/exp_memory_keys.hpp"
 #include "cas/bulk_loader.hpp"
 #include "cas/index.hpp"
+#include "cas/partition_header.hpp"
 #include "cas/util.hpp"
 #include <filesystem>
 #include <sstream>
@@ -43,15 +44,17 @@ void benchmark::ExpMemoryKeys<VType>::Execute(size_t nr_memory_keys)
 
   // prepare cursor to read remaining keys
   cas::Partition partition{context_copy.input_filename_, index.Stats(), context_copy};
+  partition.IsRootPartition(true);
   std::vector<std::byte> page_buffer;
-  page_buffer.resize(cas::PAGE_SZ);
-  cas::MemoryPage io_page{&page_buffer[0]};
+  page_buffer.resize(partition.PageSize());
+  cas::MemoryPage io_page{&page_buffer[0], partition.PageSize()};
   auto cursor = partition.Cursor(io_page);
 
   size_t file_size = context_copy.dataset_size_ > 0
     ? context_copy.dataset_size_
-    : std::filesystem::file_size(context_copy.input_filename_);
-  size_t nr_total_pages = file_size / cas::PAGE_SZ;
+    : std::filesystem::file_size(context_copy.input_filename_)
+      - cas::PartitionHeader::Read(context_copy.input_filename_).ByteSize();
+  size_t nr_total_pages = file_size / context_copy.page_size_;
 
   // insert remaining keys
   auto start = std::chrono::high_resolution_clock::now();
@@ -7,10 +7,14 @@ template<class VType>
 benchmark::ExpMemoryManagement<VType>::ExpMemoryManagement(
       const cas::Context& context,
       const std::vector<cas::MemoryPlacement>& approaches,
-      const std::vector<size_t>& memory_sizes)
+      const std::vector<cas::PageFormat>& page_formats,
+      const std::vector<size_t>& memory_sizes,
+      const std::vector<size_t>& write_behind_pages)
   : context_(context)
   , approaches_(approaches)
+  , page_formats_(page_formats)
   , memory_sizes_(memory_sizes)
+  , write_behind_pages_(write_behind_pages)
 {
 }
 
@@ -20,7 +24,11 @@ void benchmark::ExpMemoryManagement<VType>::Execute() {
   cas::util::Log("Experiment ExpMemoryManagement\n\n");
   for (const auto& memory_size : memory_sizes_) {
     for (const auto& approach : approaches_) {
-      ExecuteMethod(approach, memory_size);
+       for (const auto& page_format : page_formats_) {
+          for (const auto& write_behind_pages : write_behind_pages_) {
+            ExecuteMethod(approach, page_format, memory_size, write_behind_pages);
+          }
+       }
     }
   }
   PrintOutput();
@@ -29,12 +37,17 @@ void benchmark::ExpMemoryManagement<VType>::Execute() {
 
 template<class VType>
 void benchmark::ExpMemoryManagement<VType>::ExecuteMethod(
-      cas::MemoryPlacement method, size_t memory_size)
+      cas::MemoryPlacement method,
+      cas::PageFormat page_format,
+      size_t memory_size,
+      size_t write_behind_pages)
 {
   // copy the context;
   auto context = context_;
   context.memory_placement_ = method;
+  context.page_format_ = page_format;
   context.mem_size_bytes_ = memory_size;
+  context.write_behind_pages_ = write_behind_pages;
 
   // print input
   cas::util::Log("Configuration\n");
@@ -59,24 +72,42 @@ template<class VType>
 void benchmark::ExpMemoryManagement<VType>::PrintOutput() {
   std::cout << "\n\n\n";
   cas::util::Log("Summary:\n\n");
-  std::cout << "approach;memory_size_;runtime_ms;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_b;disk_io_gb\n";
+  std::cout << "approach;page_format;memory_size_;runtime_ms;runtime_h;disk_overhead_b;disk_overhead_gb;disk_io_b;disk_io_gb;partition_bytes_read;partition_bytes_written;"
+    << "partition_compression;runtime_compression_ms;runtime_decompression_ms;"
+    << "write_behind_pages;runtime_disk_write_ms;partition_write_requests\n";
   int count = 0;
   for (const auto& memory_size : memory_sizes_) {
     for (const auto& approach : approaches_) {
-      const auto& stats = results_[count++];
-      auto runtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stats.runtime_.time_).count();
-      auto runtime_h  = runtime_ms / (1000.0 * 60.0 * 60.0);
-      auto disk_overhead_b  = stats.IoOverhead();
-      auto disk_overhead_gb = disk_overhead_b / 1'000'000'000.0;
-      auto disk_io_gb = stats.DiskIo() / 1'000'000'000.0;
-      std::cout << cas::ToString(approach) << ";";
-      std::cout << memory_size << ";";
-      std::cout << runtime_ms << ";";
-      std::cout << runtime_h << ";";
-      std::cout << disk_overhead_b << ";";
-      std::cout << disk_overhead_gb << ";";
-      std::cout << stats.DiskIo() << ";";
-      std::cout << disk_io_gb << "\n";
+      for (const auto& page_format : page_formats_) {
+        for (const auto& write_behind_pages : write_behind_pages_) {
+          const auto& stats = results_[count++];
+          auto runtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stats.runtime_.time_).count();
+          auto runtime_h  = runtime_ms / (1000.0 * 60.0 * 60.0);
+          auto disk_overhead_b  = stats.IoOverhead();
+          auto disk_overhead_gb = disk_overhead_b / 1'000'000'000.0;
+          auto disk_io_gb = stats.DiskIo() / 1'000'000'000.0;
+          std::cout << cas::ToString(approach) << ";";
+          std::cout << cas::ToString(page_format) << ";";
+          std::cout << memory_size << ";";
+          std::cout << runtime_ms << ";";
+          std::cout << runtime_h << ";";
+          std::cout << disk_overhead_b << ";";
+          std::cout << disk_overhead_gb << ";";
+          std::cout << stats.DiskIo() << ";";
+          std::cout << disk_io_gb << ";";
+          std::cout << stats.partition_bytes_read_ << ";";
+          std::cout << stats.partition_bytes_written_ << ";";
+          std::cout << cas::ToString(context_.partition_compression_) << ";";
+          std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+              stats.runtime_partition_compression_.time_).count() << ";";
+          std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+              stats.runtime_partition_decompression_.time_).count() << ";";
+          std::cout << write_behind_pages << ";";
+          std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+              stats.runtime_partition_disk_write_.time_).count() << ";";
+          std::cout << stats.partition_write_requests_ << "\n";
+        }
+      }
     }
   }
   std::cout << "\n\n\n";
@@ -0,0 +1,89 @@
+#include "benchmark/exp_page_size.hpp"
+#include "cas/bulk_loader.hpp"
+#include "cas/util.hpp"
+
+
+template<class VType>
+benchmark::ExpPageSize<VType>::ExpPageSize(
+      const cas::Context& context,
+      const std::vector<size_t>& page_sizes)
+  : context_(context)
+  , page_sizes_(page_sizes)
+{
+}
+
+
+template<class VType>
+void benchmark::ExpPageSize<VType>::Execute() {
+  cas::util::Log("Experiment ExpPageSize\n\n");
+  for (const auto& page_size : page_sizes_) {
+    Execute(page_size);
+  }
+  PrintOutput();
+}
+
+
+template<class VType>
+void benchmark::ExpPageSize<VType>::Execute(size_t page_size)
+{
+  // copy the context;
+  auto context = context_;
+  context.page_size_ = page_size;
+  context.input_filename_ = InputFilename(page_size);
+
+  // print input
+  cas::util::Log("Configuration\n");
+  context.Dump();
+  std::cout << "\n" << std::flush;
+
+  // run benchmark
+  cas::BulkLoaderStats stats;
+  cas::BulkLoader<VType> bulk_loader{context, stats};
+  bulk_loader.Load();
+
+  // print output
+  cas::util::Log("Output:\n\n");
+  stats.Dump();
+  std::cout << "\n\n\n";
+
+  results_.push_back(stats);
+}
+
+
+template<class VType>
+std::string benchmark::ExpPageSize<VType>::InputFilename(
+    size_t page_size) const {
+  return context_.input_filename_ + "." + std::to_string(page_size);
+}
+
+
+template<class VType>
+void benchmark::ExpPageSize<VType>::PrintOutput() {
+  auto ToMs = [](const cas::Timer& timer) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timer.time_).count();
+  };
+  std::cout << "\n\n\n";
+  cas::util::Log("Summary:\n\n");
+  std::cout << "page_size;nr_input_keys;runtime_ms;runtime_partitioning_ms;runtime_construction_ms;"
+    << "disk_overhead_b;disk_io_gb;partition_bytes_read;partition_bytes_written;"
+    << "partition_write_requests;runtime_disk_read_ms;runtime_disk_write_ms;index_bytes_written\n";
+  int count = 0;
+  for (const auto& page_size : page_sizes_) {
+    const auto& stats = results_[count++];
+    std::cout << page_size << ";";
+    std::cout << stats.nr_input_keys_ << ";";
+    std::cout << ToMs(stats.runtime_) << ";";
+    std::cout << ToMs(stats.runtime_partitioning_) << ";";
+    std::cout << ToMs(stats.runtime_construction_) << ";";
+    std::cout << stats.IoOverhead() << ";";
+    std::cout << stats.DiskIo() / 1'000'000'000.0 << ";";
+    std::cout << stats.partition_bytes_read_ << ";";
+    std::cout << stats.partition_bytes_written_ << ";";
+    std::cout << stats.partition_write_requests_ << ";";
+    std::cout << ToMs(stats.runtime_partition_disk_read_) << ";";
+    std::cout << ToMs(stats.runtime_partition_disk_write_) << ";";
+    std::cout << stats.index_bytes_written_ << "\n";
+  }
+}
+
+template class benchmark::ExpPageSize<cas::vint64_t>;
@@ -0,0 +1,75 @@
+#include "benchmark/exp_parallel_construction.hpp"
+#include "cas/bulk_loader.hpp"
+#include "cas/util.hpp"
+
+
+template<class VType>
+benchmark::ExpParallelConstruction<VType>::ExpParallelConstruction(
+      const cas::Context& context,
+      const std::vector<size_t>& thread_counts)
+  : context_(context)
+  , thread_counts_(thread_counts)
+{
+}
+
+
+template<class VType>
+void benchmark::ExpParallelConstruction<VType>::Execute() {
+  cas::util::Log("Experiment ExpParallelConstruction\n\n");
+  for (const auto& nr_threads : thread_counts_) {
+    Execute(nr_threads);
+  }
+  PrintOutput();
+}
+
+
+template<class VType>
+void benchmark::ExpParallelConstruction<VType>::Execute(size_t nr_threads)
+{
+  // copy the context;
+  auto context = context_;
+  context.nr_threads_ = nr_threads;
+
+  // print input
+  cas::util::Log("Configuration\n");
+  context.Dump();
+  std::cout << "\n" << std::flush;
+
+  // run benchmark
+  cas::BulkLoaderStats stats;
+  cas::BulkLoader<VType> bulk_loader{context, stats};
+  bulk_loader.Load();
+
+  // print output
+  cas::util::Log("Output:\n\n");
+  stats.Dump();
+  std::cout << "\n\n\n" << std::flush;
+
+  results_.push_back(stats);
+}
+
+
+template<class VType>
+void benchmark::ExpParallelConstruction<VType>::PrintOutput() {
+  std::cout << "\n\n\n";
+  cas::util::Log("Summary:\n\n");
+  std::cout << "nr_threads;runtime_ms;runtime_construction_ms;speedup;disk_io_gb\n";
+  // speedup is relative to the first configuration
+  double baseline_ms = results_.empty() ? 0 :
+    std::chrono::duration_cast<std::chrono::milliseconds>(results_[0].runtime_.time_).count();
+  int count = 0;
+  for (const auto& nr_threads : thread_counts_) {
+    const auto& stats = results_[count++];
+    auto runtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stats.runtime_.time_).count();
+    auto construction_ms = std::chrono::duration_cast<std::chrono::milliseconds>(stats.runtime_construction_.time_).count();
+    double speedup = runtime_ms > 0 ? baseline_ms / runtime_ms : 0;
+    std::cout << nr_threads << ";";
+    std::cout << runtime_ms << ";";
+    std::cout << construction_ms << ";";
+    std::cout << speedup << ";";
+    std::cout << stats.DiskIo() / 1'000'000'000.0 << "\n";
+  }
+  std::cout << "\n\n\n";
+}
+
+template class benchmark::ExpParallelConstruction<cas::vint64_t>;
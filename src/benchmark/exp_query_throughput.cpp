@@ -0,0 +1,112 @@
+#include "benchmark/exp_query_throughput.hpp"
+#include "cas/index.hpp"
+#include "cas/key_encoder.hpp"
+#include "cas/query_service.hpp"
+#include "cas/util.hpp"
+#include <atomic>
+#include <thread>
+
+
+template<class VType>
+benchmark::ExpQueryThroughput<VType>::ExpQueryThroughput(
+      const std::string& pipeline_dir,
+      const std::vector<cas::SearchKey<VType>>& queries,
+      const std::vector<size_t>& client_counts,
+      size_t nr_workers,
+      int nr_repetitions)
+  : pipeline_dir_(pipeline_dir)
+  , client_counts_(client_counts)
+  , nr_workers_(nr_workers)
+  , nr_repetitions_(nr_repetitions)
+{
+  bool reverse_paths = false;
+  for (const auto& query : queries) {
+    encoded_queries_.push_back(cas::KeyEncoder<VType>::Encode(query, reverse_paths));
+  }
+}
+
+
+template<class VType>
+void benchmark::ExpQueryThroughput<VType>::Execute() {
+  cas::util::Log("Experiment ExpQueryThroughput\n");
+  std::cout << "pipeline_dir: " << pipeline_dir_ << "\n";
+  std::cout << "nr_queries: " << encoded_queries_.size() << "\n";
+  std::cout << "nr_workers: " << nr_workers_ << "\n";
+  std::cout << "nr_repetitions: " << nr_repetitions_ << "\n\n";
+  for (const auto& nr_clients : client_counts_) {
+    Execute(nr_clients);
+  }
+  PrintOutput();
+}
+
+
+template<class VType>
+void benchmark::ExpQueryThroughput<VType>::Execute(size_t nr_clients) {
+  cas::Context context;
+  context.pipeline_dir_ = pipeline_dir_;
+  cas::Index<VType> index{context};
+  cas::QueryService<VType> service{index, nr_workers_};
+
+  // map the index files before we take the time
+  service.Query(encoded_queries_.front(), cas::kNullEmitter);
+
+  std::atomic<size_t> nr_queries{0};
+  std::atomic<size_t> nr_matches{0};
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<std::thread> clients;
+  clients.reserve(nr_clients);
+  for (size_t c = 0; c < nr_clients; ++c) {
+    clients.emplace_back([&, c]() {
+      size_t queries = 0;
+      size_t matches = 0;
+      // every client replays the workload from a different offset
+      for (int r = 0; r < nr_repetitions_; ++r) {
+        for (size_t i = 0; i < encoded_queries_.size(); ++i) {
+          const auto& key = encoded_queries_[(c + i) % encoded_queries_.size()];
+          auto stats = nr_workers_ > 0
+            ? service.Submit(key, cas::kNullEmitter).get()
+            : service.Query(key, cas::kNullEmitter);
+          matches += stats.nr_matches_;
+          ++queries;
+        }
+      }
+      nr_queries += queries;
+      nr_matches += matches;
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  Result result;
+  result.nr_clients_ = nr_clients;
+  result.nr_queries_ = nr_queries;
+  result.nr_matches_ = nr_matches;
+  result.runtime_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+  cas::util::Log("nr_clients: " + std::to_string(nr_clients)
+      + ", runtime_ms: " + std::to_string(result.runtime_ms_) + "\n");
+  results_.push_back(result);
+}
+
+
+template<class VType>
+void benchmark::ExpQueryThroughput<VType>::PrintOutput() {
+  std::cout << "\n\n\n";
+  cas::util::Log("Summary:\n\n");
+  std::cout << "nr_clients;nr_workers;nr_queries;nr_matches;runtime_ms;qps\n";
+  for (const auto& result : results_) {
+    double qps = result.runtime_ms_ > 0
+      ? result.nr_queries_ / (result.runtime_ms_ / 1000)
+      : 0;
+    std::cout << result.nr_clients_ << ";";
+    std::cout << nr_workers_ << ";";
+    std::cout << result.nr_queries_ << ";";
+    std::cout << result.nr_matches_ << ";";
+    std::cout << std::fixed << result.runtime_ms_ << ";";
+    std::cout << std::fixed << qps << "\n";
+  }
+  std::cout << "\n\n\n";
+}
+
+template class benchmark::ExpQueryThroughput<cas::vint64_t>;
@@ -1,9 +1,14 @@
 #include "benchmark/exp_querying.hpp"
 #include "cas/key_encoder.hpp"
 #include "cas/index.hpp"
+#include "cas/node_reader.hpp"
 #include "cas/util.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
 
@@ -13,12 +18,24 @@ benchmark::ExpQuerying<VType>::ExpQuerying(
       const std::vector<cas::SearchKey<VType>>& queries,
       bool clear_page_cache,
       bool do_warmup,
-      int nr_repetitions)
+      int nr_repetitions,
+      size_t nr_query_threads,
+      size_t parallel_fanout,
+      bool compare_node_formats,
+      size_t limit,
+      cas::QueryOrder order,
+      size_t batch_size)
   : pipeline_dir_(pipeline_dir)
   , queries_(queries)
   , clear_page_cache_(clear_page_cache)
   , do_warmup_(do_warmup)
   , nr_repetitions_(nr_repetitions)
+  , nr_query_threads_(nr_query_threads)
+  , parallel_fanout_(parallel_fanout)
+  , compare_node_formats_(compare_node_formats)
+  , limit_(limit)
+  , order_(order)
+  , batch_size_(batch_size)
 {
   bool reverse_paths = false;
   for (const auto& query : queries_) {
@@ -31,16 +48,226 @@ template<class VType>
 void benchmark::ExpQuerying<VType>::Execute() {
   cas::util::Log("Experiment ExpQuerying\n");
   std::cout << "pipeline_dir: " << pipeline_dir_ << "\n";
-  std::cout << "clear_page_cache: " << clear_page_cache_ << "\n\n";
+  std::cout << "clear_page_cache: " << clear_page_cache_ << "\n";
+  std::cout << "nr_query_threads: " << nr_query_threads_ << "\n";
+  std::cout << "parallel_fanout: " << parallel_fanout_ << "\n";
+  std::cout << "compare_node_formats: " << compare_node_formats_ << "\n";
+  std::cout << "limit: " << limit_ << "\n";
+  std::cout << "order: " << cas::ToString(order_) << "\n";
+  std::cout << "batch_size: " << batch_size_ << "\n\n";
 
   if (do_warmup_) {
     DoWarmUp();
   }
 
+  // first map the index files for every query, then only once
+  Execute(false, false, latencies_per_query_mapping_);
+  results_.clear();
+  Execute(true, false, latencies_index_reader_);
+  totals_query_ = cas::QueryStats::Sum(results_);
+  results_.clear();
+  // same traversal without virtual calls and std::function callbacks
+  Execute(true, true, latencies_query_engine_);
+  totals_query_engine_ = cas::QueryStats::Sum(results_);
+
+  if (nr_query_threads_ > 0) {
+    ExecuteParallel();
+  }
+
+  if (limit_ > 0) {
+    // the limit is pushed into the traversal, the results per query
+    // are kept from the previous run
+    std::vector<cas::QueryStats> results;
+    std::swap(results, results_);
+    Execute(pipeline_dir_, true, true, latencies_limit_, 0, limit_);
+    totals_limit_ = cas::QueryStats::Sum(results_);
+    std::swap(results, results_);
+  }
+
+  if (batch_size_ > 0) {
+    ExecuteBatches();
+  }
+
+  if (compare_node_formats_) {
+    CompareNodeFormats();
+  }
+
+  PrintOutput();
+}
+
+
+// Query with subtree tasks on a pool of nr_query_threads_, the other
+// passes are sequential such that QueryEngine is actually measured
+template<class VType>
+void benchmark::ExpQuerying<VType>::ExecuteParallel() {
+  std::vector<cas::QueryStats> results;
+  std::swap(results, results_);
+  Execute(pipeline_dir_, true, false, latencies_parallel_, nr_query_threads_);
+  totals_parallel_ = cas::QueryStats::Sum(results_);
+  std::swap(results, results_);
+}
+
+
+// evaluates the queries in batches that share a single traversal
+template<class VType>
+void benchmark::ExpQuerying<VType>::ExecuteBatches() {
   cas::Context context;
   context.pipeline_dir_ = pipeline_dir_;
   cas::Index<VType> index{context};
 
+  for (size_t first = 0; first < encoded_queries_.size(); first += batch_size_) {
+    size_t last = std::min(first + batch_size_, encoded_queries_.size());
+    std::vector<cas::BinarySK> keys{
+      encoded_queries_.begin() + first, encoded_queries_.begin() + last};
+    std::vector<cas::BinaryKeyEmitter> emitters(keys.size(), [](
+        const cas::QueryBuffer& /* path */, size_t /* p_len */,
+        const cas::QueryBuffer& /* value */, size_t /* v_len */,
+        cas::ref_t ref) -> void {
+      cas::ToString(ref);
+    });
+
+    std::vector<cas::QueryStats> repetitions;
+    repetitions.reserve(nr_repetitions_);
+    for (int i = 0; i < nr_repetitions_; ++i) {
+      if (clear_page_cache_) {
+        cas::util::ClearPageCache();
+      }
+      repetitions.push_back(index.QueryBatch(keys, emitters));
+    }
+    totals_batch_ = cas::QueryStats::Sum({
+        totals_batch_, cas::QueryStats::Avg(repetitions)});
+  }
+}
+
+
+// queries copies of the index that are rewritten in either node format
+template<class VType>
+void benchmark::ExpQuerying<VType>::CompareNodeFormats() {
+  namespace fs = std::filesystem;
+  std::vector<cas::QueryStats> results;
+  std::swap(results, results_);
+  for (auto format : {cas::NodeFormat::Interleaved, cas::NodeFormat::KeyArray}) {
+    cas::util::Log("Querying the index with node format " + cas::ToString(format) + "\n");
+    fs::path dir = fs::temp_directory_path() / ("exp_querying_" + cas::ToString(format));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    for (const auto& entry : fs::directory_iterator(pipeline_dir_)) {
+      if (entry.is_regular_file()) {
+        ConvertIndexFile(entry.path().string(),
+            (dir / entry.path().filename()).string(), format);
+      }
+    }
+
+    std::vector<double> latencies;
+    Execute(dir.string() + "/", true, true, latencies, 0);
+    FormatResult result{format};
+    for (const auto& stat : results_) {
+      result.read_nodes_ += stat.read_nodes_;
+      result.runtime_ms_ += stat.runtime_mus_ / 1000;
+    }
+    result.p50_mus_ = Percentile(latencies, 50);
+    result.p99_mus_ = Percentile(latencies, 99);
+    format_results_.push_back(result);
+    results_.clear();
+    fs::remove_all(dir);
+  }
+  std::swap(results, results_);
+}
+
+
+// both formats need the same number of bytes per child, i.e., the
+// nodes can be rewritten in place without relocating any pointers
+template<class VType>
+void benchmark::ExpQuerying<VType>::ConvertIndexFile(
+    const std::string& src,
+    const std::string& dst,
+    cas::NodeFormat format) {
+  std::ifstream in{src, std::ios::binary};
+  std::vector<uint8_t> data{std::istreambuf_iterator<char>(in),
+    std::istreambuf_iterator<char>()};
+  if (!in.good() && !in.eof()) {
+    throw std::runtime_error{"failed to read file '" + src + "'"};
+  }
+  // the dictionary and trailer (if any) are copied unchanged
+  auto layout = cas::IndexLayout::Read(&data[0], data.size());
+  std::vector<uint8_t> children;
+  size_t pos = 0;
+  while (pos < layout.nodes_end_) {
+    cas::NodeReader reader{&data[0], pos, &layout};
+    size_t size = reader.ByteSize();
+    if (reader.IsInnerNode()) {
+      size_t m = reader.NrChildren();
+      size_t width = reader.PointerWidth();
+      children.resize((1 + width) * m);
+      for (size_t i = 0; i < m; ++i) {
+        uint8_t* byte = &data[pos + reader.ChildBytePos(i)];
+        uint8_t* ptr  = &data[pos + reader.ChildPointerPos(i)];
+        if (format == cas::NodeFormat::KeyArray) {
+          children[i] = *byte;
+          std::memcpy(&children[m + width * i], ptr, width);
+        } else {
+          children[(1 + width) * i] = *byte;
+          std::memcpy(&children[(1 + width) * i + 1], ptr, width);
+        }
+      }
+      std::memcpy(&data[pos + reader.ChildBytePos(0)], &children[0], children.size());
+      if (layout.varint_headers_) {
+        data[pos] &= ~cas::NodeReader::VarintHeaderFlags(
+            cas::NodeReader::FormatFlag(cas::NodeFormat::KeyArray));
+        data[pos] |= cas::NodeReader::VarintHeaderFlags(
+            cas::NodeReader::FormatFlag(format));
+      } else {
+        uint32_t header;
+        std::memcpy(&header, &data[pos], sizeof(uint32_t));
+        header &= ~cas::NodeReader::FormatFlag(cas::NodeFormat::KeyArray);
+        header |= cas::NodeReader::FormatFlag(format);
+        std::memcpy(&data[pos], &header, sizeof(uint32_t));
+      }
+    }
+    pos += size;
+  }
+  std::ofstream out{dst, std::ios::binary};
+  out.write(reinterpret_cast<const char*>(data.data()), data.size());
+  if (!out.good()) {
+    throw std::runtime_error{"failed to write file '" + dst + "'"};
+  }
+}
+
+
+template<class VType>
+void benchmark::ExpQuerying<VType>::Execute(
+    bool use_index_reader,
+    bool use_query_engine,
+    std::vector<double>& latencies) {
+  Execute(pipeline_dir_, use_index_reader, use_query_engine, latencies, 0);
+}
+
+
+template<class VType>
+void benchmark::ExpQuerying<VType>::Execute(
+    const std::string& pipeline_dir,
+    bool use_index_reader,
+    bool use_query_engine,
+    std::vector<double>& latencies,
+    size_t nr_query_threads,
+    size_t limit) {
+  if (use_query_engine && nr_query_threads > 0) {
+    // Index::Query would silently fall back to Query
+    throw std::runtime_error{"QueryEngine does not support parallel queries"};
+  }
+  cas::Context context;
+  context.pipeline_dir_ = pipeline_dir;
+  context.use_index_reader_ = use_index_reader;
+  context.use_query_engine_ = use_query_engine;
+  // intra-query parallelism (the pool must outlive the index)
+  std::unique_ptr<cas::ThreadPool> pool;
+  if (nr_query_threads > 0) {
+    pool = std::make_unique<cas::ThreadPool>(nr_query_threads);
+    context.query_parallel_fanout_ = parallel_fanout_;
+  }
+  cas::Index<VType> index{context};
+  index.QueryPool(pool.get());
+
   const cas::BinaryKeyEmitter emitter = [](
       const cas::QueryBuffer& /* path */, size_t /* p_len */,
       const cas::QueryBuffer& /* value */, size_t /* v_len */,
@@ -56,13 +283,31 @@ void benchmark::ExpQuerying<VType>::Execute() {
       if (clear_page_cache_) {
         cas::util::ClearPageCache();
       }
-      auto stats = index.Query(search_key, emitter);
+      auto start = std::chrono::high_resolution_clock::now();
+      auto stats = limit == 0
+        ? index.Query(search_key, emitter)
+        : index.Query(search_key, emitter, limit, order_);
+      auto end = std::chrono::high_resolution_clock::now();
+      latencies.push_back(
+          std::chrono::duration<double, std::micro>(end - start).count());
       repetitions.push_back(stats);
     }
     results_.push_back(cas::QueryStats::Avg(repetitions));
   }
+}
 
-  PrintOutput();
+
+template<class VType>
+double benchmark::ExpQuerying<VType>::Percentile(
+    std::vector<double> values,
+    double percentile) {
+  if (values.empty()) {
+    return 0;
+  }
+  // nearest-rank method
+  std::sort(values.begin(), values.end());
+  auto rank = static_cast<size_t>(std::ceil(percentile / 100 * values.size()));
+  return values[std::max<size_t>(rank, 1) - 1];
 }
 
 
@@ -127,6 +372,83 @@ void benchmark::ExpQuerying<VType>::PrintOutput() {
   std::cout << std::fixed << "read_nodes: " << read_nodes << "\n";
   std::cout << std::fixed << "nr_matches: " << nr_matches << "\n";
 
+  std::cout << "\nEnd-to-end latency per query:\n";
+  std::cout << "index_reader;query_engine;p50_mus;p99_mus\n";
+  std::cout << std::fixed << "0;0;"
+    << Percentile(latencies_per_query_mapping_, 50) << ";"
+    << Percentile(latencies_per_query_mapping_, 99) << "\n";
+  std::cout << std::fixed << "1;0;"
+    << Percentile(latencies_index_reader_, 50) << ";"
+    << Percentile(latencies_index_reader_, 99) << "\n";
+  std::cout << std::fixed << "1;1;"
+    << Percentile(latencies_query_engine_, 50) << ";"
+    << Percentile(latencies_query_engine_, 99) << "\n";
+
+  if (nr_query_threads_ > 0) {
+    std::cout << "\nParallel Query (with IndexReader, query_threads="
+      << nr_query_threads_ << ", parallel_fanout=" << parallel_fanout_ << "):\n";
+    std::cout << "read_nodes;runtime_ms;p50_mus;p99_mus\n";
+    std::cout << std::fixed << totals_parallel_.read_nodes_ << ";"
+      << (totals_parallel_.runtime_mus_ / 1000.0) << ";"
+      << Percentile(latencies_parallel_, 50) << ";"
+      << Percentile(latencies_parallel_, 99) << "\n";
+  }
+
+  std::cout << "\nCPU cost per read node (with IndexReader):\n";
+  std::cout << "query_engine;read_nodes;runtime_ms;ns_per_node\n";
+  for (const auto& [engine, totals] : {
+      std::make_pair(0, totals_query_),
+      std::make_pair(1, totals_query_engine_)}) {
+    double ns_per_node = totals.read_nodes_ == 0 ? 0
+      : 1000.0 * totals.runtime_mus_ / totals.read_nodes_;
+    std::cout << std::fixed << engine << ";"
+      << totals.read_nodes_ << ";"
+      << (totals.runtime_mus_ / 1000.0) << ";"
+      << ns_per_node << "\n";
+  }
+
+  if (limit_ > 0) {
+    std::cout << "\nLimit pushdown (with IndexReader and QueryEngine):\n";
+    std::cout << "limit;order;nr_matches;read_nodes;runtime_ms;p50_mus;p99_mus\n";
+    std::cout << std::fixed << "0;" << cas::ToString(cas::QueryOrder::Unordered) << ";"
+      << totals_query_engine_.nr_matches_ << ";"
+      << totals_query_engine_.read_nodes_ << ";"
+      << (totals_query_engine_.runtime_mus_ / 1000.0) << ";"
+      << Percentile(latencies_query_engine_, 50) << ";"
+      << Percentile(latencies_query_engine_, 99) << "\n";
+    std::cout << std::fixed << limit_ << ";" << cas::ToString(order_) << ";"
+      << totals_limit_.nr_matches_ << ";"
+      << totals_limit_.read_nodes_ << ";"
+      << (totals_limit_.runtime_mus_ / 1000.0) << ";"
+      << Percentile(latencies_limit_, 50) << ";"
+      << Percentile(latencies_limit_, 99) << "\n";
+  }
+
+  if (batch_size_ > 0) {
+    std::cout << "\nBatch execution (with IndexReader):\n";
+    std::cout << "batch_size;nr_matches;read_nodes;runtime_ms\n";
+    for (const auto& [batch_size, totals] : {
+        std::make_pair(size_t{1}, totals_query_engine_),
+        std::make_pair(batch_size_, totals_batch_)}) {
+      std::cout << std::fixed << batch_size << ";"
+        << totals.nr_matches_ << ";"
+        << totals.read_nodes_ << ";"
+        << (totals.runtime_mus_ / 1000.0) << "\n";
+    }
+  }
+
+  if (!format_results_.empty()) {
+    std::cout << "\nNode formats (with IndexReader):\n";
+    std::cout << "node_format;read_nodes;runtime_ms;p50_mus;p99_mus\n";
+    for (const auto& result : format_results_) {
+      std::cout << std::fixed << cas::ToString(result.format_) << ";"
+        << result.read_nodes_ << ";"
+        << result.runtime_ms_ << ";"
+        << result.p50_mus_ << ";"
+        << result.p99_mus_ << "\n";
+    }
+  }
+
   std::cout << "\n\n";
   std::cout << std::flush;
 }
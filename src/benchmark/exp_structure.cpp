@@ -1,6 +1,8 @@
 #include "benchmark/exp_structure.hpp"
 #include "cas/bulk_loader.hpp"
+#include "cas/compression.hpp"
 #include "cas/util.hpp"
+#include <filesystem>
 
 template<class VType>
 benchmark::ExpStructure<VType>::ExpStructure(
@@ -48,9 +50,106 @@ void benchmark::ExpStructure<VType>::Execute() {
   std::cout << "\nLeaf Node Width Histogram:\n";
   stats.leaf_width_.Dump();
 
+  std::cout << "\n\n";
+  CompareIndexSizes();
+  std::cout << "\n\n";
+  CompareInnerNodeWidths();
+
   std::cout << "\n\n\n"; cas::util::Log("done");
 }
 
+
+template<class VType>
+void benchmark::ExpStructure<VType>::CompareIndexSizes() {
+  struct Result {
+    bool ref_dictionary_;
+    cas::Compression leaf_compression_;
+    size_t index_bytes_;
+    size_t nr_compressed_leaves_;
+  };
+  std::vector<Result> results;
+
+  // the index built above remains in index_file_
+  cas::Context context = context_;
+  context.index_file_ = context_.index_file_ + ".sizes";
+  context.compute_depth_ = false;
+  context.compute_fanout_ = false;
+  context.compute_inner_node_width_ = false;
+  context.compute_leaf_width_ = false;
+  for (auto compression : {cas::Compression::None, cas::Compression::Lz4, cas::Compression::Zstd}) {
+    if (!cas::IsSupported(compression)) {
+      continue;
+    }
+    for (bool ref_dictionary : {false, true}) {
+      cas::util::Log("Index size with ref_dictionary=" + std::to_string(ref_dictionary)
+          + ", leaf_compression=" + cas::ToString(compression) + "\n");
+      context.ref_dictionary_ = ref_dictionary;
+      context.leaf_compression_ = compression;
+      cas::BulkLoaderStats stats;
+      cas::BulkLoader<VType> bulk_loader{context, stats};
+      bulk_loader.Load();
+      results.push_back({ref_dictionary, compression,
+          std::filesystem::file_size(context.index_file_),
+          stats.nr_compressed_leaves_});
+    }
+  }
+  std::filesystem::remove(context.index_file_);
+
+  std::cout << "Index Size (leaf_compression_threshold_: "
+    << context_.leaf_compression_threshold_ << "):\n";
+  std::cout << "ref_dictionary;leaf_compression;index_bytes;"
+    << "nr_compressed_leaves;ratio\n";
+  for (const auto& result : results) {
+    std::cout << result.ref_dictionary_ << ";"
+      << cas::ToString(result.leaf_compression_) << ";"
+      << result.index_bytes_ << ";"
+      << result.nr_compressed_leaves_ << ";"
+      << static_cast<double>(result.index_bytes_) / results[0].index_bytes_ << "\n";
+  }
+}
+
+template<class VType>
+void benchmark::ExpStructure<VType>::CompareInnerNodeWidths() {
+  struct Result {
+    bool relative_pointers_;
+    double avg_inner_node_width_;
+    size_t max_inner_node_width_;
+    size_t index_bytes_;
+  };
+  std::vector<Result> results;
+
+  cas::Context context = context_;
+  context.index_file_ = context_.index_file_ + ".widths";
+  context.compute_depth_ = false;
+  context.compute_fanout_ = false;
+  context.compute_inner_node_width_ = true;
+  context.compute_leaf_width_ = false;
+  for (bool relative_pointers : {false, true}) {
+    cas::util::Log("Inner node width with relative_pointers="
+        + std::to_string(relative_pointers) + "\n");
+    context.relative_pointers_ = relative_pointers;
+    cas::BulkLoaderStats stats;
+    cas::BulkLoader<VType> bulk_loader{context, stats};
+    bulk_loader.Load();
+    results.push_back({relative_pointers,
+        stats.inner_node_width_.Average(),
+        stats.inner_node_width_.MaxValue(),
+        std::filesystem::file_size(context.index_file_)});
+  }
+  std::filesystem::remove(context.index_file_);
+
+  std::cout << "Inner Node Width:\n";
+  std::cout << "relative_pointers;avg_inner_node_width;"
+    << "max_inner_node_width;index_bytes\n";
+  for (const auto& result : results) {
+    std::cout << result.relative_pointers_ << ";"
+      << result.avg_inner_node_width_ << ";"
+      << result.max_inner_node_width_ << ";"
+      << result.index_bytes_ << "\n";
+  }
+}
+
+
 template<class VType>
 void benchmark::ExpStructure<VType>::PrintOutput(
     const cas::Histogram& histogram,
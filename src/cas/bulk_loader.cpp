@@ -1,17 +1,27 @@
 #include "cas/bulk_loader.hpp"
+#include "cas/common_prefix.hpp"
+#include "cas/compression.hpp"
+#include "cas/index_layout.hpp"
 #include "cas/node_reader.hpp"
 #include "cas/key_encoder.hpp"
 #include "cas/util.hpp"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <numeric>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 
 template<class VType>
@@ -21,14 +31,63 @@ cas::BulkLoader<VType>::BulkLoader(
     )
   : context_{context}
   , stats_{stats}
-  , mpool_(MemoryPools::Construct(context.mem_size_bytes_, context.mem_capacity_bytes_))
-  , pager_(context.index_file_)
-  , shortened_key_buffer_(std::make_unique<std::array<std::byte, cas::PAGE_SZ>>())
-  , serialization_buffer_(std::make_unique<std::array<uint8_t, 10'000'000>>())
+  , mpool_(MemoryPools::Construct(context.mem_size_bytes_,
+        context.mem_capacity_bytes_, context.read_ahead_depth_,
+        context.page_size_, PoolBacking(context)))
+  , io_(context.io_queue_depth_, stats, context.write_behind_pages_,
+        context.page_size_)
+  , pager_(context.index_file_, context.page_size_)
+  , shortened_key_buffer_(KeyBuffer())
+  , serialization_buffer_(std::make_unique<std::vector<uint8_t>>(SERIALIZATION_BUFFER_SZ))
 {
   for (int b = 0; b <= 0xFF; ++b) {
-    ref_keys_[b] = std::make_unique<std::array<std::byte, cas::PAGE_SZ>>();
+    ref_keys_[b] = KeyBuffer();
   }
+  if (!cas::IsSupported(context.leaf_compression_)) {
+    throw std::runtime_error{"leaf compression "
+      + cas::ToString(context.leaf_compression_) + " is not supported by this build"};
+  }
+}
+
+
+template<class VType>
+cas::BulkLoader<VType>::BulkLoader(
+      const cas::Context& context,
+      cas::BulkLoaderStats& stats,
+      cas::MemoryPools& parent_pools
+    )
+  : context_{context}
+  , stats_{stats}
+  , mpool_(MemoryPools::Slice(parent_pools, context.read_ahead_depth_))
+  , io_(context.io_queue_depth_, stats, context.write_behind_pages_,
+        context.page_size_)
+  , pager_(context.index_file_, context.page_size_)
+  , shortened_key_buffer_(KeyBuffer())
+  , serialization_buffer_(std::make_unique<std::vector<uint8_t>>(SERIALIZATION_BUFFER_SZ))
+{
+  for (int b = 0; b <= 0xFF; ++b) {
+    ref_keys_[b] = KeyBuffer();
+  }
+  pager_.Clear();
+}
+
+
+template<class VType>
+std::unique_ptr<std::vector<std::byte>> cas::BulkLoader<VType>::KeyBuffer() const {
+  return std::make_unique<std::vector<std::byte>>(
+      std::min(context_.page_size_, cas::BinaryKey::MAX_BYTE_SIZE));
+}
+
+
+template<class VType>
+cas::MemoryBacking cas::BulkLoader<VType>::PoolBacking(const Context& context) {
+  MemoryBacking backing;
+  backing.huge_pages_ = context.huge_pages_;
+  backing.prefault_ = context.prefault_memory_;
+  // only workers access the work pool from different sockets
+  backing.numa_interleave_ = context.numa_interleave_ && context.nr_threads_ > 1;
+  backing.nr_threads_ = context.nr_threads_;
+  return backing;
 }
 
 
@@ -48,29 +107,20 @@ void cas::BulkLoader<VType>::Load() {
   }
   // delete the index file if it already exists
   pager_.Clear();
+  ref_dictionary_ = context_.ref_dictionary_
+    ? std::make_shared<RefDictionary>()
+    : nullptr;
+  InitializeWorkers();
 
   // Initialize the root partition
   cas::Partition partition{context_.input_filename_, stats_, context_};
+  partition.Io(&io_);
+  partition.ReadAhead(&mpool_.input_);
   InitializeRootPartition(partition);
 
   // Compute the root's discriminative byte
   auto start_time_dsc = std::chrono::high_resolution_clock::now();
-  if (context_.use_root_dsc_bytes_) {
-    partition.DscP(context_.root_dsc_P_);
-    partition.DscV(context_.root_dsc_V_);
-  } else {
-    switch (context_.dsc_computation_) {
-      case cas::DscComputation::Proactive:
-      case cas::DscComputation::TwoPass:
-        DscByte(partition);
-        break;
-      case cas::DscComputation::ByteByByte:
-        DscByteByByte(partition);
-        break;
-      default:
-        throw std::runtime_error{"unknown DscComputation"};
-    }
-  }
+  RootDscBytes(partition);
   cas::util::AddToTimer(stats_.runtime_dsc_computation_, start_time_dsc);
 
   // check that the input/output pages are fully available
@@ -82,7 +132,9 @@ void cas::BulkLoader<VType>::Load() {
 
   // construct the index
   auto construct_start = std::chrono::high_resolution_clock::now();
-  Construct(partition, cas::Dimension::VALUE, cas::Dimension::LEAF, 0, 0);
+  size_t nodes_end = Construct(partition, cas::Dimension::VALUE, cas::Dimension::LEAF, 0, 0);
+  ReleaseWorkers();
+  WriteTrailer(nodes_end);
   cas::util::AddToTimer(stats_.runtime_construction_, construct_start);
 
   cas::util::AddToTimer(stats_.runtime_, start_time_global);
@@ -100,25 +152,16 @@ void cas::BulkLoader<VType>::Load(cas::Partition& partition) {
 
   // delete the index file if it already exists
   pager_.Clear();
+  ref_dictionary_ = context_.ref_dictionary_
+    ? std::make_shared<RefDictionary>()
+    : nullptr;
+  InitializeWorkers();
+  partition.Io(&io_);
+  partition.ReadAhead(&mpool_.input_);
 
   // Compute the root's discriminative byte
   auto start_time_dsc = std::chrono::high_resolution_clock::now();
-  if (context_.use_root_dsc_bytes_) {
-    partition.DscP(context_.root_dsc_P_);
-    partition.DscV(context_.root_dsc_V_);
-  } else {
-    switch (context_.dsc_computation_) {
-      case cas::DscComputation::Proactive:
-      case cas::DscComputation::TwoPass:
-        DscByte(partition);
-        break;
-      case cas::DscComputation::ByteByByte:
-        DscByteByByte(partition);
-        break;
-      default:
-        throw std::runtime_error{"unknown DscComputation"};
-    }
-  }
+  RootDscBytes(partition);
   cas::util::AddToTimer(stats_.runtime_dsc_computation_, start_time_dsc);
 
   // check that the input/output pages are fully available
@@ -130,24 +173,69 @@ void cas::BulkLoader<VType>::Load(cas::Partition& partition) {
 
   // construct the index
   auto construct_start = std::chrono::high_resolution_clock::now();
-  Construct(partition, cas::Dimension::VALUE, cas::Dimension::LEAF, 0, 0);
+  size_t nodes_end = Construct(partition, cas::Dimension::VALUE, cas::Dimension::LEAF, 0, 0);
+  ReleaseWorkers();
+  WriteTrailer(nodes_end);
   cas::util::AddToTimer(stats_.runtime_construction_, construct_start);
 
   cas::util::AddToTimer(stats_.runtime_, start_time_global);
   stats_.index_bytes_written_ += std::filesystem::file_size(context_.index_file_);
   ++stats_.nr_bulkloads_;
 
+  // the partition outlives this bulk-loader
+  partition.Io(nullptr);
+  partition.ReadAhead(nullptr);
   pager_.Close();
 }
 
 
+// Partitions the root partition like the first step of Load, but
+// leaves the child partitions in table instead of constructing their
+// subtrees
+template<class VType>
+void cas::BulkLoader<VType>::PartitionRoot(
+    PartitionTable& table,
+    cas::Dimension dimension) {
+  std::filesystem::create_directories(context_.partition_folder_);
+  InitializeWorkers();
+  cas::Partition partition{context_.input_filename_, stats_, context_};
+  partition.Io(&io_);
+  InitializeRootPartition(partition);
+  RootDscBytes(partition);
+  PsiPartition(table, partition, dimension);
+  ReleaseWorkers();
+}
+
+
+template<class VType>
+void cas::BulkLoader<VType>::RootDscBytes(cas::Partition& partition) {
+  if (context_.use_root_dsc_bytes_) {
+    partition.DscP(context_.root_dsc_P_);
+    partition.DscV(context_.root_dsc_V_);
+  } else {
+    switch (context_.dsc_computation_) {
+      case cas::DscComputation::Proactive:
+      case cas::DscComputation::TwoPass:
+        DscByte(partition);
+        break;
+      case cas::DscComputation::ByteByByte:
+        DscByteByByte(partition);
+        break;
+      default:
+        throw std::runtime_error{"unknown DscComputation"};
+    }
+  }
+}
+
+
 template<class VType>
 size_t cas::BulkLoader<VType>::Construct(
           cas::Partition& partition,
           cas::Dimension dimension,
           cas::Dimension par_dimension,
           int depth,
-          size_t offset) {
+          size_t offset,
+          SubtreeStats* parent_stats) {
 
   if (depth > 0) {
     // ignore the root partition since we determined
@@ -174,20 +262,25 @@ size_t cas::BulkLoader<VType>::Construct(
   }
 
   Node node;
+  node.varint_header_ = context_.varint_headers_;
   size_t dsc_p = partition.DscP();
   size_t dsc_v = partition.DscV();
 
   BinaryKey key(nullptr);
   size_t key_len_p = 0;
   size_t key_len_v = 0;
+  std::vector<std::byte> value_prefix;
   size_t next_pos = offset;
+  size_t node_size = 0;
 
   {
     MemoryPage io_page = mpool_.input_.Get();
     auto cursor = partition.Cursor(io_page);
     // make sure the page is read into io_page when NextPage is called
     cursor.FetchNextDiskPage();
-    key = *(cursor.NextPage()).begin();
+    // keys of front-coded pages live as long as their iterator
+    auto it = cursor.NextPage().begin();
+    key = *it;
     node.path_.reserve(dsc_p);
     node.value_.reserve(dsc_v);
     key_len_p = key.LenPath();
@@ -211,6 +304,9 @@ size_t cas::BulkLoader<VType>::Construct(
     std::copy(key.Value() + off_v,
         key.Value() + dsc_v,
         std::back_inserter(node.value_));
+    // the values of the children's subtree statistics start after
+    // the common value prefix of this partition
+    value_prefix.assign(key.Value(), key.Value() + std::min(dsc_v, key_len_v));
 
     // return io_page to the input pool
     mpool_.input_.Release(std::move(io_page));
@@ -225,11 +321,14 @@ size_t cas::BulkLoader<VType>::Construct(
     //   occupies more than one memory page. This means that
     //   this unique key must contain many duplicate references
     node.dimension_ = cas::Dimension::LEAF;
+    node.has_leaf_marker_ = context_.leaf_compression_ != cas::Compression::None;
     ConstructLeafNode(node, partition);
-    size_t byte_size = node.ByteSize(0);
-    next_pos += byte_size;
+    // leaves have no child pointers, i.e., they are serialized right
+    // away since the size of a compressed leaf is only known afterwards
+    node_size = SerializeNode(node, offset);
+    next_pos += node_size;
     if (context_.compute_leaf_width_) {
-      stats_.leaf_width_.Record(byte_size);
+      stats_.leaf_width_.Record(node_size);
     }
     ++stats_.nr_leaf_nodes_;
   } else {
@@ -251,7 +350,9 @@ size_t cas::BulkLoader<VType>::Construct(
     }
 
     node.dimension_ = dimension;
-    PartitionTable table(partition_counter_, context_, stats_);
+    node.has_subtree_stats_ = context_.subtree_stats_;
+    node.len_subtree_values_ = dsc_v < key_len_v ? key_len_v - dsc_v : 0;
+    PartitionTable table(partition_counter_, context_, stats_, &io_, &mpool_.input_);
     PsiPartition(table, partition, dimension);
 
     if (context_.print_root_partition_table_allocation_ && depth == 0) {
@@ -271,27 +372,242 @@ size_t cas::BulkLoader<VType>::Construct(
       ++dsc_v;
     }
 
+    if (context_.relative_pointers_) {
+      node.pointer_width_ = RelativePointerWidth(node, table);
+    }
     size_t byte_size = node.ByteSize(table.NrPartitions());
     next_pos += byte_size;
     if (context_.compute_inner_node_width_) {
       stats_.inner_node_width_.Record(byte_size);
     }
-    for (int byte = 0x00; byte <= 0xFF; ++byte) {
-      if (table.Exists(byte)) {
-        node.children_pointers_.emplace_back(static_cast<std::byte>(byte), next_pos);
-        next_pos = Construct(table[byte], dim_next, dimension, depth + 1, next_pos);
+    if (depth == 0 && !workers_.empty()) {
+      next_pos = ConstructParallel(node, table, dim_next, dimension, depth + 1, next_pos);
+    } else {
+      for (int byte = 0x00; byte <= 0xFF; ++byte) {
+        if (table.Exists(byte)) {
+          node.children_pointers_.emplace_back(static_cast<std::byte>(byte), next_pos);
+          next_pos = Construct(table[byte], dim_next, dimension, depth + 1, next_pos,
+              &node.subtree_);
+        }
       }
     }
   }
 
   // Write to disk
-  size_t node_size = SerializeNode(node);
+  if (node.dimension_ != cas::Dimension::LEAF) {
+    node_size = SerializeNode(node, offset);
+  }
   pager_.Write(&serialization_buffer_->at(0), node_size, offset);
 
+  if (parent_stats != nullptr) {
+    parent_stats->Merge(node.subtree_, value_prefix);
+  }
   return next_pos;
 }
 
 
+// Constructs the subtrees of the partitions in table in parallel. Each
+// child partition becomes a task. Tasks are dealt to the workers' queues
+// (largest partitions first) and idle workers steal tasks from the back
+// of other queues. A worker appends the subtrees it constructs to its
+// own file. Afterwards the subtrees are copied in byte order behind the
+// parent node and their child pointers are shifted to their final
+// offsets, i.e., nodes are laid out in the same order as in a
+// sequential construction.
+template<class VType>
+size_t cas::BulkLoader<VType>::ConstructParallel(
+          Node& node,
+          cas::PartitionTable& table,
+          cas::Dimension dimension,
+          cas::Dimension par_dimension,
+          int depth,
+          size_t offset) {
+  struct Task {
+    int byte_;
+    size_t worker_ = 0;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    SubtreeStats stats_{};
+  };
+  std::vector<Task> tasks;
+  for (int byte = 0x00; byte <= 0xFF; ++byte) {
+    if (table.Exists(byte)) {
+      tasks.push_back({byte});
+    }
+  }
+
+  // deal the tasks, largest partitions first
+  size_t nr_workers = workers_.size();
+  std::vector<size_t> order(tasks.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return table[tasks[lhs].byte_].NrPages() > table[tasks[rhs].byte_].NrPages();
+  });
+  std::vector<std::deque<size_t>> queues(nr_workers);
+  std::vector<std::mutex> locks(nr_workers);
+  for (size_t i = 0; i < order.size(); ++i) {
+    queues[i % nr_workers].push_back(order[i]);
+  }
+
+  // the remaining work pages are shared equally among the workers
+  size_t share = mpool_.work_.NrFreePages() / nr_workers;
+  for (auto& worker : workers_) {
+    worker->loader_->mpool_.work_.Borrow(share);
+  }
+
+  // take tasks from the front of the own queue and
+  // steal them from the back of the other queues
+  auto next_task = [&](size_t w, size_t& t) -> bool {
+    for (size_t i = 0; i < nr_workers; ++i) {
+      size_t v = (w + i) % nr_workers;
+      std::lock_guard<std::mutex> guard{locks[v]};
+      if (queues[v].empty()) {
+        continue;
+      }
+      if (i == 0) {
+        t = queues[v].front();
+        queues[v].pop_front();
+      } else {
+        t = queues[v].back();
+        queues[v].pop_back();
+      }
+      return true;
+    }
+    return false;
+  };
+
+  std::vector<std::exception_ptr> errors(nr_workers);
+  std::vector<std::thread> threads;
+  threads.reserve(nr_workers);
+  for (size_t w = 0; w < nr_workers; ++w) {
+    threads.emplace_back([&, w]() {
+      auto& worker = *workers_[w];
+      try {
+        size_t t;
+        while (next_task(w, t)) {
+          auto& task = tasks[t];
+          auto& partition = table[task.byte_];
+          partition.Stats(worker.stats_);
+          partition.Io(&worker.loader_->io_);
+          partition.ReadAhead(&worker.loader_->mpool_.input_);
+          task.worker_ = w;
+          task.begin_ = worker.file_pos_;
+          worker.file_pos_ = worker.loader_->Construct(partition,
+              dimension, par_dimension, depth, worker.file_pos_, &task.stats_);
+          task.end_ = worker.file_pos_;
+        }
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // map the workers' files
+  std::vector<uint8_t*> files(nr_workers, nullptr);
+  for (size_t w = 0; w < nr_workers; ++w) {
+    auto& worker = *workers_[w];
+    worker.loader_->pager_.Close();
+    if (worker.file_pos_ == 0) {
+      continue;
+    }
+    const std::string& filename = worker.context_.index_file_;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      throw std::runtime_error{"failed to open file '" + filename + "'"};
+    }
+    void* file = mmap(NULL, worker.file_pos_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+      throw std::runtime_error{"mmap of file '" + filename + "' failed"};
+    }
+    files[w] = static_cast<uint8_t*>(file);
+  }
+
+  // place the subtrees right after each other
+  size_t next_pos = offset;
+  for (const auto& task : tasks) {
+    node.children_pointers_.emplace_back(static_cast<std::byte>(task.byte_), next_pos);
+    RelocateSubtree(files[task.worker_], task.begin_, task.end_, next_pos);
+    next_pos += task.end_ - task.begin_;
+    node.subtree_.Merge(task.stats_, {});
+  }
+
+  for (size_t w = 0; w < nr_workers; ++w) {
+    if (files[w] != nullptr && munmap(files[w], workers_[w]->file_pos_) < 0) {
+      throw std::runtime_error{"could not munmap worker file"};
+    }
+  }
+
+  return next_pos;
+}
+
+
+// copies the serialized nodes in src[begin, end) to the index file
+// at offset and shifts their child pointers accordingly
+template<class VType>
+void cas::BulkLoader<VType>::RelocateSubtree(
+          const uint8_t* src,
+          size_t begin,
+          size_t end,
+          size_t offset) {
+  constexpr size_t pointer_limit = (1ul << 48) - 1;
+  auto& buffer = *serialization_buffer_.get();
+  size_t buffer_pos = 0;
+  size_t dst = offset;
+  size_t pos = begin;
+  // the workers' files have no trailer, but their leaves are
+  // serialized like the leaves of the final index
+  cas::IndexLayout layout;
+  layout.ref_ids_ = ref_dictionary_ != nullptr;
+  layout.leaf_compression_ = context_.leaf_compression_;
+  layout.varint_headers_ = context_.varint_headers_;
+  while (pos < end) {
+    cas::NodeReader reader{src, pos, &layout};
+    size_t size = reader.ByteSize();
+    if (buffer_pos + size > buffer.size()) {
+      pager_.Write(&buffer[0], buffer_pos, dst);
+      dst += buffer_pos;
+      buffer_pos = 0;
+      if (size > buffer.size()) {
+        buffer.resize(size);
+      }
+    }
+    std::memcpy(&buffer[buffer_pos], src + pos, size);
+    // relative pointers remain valid
+    if (reader.IsInnerNode() && !reader.HasRelativePointers()) {
+      for (size_t i = 0; i < reader.NrChildren(); ++i) {
+        size_t entry = buffer_pos + reader.ChildPointerPos(i);
+        size_t ptr = 0;
+        for (size_t j = 0; j < 6; ++j) {
+          ptr = (ptr << 8) | buffer[entry + j];
+        }
+        ptr = ptr - begin + offset;
+        if (ptr >= pointer_limit) {
+          throw std::runtime_error{"pointer size exceeds 2**48-1"};
+        }
+        for (size_t j = 6; j >= 1; --j) {
+          buffer[entry + j - 1] = static_cast<uint8_t>(ptr & 0xFF);
+          ptr >>= 8;
+        }
+      }
+    }
+    buffer_pos += size;
+    pos += size;
+  }
+  if (buffer_pos > 0) {
+    pager_.Write(&buffer[0], buffer_pos, dst);
+  }
+}
+
+
 // add all the partial keys and their references
 template<class VType>
 void cas::BulkLoader<VType>::ConstructLeafNode(
@@ -321,6 +637,7 @@ void cas::BulkLoader<VType>::ConstructLeafNode(
       std::memcpy(&lkey.value_[0], key.Value() + dsc_v, new_len_v);
       lkey.ref_ = key.Ref();
       node.suffixes_.push_back(lkey);
+      node.subtree_.Add(key.Value() + dsc_v, new_len_v);
     }
     if (page.Type() != cas::MemoryPageType::INPUT) {
       mpool_.work_.Release(std::move(page));
@@ -329,6 +646,9 @@ void cas::BulkLoader<VType>::ConstructLeafNode(
   partition.DeleteFile();
   // return io_page to the input pool
   mpool_.input_.Release(std::move(io_page));
+  if (ref_dictionary_ != nullptr) {
+    ref_dictionary_->Lookup(node.suffixes_, node.ref_ids_);
+  }
   cas::util::AddToTimer(stats_.runtime_construct_leaf_node_, start);
 }
 
@@ -343,156 +663,390 @@ void cas::BulkLoader<VType>::PsiPartition(
   bool is_memory_only = partition.IsMemoryOnly();
   bool is_disk_only = partition.IsDiskOnly();
   bool is_hybrid = partition.IsHybrid();
-  // prepare the input & output pages
-  std::vector<cas::MemoryPage> pages;
-  pages.reserve(cas::BYTE_MAX);
-  for (size_t i = 0; i < cas::BYTE_MAX; ++i) {
-    pages.emplace_back(nullptr);
-  }
-  MemoryPage io_page = mpool_.input_.Get();
   // decide if we want to use memory pages at all during
   // this partitioning step
   bool use_memory_pages =
     context_.memory_placement_ != cas::MemoryPlacement::AllOrNothing
     || (partition.NrPages() <= mpool_.work_.Capacity());
-  // iterate over each page in the input relation
-  auto cursor = partition.Cursor(io_page);
-  while (cursor.HasNext()) {
-    auto page = cursor.RemoveNextPage();
-    if (partition.IsRootPartition()) {
-      stats_.nr_input_keys_ += page.NrKeys();
+  if (context_.parallel_partitioning_ && !workers_.empty() &&
+      partition.IsRootPartition()) {
+    PsiPartitionParallel(table, partition, dimension, use_memory_pages);
+  } else {
+    // prepare the input & output pages
+    std::vector<cas::MemoryPage> pages;
+    pages.reserve(cas::BYTE_MAX);
+    for (size_t i = 0; i < cas::BYTE_MAX; ++i) {
+      pages.emplace_back(nullptr);
     }
-    for (auto next_key : page) {
-      // drop the common prefixes
-      BinaryKey key{shortened_key_buffer_->data()};
-      uint16_t new_len_p = 0;
-      uint16_t new_len_v = 0;
-      if (partition.DscP() < next_key.LenPath()) {
-        new_len_p = next_key.LenPath() - partition.DscP();
-      }
-      if (partition.DscV() < next_key.LenValue()) {
-        new_len_v = next_key.LenValue() - partition.DscV();
-      }
-      key.Ref(next_key.Ref());
-      key.LenPath(new_len_p);
-      key.LenValue(new_len_v);
-      std::memcpy(key.Path(), next_key.Path() + partition.DscP(),
-          new_len_p);
-      std::memcpy(key.Value(), next_key.Value() + partition.DscV(),
-          new_len_v);
-      // determine the discriminative byte
-      int b;
-      switch (dimension) {
-        case cas::Dimension::PATH:
-          b = static_cast<int>(key.Path()[0]);
-          break;
-        case cas::Dimension::VALUE:
-          b = static_cast<int>(key.Value()[0]);
-          break;
-        default:
-          throw std::runtime_error{"unexpected dimension"};
-      }
-      if (table.Absent(b)) {
-        // initialize the new partition
-        table.InitializePartition(b, key.LenPath(), key.LenValue());
-        pages[b] = mpool_.output_.Get();
-        if (key.ByteSize() > ref_keys_[b]->size()) {
-          throw std::runtime_error{"key does not fit into buffer"};
-        }
-        std::memcpy(ref_keys_[b]->data(), key.Begin(), key.ByteSize());
-      } else {
-        // update the discriminative bytes
-        cas::BinaryKey ref_key(ref_keys_[b]->data());
-        auto& partition = table[b];
-        int g_P = 0;
-        int g_V = 0;
-        while (g_P < partition.DscP() && key.Path()[g_P] == ref_key.Path()[g_P]) {
-          ++g_P;
+    MemoryPage io_page = mpool_.input_.Get();
+    // iterate over each page in the input relation
+    auto cursor = partition.Cursor(io_page);
+    while (cursor.HasNext()) {
+      auto page = cursor.RemoveNextPage();
+      if (partition.IsRootPartition()) {
+        stats_.nr_input_keys_ += page.NrKeys();
+      }
+      for (auto next_key : page) {
+        // drop the common prefixes
+        BinaryKey key{shortened_key_buffer_->data()};
+        int b = ShortenKey(partition, next_key, key, dimension);
+        if (table.Absent(b)) {
+          // initialize the new partition
+          table.InitializePartition(b, key.LenPath(), key.LenValue());
+          pages[b] = mpool_.output_.Get(context_.page_format_);
+          if (key.ByteSize() > ref_keys_[b]->size()) {
+            throw std::runtime_error{"key does not fit into buffer"};
+          }
+          std::memcpy(ref_keys_[b]->data(), key.Begin(), key.ByteSize());
+        } else {
+          // update the discriminative bytes
+          cas::BinaryKey ref_key(ref_keys_[b]->data());
+          UpdateDscBytes(table[b], key, ref_key);
         }
-        while (g_V < partition.DscV() && key.Value()[g_V] == ref_key.Value()[g_V]) {
-          ++g_V;
+        // make sure there is space for key in pages[b]
+        if (!pages[b].Fits(key)) {
+          SpillOutputPage(table, b, pages[b], use_memory_pages);
         }
-        partition.DscP(g_P);
-        partition.DscV(g_V);
+        pages[b].Push(key);
+        table[b].KeyBytes() += key.ByteSize();
+      }
+      if (page.Type() != cas::MemoryPageType::INPUT) {
+        mpool_.work_.Release(std::move(page));
       }
-      // make sure there is space for key in pages[b]
-      if (key.ByteSize() > pages[b].FreeSpace()) {
-        if (use_memory_pages && mpool_.work_.HasFreePage()) {
+    }
+    // move dirty output pages to their partition's mptr
+    for (int b = 0x00; b <= 0xFF; ++b) {
+      if (table.Exists(b)) {
+        if (use_memory_pages) {
           table[b].PushToMemory(std::move(pages[b]));
-          pages[b] = mpool_.work_.Get();
         } else {
-          switch (context_.memory_placement_) {
-            case cas::MemoryPlacement::FrontLoading: {
-              int bp = 0xFF;
-              while (bp > b && (table.Absent(bp) || !table[bp].HasMemoryPage())) {
-                --bp;
-              }
-              if (bp > b) {
-                auto tmp_page = table[bp].PopFromMemory();
-                table[bp].PushToDisk(tmp_page);
-                table[b].PushToMemory(std::move(pages[b]));
-                pages[b] = std::move(tmp_page);
-              } else {
-                table[b].PushToDisk(pages[b]);
-              }
-              break;
-            }
-            case cas::MemoryPlacement::BackLoading: {
-              int bp = 0x00;
-              while (bp < b && (table.Absent(bp) || !table[bp].HasMemoryPage())) {
-                ++bp;
-              }
-              if (bp < b) {
-                auto tmp_page = table[bp].PopFromMemory();
-                table[bp].PushToDisk(tmp_page);
-                table[b].PushToMemory(std::move(pages[b]));
-                pages[b] = std::move(tmp_page);
-              } else {
-                table[b].PushToDisk(pages[b]);
-              }
-              break;
-            }
-            case cas::MemoryPlacement::Uniform:
-            case cas::MemoryPlacement::AllOrNothing:
-              table[b].PushToDisk(pages[b]);
-              break;
-          }
-          pages[b].Reset();
+          table[b].PushToDisk(pages[b]);
+          mpool_.output_.Release(std::move(pages[b]));
         }
         ++table[b].NrPages();
       }
-      pages[b].Push(key);
     }
-    if (page.Type() != cas::MemoryPageType::INPUT) {
-      mpool_.work_.Release(std::move(page));
+    // return io_page to the input pool
+    mpool_.input_.Release(std::move(io_page));
+  }
+  // the sizes of the files are known now, the buffered pages and the
+  // evicted memory pages are written into the preallocated space
+  for (int b = 0x00; b <= 0xFF; ++b) {
+    if (table.Exists(b)) {
+      table[b].Preallocate(table[b].NrPages());
     }
   }
-  // move dirty output pages to their partition's mptr
+  RefillPool(mpool_.output_, table);
+  // close all partitions
   for (int b = 0x00; b <= 0xFF; ++b) {
     if (table.Exists(b)) {
+      UpdatePartitionStats(table[b]);
+      table[b].Close();
+    }
+  }
+  // check that the input/output pools are full
+  if (!mpool_.input_.Full()) {
+    throw std::runtime_error{"input_ pool is not full"};
+  }
+  if (!mpool_.output_.Full()) {
+    throw std::runtime_error{"output pool is not full"};
+  }
+  // record runtime
+  auto end = std::chrono::high_resolution_clock::now();
+  cas::util::AddToTimer(stats_.runtime_partitioning_, start, end);
+  if (is_memory_only) {
+    cas::util::AddToTimer(stats_.runtime_partitioning_mem_only_, start, end);
+  } else if (is_disk_only) {
+    cas::util::AddToTimer(stats_.runtime_partitioning_disk_only_, start, end);
+  } else if (is_hybrid) {
+    cas::util::AddToTimer(stats_.runtime_partitioning_hybrid_, start, end);
+  }
+  // delete the disk-based keys in the original partition
+  if (context_.delete_root_partition_ || !partition.IsRootPartition()) {
+    partition.DeleteFile();
+  }
+}
+
+
+// Partitions the root partition with all workers. The memory pages of
+// the partition are dealt to the workers and its disk pages are split
+// into one contiguous range per worker. Every worker scatters its keys
+// into its own output pages (see Scatter), i.e., the workers only
+// synchronize when a page is full and needs to be placed in the table.
+// Afterwards, the workers' last pages are added to the table and the
+// discriminative bytes of the workers are merged.
+template<class VType>
+void cas::BulkLoader<VType>::PsiPartitionParallel(
+        cas::PartitionTable& table,
+        cas::Partition& partition,
+        const cas::Dimension dimension,
+        bool use_memory_pages) {
+  size_t nr_workers = workers_.size();
+  std::vector<ScatterTask> tasks(nr_workers);
+  for (size_t i = 0; partition.HasMemoryPage(); ++i) {
+    tasks[i % nr_workers].memory_pages_.push_back(partition.PopFromMemory());
+  }
+  size_t first_page_nr = partition.FptrCursorFirstPageNr();
+  size_t last_page_nr = std::max(first_page_nr, partition.FptrCursorLastPageNr());
+  size_t range = (last_page_nr - first_page_nr + nr_workers - 1) / nr_workers;
+  for (size_t w = 0; w < nr_workers; ++w) {
+    auto& task = tasks[w];
+    task.first_page_nr_ = std::min(last_page_nr, first_page_nr + w * range);
+    task.last_page_nr_ = std::min(last_page_nr, task.first_page_nr_ + range);
+    task.pages_.reserve(cas::BYTE_MAX);
+    for (size_t i = 0; i < cas::BYTE_MAX; ++i) {
+      task.pages_.emplace_back(nullptr);
+    }
+  }
+  // the workers' cursors neither open the file nor flush it
+  partition.Open();
+
+  std::mutex mutex;
+  std::vector<std::exception_ptr> errors(nr_workers);
+  std::vector<std::thread> threads;
+  threads.reserve(nr_workers);
+  for (size_t w = 0; w < nr_workers; ++w) {
+    threads.emplace_back([&, w]() {
+      try {
+        workers_[w]->loader_->Scatter(*this, table, partition, dimension,
+            tasks[w], mutex, use_memory_pages);
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  for (int b = 0x00; b <= 0xFF; ++b) {
+    if (table.Absent(b)) {
+      continue;
+    }
+    // the discriminative bytes of a union of keys are limited by the
+    // common prefix of the workers' reference keys
+    BinaryKey first_ref_key{nullptr};
+    size_t dsc_p = 0;
+    size_t dsc_v = 0;
+    for (size_t w = 0; w < nr_workers; ++w) {
+      auto& task = tasks[w];
+      if (task.pages_[b].IsNull()) {
+        continue;
+      }
+      BinaryKey ref_key{workers_[w]->loader_->ref_keys_[b]->data()};
+      if (first_ref_key.Begin() == nullptr) {
+        first_ref_key = ref_key;
+        dsc_p = task.dsc_p_[b];
+        dsc_v = task.dsc_v_[b];
+      } else {
+        dsc_p = std::min(dsc_p, task.dsc_p_[b]);
+        dsc_v = std::min(dsc_v, task.dsc_v_[b]);
+        UpdateDscBytes(dsc_p, dsc_v, ref_key, first_ref_key);
+      }
+      table[b].KeyBytes() += task.key_bytes_[b];
+      // move dirty output pages to their partition's mptr
+      auto& pool = workers_[w]->loader_->mpool_.output_;
       if (use_memory_pages) {
-        table[b].PushToMemory(std::move(pages[b]));
+        table[b].PushToMemory(std::move(task.pages_[b]));
       } else {
-        table[b].PushToDisk(pages[b]);
-        mpool_.output_.Release(std::move(pages[b]));
+        table[b].PushToDisk(task.pages_[b]);
+        pool.Release(std::move(task.pages_[b]));
       }
       ++table[b].NrPages();
     }
+    table[b].DscP(dsc_p);
+    table[b].DscV(dsc_v);
+  }
+  // the workers need all their output pages again for constructing the
+  // subtrees
+  for (auto& worker : workers_) {
+    RefillPool(worker->loader_->mpool_.output_, table);
+  }
+}
+
+
+// Scatters the keys of task into the table on behalf of parent (see
+// PsiPartitionParallel). The output pages and reference keys are the
+// worker's own, the table and the work pool of parent are shared and
+// only accessed while holding mutex. Without memory pages, the output
+// pages are written to disk outside of mutex (see AppendToDisk).
+template<class VType>
+void cas::BulkLoader<VType>::Scatter(
+        BulkLoader& parent,
+        cas::PartitionTable& table,
+        cas::Partition& partition,
+        const cas::Dimension dimension,
+        ScatterTask& task,
+        std::mutex& mutex,
+        bool use_memory_pages) {
+  auto scatter = [&](MemoryPage& page) {
+    stats_.nr_input_keys_ += page.NrKeys();
+    for (auto next_key : page) {
+      // drop the common prefixes
+      BinaryKey key{shortened_key_buffer_->data()};
+      int b = ShortenKey(partition, next_key, key, dimension);
+      auto& out = task.pages_[b];
+      if (out.IsNull()) {
+        {
+          std::lock_guard<std::mutex> guard{mutex};
+          table.InitializePartition(b, key.LenPath(), key.LenValue());
+        }
+        out = mpool_.output_.Get(context_.page_format_);
+        if (key.ByteSize() > ref_keys_[b]->size()) {
+          throw std::runtime_error{"key does not fit into buffer"};
+        }
+        std::memcpy(ref_keys_[b]->data(), key.Begin(), key.ByteSize());
+        task.dsc_p_[b] = key.LenPath();
+        task.dsc_v_[b] = key.LenValue();
+      } else {
+        // update the discriminative bytes of this worker's keys
+        cas::BinaryKey ref_key(ref_keys_[b]->data());
+        UpdateDscBytes(task.dsc_p_[b], task.dsc_v_[b], key, ref_key);
+      }
+      if (!out.Fits(key)) {
+        if (use_memory_pages) {
+          std::lock_guard<std::mutex> guard{mutex};
+          parent.SpillOutputPage(table, b, out, use_memory_pages);
+        } else {
+          // the other workers append to the partition while the page
+          // is compressed and written
+          table[b].AppendToDisk(out, mutex, stats_);
+          out.Reset();
+        }
+      }
+      out.Push(key);
+      task.key_bytes_[b] += key.ByteSize();
+    }
+  };
+
+  for (auto& page : task.memory_pages_) {
+    scatter(page);
+    std::lock_guard<std::mutex> guard{mutex};
+    parent.mpool_.work_.Release(std::move(page));
+  }
+  task.memory_pages_.clear();
+  MemoryPage io_page = mpool_.input_.Get();
+  auto cursor = partition.DiskCursor(io_page,
+      task.first_page_nr_, task.last_page_nr_, &io_, stats_, &mpool_.input_);
+  while (cursor.HasNext()) {
+    scatter(cursor.NextPage());
+  }
+  mpool_.input_.Release(std::move(io_page));
+}
+
+
+// copies key without the common prefixes of partition into shortened
+// and returns its discriminative byte in dimension
+template<class VType>
+int cas::BulkLoader<VType>::ShortenKey(
+        const cas::Partition& partition,
+        const cas::BinaryKey& key,
+        cas::BinaryKey& shortened,
+        const cas::Dimension dimension) const {
+  uint16_t new_len_p = 0;
+  uint16_t new_len_v = 0;
+  if (partition.DscP() < key.LenPath()) {
+    new_len_p = key.LenPath() - partition.DscP();
   }
-  // try to fill output pool as much as possible with work pages
-  while (!mpool_.output_.Full() && mpool_.work_.HasFreePage()) {
+  if (partition.DscV() < key.LenValue()) {
+    new_len_v = key.LenValue() - partition.DscV();
+  }
+  shortened.Ref(key.Ref());
+  shortened.LenPath(new_len_p);
+  shortened.LenValue(new_len_v);
+  std::memcpy(shortened.Path(), key.Path() + partition.DscP(), new_len_p);
+  std::memcpy(shortened.Value(), key.Value() + partition.DscV(), new_len_v);
+  switch (dimension) {
+    case cas::Dimension::PATH:
+      return static_cast<int>(shortened.Path()[0]);
+    case cas::Dimension::VALUE:
+      return static_cast<int>(shortened.Value()[0]);
+    default:
+      throw std::runtime_error{"unexpected dimension"};
+  }
+}
+
+
+// makes room in the full output page of partition b: the page either
+// becomes a memory page of the partition and is replaced by a work
+// page, or it is written to disk according to the memory placement
+template<class VType>
+void cas::BulkLoader<VType>::SpillOutputPage(
+        cas::PartitionTable& table,
+        int b,
+        cas::MemoryPage& page,
+        bool use_memory_pages) {
+  if (use_memory_pages && mpool_.work_.HasFreePage()) {
+    table[b].PushToMemory(std::move(page));
+    page = mpool_.work_.Get(context_.page_format_);
+  } else {
+    switch (context_.memory_placement_) {
+      case cas::MemoryPlacement::FrontLoading: {
+        int bp = 0xFF;
+        while (bp > b && (table.Absent(bp) || !table[bp].HasMemoryPage())) {
+          --bp;
+        }
+        if (bp > b) {
+          auto tmp_page = table[bp].PopFromMemory();
+          table[bp].PushToDisk(tmp_page);
+          table[b].PushToMemory(std::move(page));
+          page = std::move(tmp_page);
+        } else {
+          table[b].PushToDisk(page);
+        }
+        break;
+      }
+      case cas::MemoryPlacement::BackLoading: {
+        int bp = 0x00;
+        while (bp < b && (table.Absent(bp) || !table[bp].HasMemoryPage())) {
+          ++bp;
+        }
+        if (bp < b) {
+          auto tmp_page = table[bp].PopFromMemory();
+          table[bp].PushToDisk(tmp_page);
+          table[b].PushToMemory(std::move(page));
+          page = std::move(tmp_page);
+        } else {
+          table[b].PushToDisk(page);
+        }
+        break;
+      }
+      case cas::MemoryPlacement::Uniform:
+      case cas::MemoryPlacement::AllOrNothing:
+        table[b].PushToDisk(page);
+        break;
+    }
+    page.Reset();
+  }
+  ++table[b].NrPages();
+}
+
+
+// fills pool with free work pages and, if there are not enough, with
+// memory pages of the partitions that are written to disk
+template<class VType>
+void cas::BulkLoader<VType>::RefillPool(
+        cas::MemoryPool& pool,
+        cas::PartitionTable& table) {
+  // try to fill the pool as much as possible with work pages
+  while (!pool.Full() && mpool_.work_.HasFreePage()) {
     auto page = mpool_.work_.Get();
-    mpool_.output_.Release(std::move(page));
+    pool.Release(std::move(page));
   }
-  // replenish output pool
+  // evict memory pages for the rest
   switch (context_.memory_placement_) {
     case cas::MemoryPlacement::FrontLoading: {
       int b = 0xFF;
-      while (!mpool_.output_.Full() && b >= 0x00) {
-        while (!mpool_.output_.Full() && table.Exists(b) && table[b].HasMemoryPage()) {
+      while (!pool.Full() && b >= 0x00) {
+        while (!pool.Full() && table.Exists(b) && table[b].HasMemoryPage()) {
           auto tmp_page = table[b].PopFromMemory();
           table[b].PushToDisk(tmp_page);
-          mpool_.output_.Release(std::move(tmp_page));
+          pool.Release(std::move(tmp_page));
         }
         --b;
       }
@@ -500,11 +1054,11 @@ void cas::BulkLoader<VType>::PsiPartition(
     }
     case cas::MemoryPlacement::BackLoading: {
       int b = 0x00;
-      while (!mpool_.output_.Full() && b <= 0xFF) {
-        while (!mpool_.output_.Full() && table.Exists(b) && table[b].HasMemoryPage()) {
+      while (!pool.Full() && b <= 0xFF) {
+        while (!pool.Full() && table.Exists(b) && table[b].HasMemoryPage()) {
           auto tmp_page = table[b].PopFromMemory();
           table[b].PushToDisk(tmp_page);
-          mpool_.output_.Release(std::move(tmp_page));
+          pool.Release(std::move(tmp_page));
         }
         ++b;
       }
@@ -513,74 +1067,50 @@ void cas::BulkLoader<VType>::PsiPartition(
     case cas::MemoryPlacement::Uniform:
     case cas::MemoryPlacement::AllOrNothing: {
       int b = 0x00;
-      while (!mpool_.output_.Full() && b <= 0xFF) {
+      while (!pool.Full() && b <= 0xFF) {
         if (table.Exists(b) && table[b].HasMemoryPage()) {
           auto tmp_page = table[b].PopFromMemory();
           table[b].PushToDisk(tmp_page);
-          mpool_.output_.Release(std::move(tmp_page));
+          pool.Release(std::move(tmp_page));
         }
         ++b;
       }
       break;
     }
   }
-  // close all partitions
-  for (int b = 0x00; b <= 0xFF; ++b) {
-    if (table.Exists(b)) {
-      UpdatePartitionStats(table[b]);
-      table[b].Close();
-    }
-  }
-  // return io_page to the input pool
-  mpool_.input_.Release(std::move(io_page));
-  // check that the input/output pools are full
-  if (!mpool_.input_.Full()) {
-    throw std::runtime_error{"input_ pool is not full"};
-  }
-  if (!mpool_.output_.Full()) {
-    throw std::runtime_error{"output pool is not full"};
-  }
-  // record runtime
-  auto end = std::chrono::high_resolution_clock::now();
-  cas::util::AddToTimer(stats_.runtime_partitioning_, start, end);
-  if (is_memory_only) {
-    cas::util::AddToTimer(stats_.runtime_partitioning_mem_only_, start, end);
-  } else if (is_disk_only) {
-    cas::util::AddToTimer(stats_.runtime_partitioning_disk_only_, start, end);
-  } else if (is_hybrid) {
-    cas::util::AddToTimer(stats_.runtime_partitioning_hybrid_, start, end);
-  }
-  // delete the disk-based keys in the original partition
-  if (context_.delete_root_partition_ || !partition.IsRootPartition()) {
-    partition.DeleteFile();
-  }
 }
 
 
 template<class VType>
-size_t cas::BulkLoader<VType>::SerializeNode(Node& node) {
+size_t cas::BulkLoader<VType>::SerializeNode(Node& node, size_t node_pos) {
   auto& buffer = *serialization_buffer_.get();
 
   constexpr size_t path_limit    = (1ul << 12) - 1;
   constexpr size_t value_limit   = (1ul <<  4) - 1;
   constexpr size_t payload_limit = (1ul << 14) - 1;
   constexpr size_t pointer_limit = (1ul << 48) - 1;
+  constexpr size_t stats_limit   = (1ul <<  8) - 1;
 
-  // check bounds
-  if (node.path_.size() > path_limit) {
-    throw std::runtime_error{"path size exceeds 2**12-1"};
-  }
-  if (node.value_.size() > value_limit) {
-    throw std::runtime_error{"value size exceeds 2**4-1"};
+  // check bounds, varint headers only limit the number of children
+  if (!node.varint_header_) {
+    if (node.path_.size() > path_limit) {
+      throw std::runtime_error{"path size exceeds 2**12-1"};
+    }
+    if (node.value_.size() > value_limit) {
+      throw std::runtime_error{"value size exceeds 2**4-1"};
+    }
+    if (node.suffixes_.size() > payload_limit) {
+      throw std::runtime_error{"number of suffixes exceeds 2**14-1"};
+    }
   }
   if (node.children_pointers_.size() > 256) {
     throw std::runtime_error{"number of children exceeds 256"};
   }
-  if (node.suffixes_.size() > payload_limit) {
-    throw std::runtime_error{"number of suffixes exceeds 2**14-1"};
-  }
-  if (node.ByteSize(node.children_pointers_.size()) > buffer.size()) {
-    throw std::runtime_error{"node exceeds buffer size"};
+  // the buffer grows with the largest node, e.g., a leaf with many
+  // duplicate references
+  size_t byte_size = node.ByteSize(node.children_pointers_.size());
+  if (byte_size > buffer.size()) {
+    buffer.resize(byte_size);
   }
 
   // determine nr children/suffixes
@@ -588,41 +1118,116 @@ size_t cas::BulkLoader<VType>::SerializeNode(Node& node) {
     ? node.suffixes_.size()
     : node.children_pointers_.size();
 
+  bool has_subtree_stats = !node.IsLeaf() && node.has_subtree_stats_;
+
+  // dimension and flags, the lengths and m are only part of the
+  // fixed-size header (see below)
   uint32_t header = 0;
   header |= (static_cast<uint32_t>(node.dimension_)    << 30);
-  header |= (static_cast<uint32_t>(node.path_.size())  << 18);
-  header |= (static_cast<uint32_t>(node.value_.size()) << 14);
-  header |= (static_cast<uint32_t>(m));
+  if (!node.IsLeaf()) {
+    header |= cas::NodeReader::FormatFlag(context_.node_format_);
+  }
+  if (has_subtree_stats) {
+    header |= cas::NodeReader::SubtreeStatsFlag();
+  }
+  if (!node.IsLeaf()) {
+    header |= cas::NodeReader::PointerWidthFlag(node.pointer_width_);
+  }
 
   // serialize header
   size_t offset = 0;
-  CopyToSerializationBuffer(offset, &header, sizeof(uint32_t));
+  if (node.varint_header_) {
+    // flags byte followed by the lengths and m
+    buffer[offset++] = cas::NodeReader::VarintHeaderFlags(header);
+    uint8_t* dst = &buffer[offset];
+    dst = cas::util::WriteVarint(dst, node.path_.size());
+    dst = cas::util::WriteVarint(dst, node.value_.size());
+    dst = cas::util::WriteVarint(dst, m);
+    offset = dst - &buffer[0];
+  } else {
+    header |= (static_cast<uint32_t>(node.path_.size())  << 18);
+    header |= (static_cast<uint32_t>(node.value_.size()) << 14);
+    header |= (static_cast<uint32_t>(m));
+    CopyToSerializationBuffer(offset, &header, sizeof(uint32_t));
+  }
+  if (has_subtree_stats) {
+    // extended header (nr keys: 6 bytes, len: 1 byte or varint, min, max)
+    const auto& subtree = node.subtree_;
+    if (subtree.nr_keys_ >= pointer_limit) {
+      throw std::runtime_error{"number of keys exceeds 2**48-1"};
+    }
+    size_t len = node.len_subtree_values_;
+    if (subtree.min_value_.size() != len || subtree.max_value_.size() != len) {
+      throw std::runtime_error{"subtree statistics require values of equal length"};
+    }
+    for (int shift = 40; shift >= 0; shift -= 8) {
+      buffer[offset++] = static_cast<uint8_t>((subtree.nr_keys_ >> shift) & 0xFF);
+    }
+    if (node.varint_header_) {
+      offset = cas::util::WriteVarint(&buffer[offset], len) - &buffer[0];
+    } else if (len > stats_limit) {
+      throw std::runtime_error{"subtree value size exceeds 2**8-1"};
+    } else {
+      buffer[offset++] = static_cast<uint8_t>(len);
+    }
+    CopyToSerializationBuffer(offset, &subtree.min_value_[0], len);
+    CopyToSerializationBuffer(offset, &subtree.max_value_[0], len);
+  }
   CopyToSerializationBuffer(offset, &node.path_[0], node.path_.size());
   CopyToSerializationBuffer(offset, &node.value_[0], node.value_.size());
 
+  size_t marker_pos = offset;
   if (node.IsLeaf()) {
+    if (node.has_leaf_marker_) {
+      buffer[offset++] = cas::IndexLayout::LEAF_RAW;
+    }
     // serialize suffixes
-    for (const auto& suffix : node.suffixes_) {
-      if (suffix.path_.size() > path_limit) {
-        throw std::runtime_error{"path-suffix size exceeds 2**12-1"};
-      }
-      if (suffix.value_.size() > value_limit) {
-        throw std::runtime_error{"value-suffix size exceeds 2**4-1"};
+    for (size_t i = 0; i < node.suffixes_.size(); ++i) {
+      const auto& suffix = node.suffixes_[i];
+      if (node.varint_header_) {
+        uint8_t* dst = &buffer[offset];
+        dst = cas::util::WriteVarint(dst, suffix.path_.size());
+        dst = cas::util::WriteVarint(dst, suffix.value_.size());
+        offset = dst - &buffer[0];
+      } else {
+        if (suffix.path_.size() > path_limit) {
+          throw std::runtime_error{"path-suffix size exceeds 2**12-1"};
+        }
+        if (suffix.value_.size() > value_limit) {
+          throw std::runtime_error{"value-suffix size exceeds 2**4-1"};
+        }
+        uint16_t pv_len = cas::util::EncodeSizes(suffix.path_.size(), suffix.value_.size());
+        buffer[offset++] = static_cast<uint8_t>((pv_len >> 8) & 0xFF);
+        buffer[offset++] = static_cast<uint8_t>((pv_len >> 0) & 0xFF);
       }
-      uint16_t pv_len = cas::util::EncodeSizes(suffix.path_.size(), suffix.value_.size());
-      buffer[offset++] = static_cast<uint8_t>((pv_len >> 8) & 0xFF);
-      buffer[offset++] = static_cast<uint8_t>((pv_len >> 0) & 0xFF);
       CopyToSerializationBuffer(offset, &suffix.path_[0], suffix.path_.size());
       CopyToSerializationBuffer(offset, &suffix.value_[0], suffix.value_.size());
-      CopyToSerializationBuffer(offset, &suffix.ref_, sizeof(cas::ref_t));
+      if (node.ref_ids_.empty()) {
+        CopyToSerializationBuffer(offset, &suffix.ref_, sizeof(cas::ref_t));
+      } else {
+        // the buffer is large enough, see the bounds check above
+        offset = cas::util::WriteVarint(&buffer[offset], node.ref_ids_[i]) - &buffer[0];
+      }
     }
   } else {
     // serialize child pointers
+    if (context_.node_format_ == cas::NodeFormat::KeyArray) {
+      for (const auto& [byte, ptr] : node.children_pointers_) {
+        buffer[offset++] = static_cast<uint8_t>(byte);
+      }
+    }
     for (const auto& [byte, ptr] : node.children_pointers_) {
       if (ptr >= pointer_limit) {
         throw std::runtime_error{"pointer size exceeds 2**48-1"};
       }
-      buffer[offset++] = static_cast<uint8_t>(byte);
+      if (context_.node_format_ == cas::NodeFormat::Interleaved) {
+        buffer[offset++] = static_cast<uint8_t>(byte);
+      }
+      if (node.pointer_width_ != 6) {
+        cas::util::WriteRelativePointer(&buffer[offset], node_pos, ptr, node.pointer_width_);
+        offset += node.pointer_width_;
+        continue;
+      }
       buffer[offset++] = static_cast<uint8_t>((ptr >> 40) & 0xFF);
       buffer[offset++] = static_cast<uint8_t>((ptr >> 32) & 0xFF);
       buffer[offset++] = static_cast<uint8_t>((ptr >> 24) & 0xFF);
@@ -633,14 +1238,146 @@ size_t cas::BulkLoader<VType>::SerializeNode(Node& node) {
   }
 
   // validation
-  if (offset != node.ByteSize(node.children_pointers_.size())) {
+  if (offset != byte_size) {
     throw std::runtime_error{"serialization size does not match expected size"};
   }
 
+  if (node.IsLeaf() && node.has_leaf_marker_ &&
+      offset - marker_pos - 1 >= context_.leaf_compression_threshold_) {
+    offset = CompressLeaf(marker_pos, offset);
+  }
+
   return offset;
 }
 
 
+// Upper bound of the serialized size of the partition's subtree. The
+// prefixes and suffixes of the subtree's nodes partition the bytes of
+// its keys. Besides, every key adds at most a leaf (header, marker: 1
+// byte), an inner node (header), two child entries (b:1, ptr: <= 6
+// bytes each) and the lengths and ref of its suffix (ref: <= 20 bytes),
+// while its binary key has 4 bytes of lengths and a 20-byte ref. The
+// subtree statistics of an inner node are at most 6 bytes, a length
+// and two values.
+template<class VType>
+size_t cas::BulkLoader<VType>::SubtreeBound(Partition& partition) const {
+  // varints of 16-bit lengths occupy at most 3 bytes, of m at most 5
+  size_t header = context_.varint_headers_ ? 1 + 3 + 3 + 5 : 4;
+  size_t suffix_lengths = context_.varint_headers_ ? 3 + 3 : 2;
+  size_t stats_length = context_.varint_headers_ ? 3 : 1;
+  size_t per_key = 2 * header + 1 + 2 * 7 + suffix_lengths - 4;
+  size_t bound = partition.KeyBytes() + per_key * partition.NrKeys();
+  if (context_.subtree_stats_) {
+    bound += 2 * partition.KeyBytes() + (6 + stats_length) * partition.NrKeys();
+  }
+  return bound;
+}
+
+
+// The smallest pointer width that fits the offset of the node's last
+// child, which follows the node and the subtrees of all other children.
+// Nodes whose children may be farther apart than 4GB keep absolute
+// pointers.
+template<class VType>
+int cas::BulkLoader<VType>::RelativePointerWidth(
+    const Node& node,
+    PartitionTable& table) const {
+  size_t max_delta = node.ByteSize(table.NrPartitions());
+  int last = 0xFF;
+  while (!table.Exists(last)) {
+    --last;
+  }
+  for (int byte = 0x00; byte < last; ++byte) {
+    if (table.Exists(byte)) {
+      max_delta += SubtreeBound(table[byte]);
+    }
+  }
+  for (int width : {1, 2, 4}) {
+    if ((max_delta >> (8 * width)) == 0) {
+      return width;
+    }
+  }
+  return 6;
+}
+
+
+// replaces the raw suffixes of the leaf in the serialization buffer
+// (from marker_pos to end) by their compressed representation, unless
+// it is not smaller; returns the new end of the leaf
+template<class VType>
+size_t cas::BulkLoader<VType>::CompressLeaf(size_t marker_pos, size_t end) {
+  auto& buffer = *serialization_buffer_.get();
+  size_t raw_size = end - marker_pos - 1;
+  compression_buffer_.resize(cas::CompressBound(context_.leaf_compression_, raw_size));
+  size_t compressed_size = cas::Compress(context_.leaf_compression_,
+      reinterpret_cast<const std::byte*>(&buffer[marker_pos + 1]), raw_size,
+      compression_buffer_.data(), compression_buffer_.size());
+  size_t size = 1
+    + cas::util::VarintSize(raw_size)
+    + cas::util::VarintSize(compressed_size)
+    + compressed_size;
+  if (marker_pos + size >= end) {
+    return end;
+  }
+  uint8_t* dst = &buffer[marker_pos];
+  *dst++ = cas::IndexLayout::LEAF_COMPRESSED;
+  dst = cas::util::WriteVarint(dst, raw_size);
+  dst = cas::util::WriteVarint(dst, compressed_size);
+  std::memcpy(dst, compression_buffer_.data(), compressed_size);
+  ++stats_.nr_compressed_leaves_;
+  return marker_pos + size;
+}
+
+
+// writes the ref dictionary and the trailer behind the nodes (see
+// IndexLayout), files without these features only contain nodes
+template<class VType>
+void cas::BulkLoader<VType>::WriteTrailer(size_t nodes_end) {
+  cas::IndexLayout layout;
+  layout.nodes_end_ = nodes_end;
+  layout.ref_ids_ = ref_dictionary_ != nullptr;
+  layout.leaf_compression_ = context_.leaf_compression_;
+  layout.varint_headers_ = context_.varint_headers_;
+  if (!layout.HasTrailer()) {
+    return;
+  }
+  size_t pos = nodes_end;
+  if (ref_dictionary_ != nullptr) {
+    auto& refs = ref_dictionary_->refs_;
+    layout.nr_refs_ = refs.size();
+    stats_.nr_dictionary_refs_ += refs.size();
+    if (!refs.empty()) {
+      pager_.Write(reinterpret_cast<uint8_t*>(refs.data()),
+          refs.size() * sizeof(cas::ref_t), pos);
+    }
+    pos += refs.size() * sizeof(cas::ref_t);
+  }
+  std::array<uint8_t, cas::IndexLayout::TRAILER_SZ> trailer;
+  layout.WriteTrailer(trailer.data());
+  pager_.Write(trailer.data(), trailer.size(), pos);
+}
+
+
+template<class VType>
+void cas::BulkLoader<VType>::RefDictionary::Lookup(
+    const std::vector<MemoryKey>& suffixes,
+    std::vector<uint32_t>& ids) {
+  constexpr size_t id_limit = (1ul << 32) - 1;
+  std::lock_guard<std::mutex> guard{mutex_};
+  ids.reserve(ids.size() + suffixes.size());
+  for (const auto& suffix : suffixes) {
+    auto [it, inserted] = ids_.try_emplace(suffix.ref_, refs_.size());
+    if (inserted) {
+      if (refs_.size() >= id_limit) {
+        throw std::runtime_error{"number of references exceeds 2**32-1"};
+      }
+      refs_.push_back(suffix.ref_);
+    }
+    ids.push_back(it->second);
+  }
+}
+
+
 template<class VType>
 void cas::BulkLoader<VType>::CopyToSerializationBuffer(
     size_t& offset, const void* src, size_t count) {
@@ -648,32 +1385,96 @@ void cas::BulkLoader<VType>::CopyToSerializationBuffer(
     auto msg = "address violation: " + std::to_string(offset+count);
     throw std::out_of_range{msg};
   }
-  std::memcpy(serialization_buffer_->begin()+offset, src, count);
+  std::memcpy(serialization_buffer_->data() + offset, src, count);
   offset += count;
 }
 
 
+template<class VType>
+void cas::BulkLoader<VType>::SubtreeStats::Add(const std::byte* value, size_t len) {
+  if (nr_keys_ == 0 || std::lexicographical_compare(
+        value, value + len, min_value_.begin(), min_value_.end())) {
+    min_value_.assign(value, value + len);
+  }
+  if (nr_keys_ == 0 || std::lexicographical_compare(
+        max_value_.begin(), max_value_.end(), value, value + len)) {
+    max_value_.assign(value, value + len);
+  }
+  ++nr_keys_;
+}
+
+
+template<class VType>
+void cas::BulkLoader<VType>::SubtreeStats::Merge(
+    const SubtreeStats& child,
+    const std::vector<std::byte>& prefix) {
+  if (child.nr_keys_ == 0) {
+    return;
+  }
+  auto prefixed = [&prefix](const std::vector<std::byte>& value) {
+    std::vector<std::byte> result;
+    result.reserve(prefix.size() + value.size());
+    result.insert(result.end(), prefix.begin(), prefix.end());
+    result.insert(result.end(), value.begin(), value.end());
+    return result;
+  };
+  auto child_min = prefixed(child.min_value_);
+  auto child_max = prefixed(child.max_value_);
+  if (nr_keys_ == 0 || child_min < min_value_) {
+    min_value_ = std::move(child_min);
+  }
+  if (nr_keys_ == 0 || max_value_ < child_max) {
+    max_value_ = std::move(child_max);
+  }
+  nr_keys_ += child.nr_keys_;
+}
+
+
 template<class VType>
 size_t cas::BulkLoader<VType>::Node::ByteSize(int nr_children) const {
   size_t size = 0;
-  // header (dimension: 2 bits, l_P: 12 bits, l_V: 4 bits, m: 14 bits)
-  size += 4;
+  if (varint_header_) {
+    // header (flags: 1 byte, l_P, l_V, m: varints)
+    size_t m = IsLeaf() ? suffixes_.size() : nr_children;
+    size += 1
+      + cas::util::VarintSize(path_.size())
+      + cas::util::VarintSize(value_.size())
+      + cas::util::VarintSize(m);
+  } else {
+    // header (dimension: 2 bits, l_P: 12 bits, l_V: 4 bits, m: 14 bits)
+    size += 4;
+  }
+  // extended header (nr keys: 6 bytes, len: 1 byte or varint, min, max)
+  if (!IsLeaf() && has_subtree_stats_) {
+    size += 6 + 2 * len_subtree_values_;
+    size += varint_header_ ? cas::util::VarintSize(len_subtree_values_) : 1;
+  }
   // lenghts of substrings
   size += path_.size();
   size += value_.size();
   // payload
   if (IsLeaf()) {
-    for (const MemoryKey& suffix : suffixes_) {
-      // header (l_P:1B, l_V:1B)
-      size += 2;
+    // marker of raw or compressed suffixes
+    if (has_leaf_marker_) {
+      size += 1;
+    }
+    for (size_t i = 0; i < suffixes_.size(); ++i) {
+      const MemoryKey& suffix = suffixes_[i];
+      // header (l_P:12 bits, l_V:4 bits or two varints)
+      size += varint_header_
+        ? cas::util::VarintSize(suffix.path_.size())
+          + cas::util::VarintSize(suffix.value_.size())
+        : 2;
       // lenghts of substrings
       size += suffix.path_.size();
       size += suffix.value_.size();
-      size += sizeof(cas::ref_t);
+      size += ref_ids_.empty()
+        ? sizeof(cas::ref_t)
+        : cas::util::VarintSize(ref_ids_[i]);
     }
   } else {
-    // per child => b:1, ptr: 6
-    size += (7 * nr_children);
+    // per child => b:1, ptr: 1-6 (in both node formats)
+    size += (1 + pointer_width_) * nr_children;
   }
   return size;
 }
@@ -722,7 +1523,7 @@ void cas::BulkLoader<VType>::UpdatePartitionStats(
 template<class VType>
 void cas::BulkLoader<VType>::DscByte(
     cas::Partition& partition) {
-  auto buffer = std::make_unique<std::array<std::byte, cas::PAGE_SZ>>();
+  auto buffer = KeyBuffer();
   bool is_first_key = true;
   BinaryKey ref_key{buffer->data()};
   MemoryPage io_page = mpool_.input_.Get();
@@ -736,16 +1537,7 @@ void cas::BulkLoader<VType>::DscByte(
         partition.DscV(key.LenValue());
         is_first_key = false;
       } else {
-        int g_P = 0;
-        int g_V = 0;
-        while (g_P < partition.DscP() && key.Path()[g_P] == ref_key.Path()[g_P]) {
-          ++g_P;
-        }
-        while (g_V < partition.DscV() && key.Value()[g_V] == ref_key.Value()[g_V]) {
-          ++g_V;
-        }
-        partition.DscP(g_P);
-        partition.DscV(g_V);
+        UpdateDscBytes(partition, key, ref_key);
       }
     }
   }
@@ -755,6 +1547,39 @@ void cas::BulkLoader<VType>::DscByte(
 }
 
 
+// shortens the discriminative bytes of partition to the
+// common prefixes of key and the partition's reference key
+template<class VType>
+void cas::BulkLoader<VType>::UpdateDscBytes(
+    cas::Partition& partition,
+    const cas::BinaryKey& key,
+    const cas::BinaryKey& ref_key) {
+  size_t dsc_p = partition.DscP();
+  size_t dsc_v = partition.DscV();
+  UpdateDscBytes(dsc_p, dsc_v, key, ref_key);
+  partition.DscP(dsc_p);
+  partition.DscV(dsc_v);
+}
+
+
+template<class VType>
+void cas::BulkLoader<VType>::UpdateDscBytes(
+    size_t& dsc_p,
+    size_t& dsc_v,
+    const cas::BinaryKey& key,
+    const cas::BinaryKey& ref_key) {
+  // CommonPrefix may read up to len bytes of key
+  dsc_p = std::min<size_t>(dsc_p, key.LenPath());
+  dsc_v = std::min<size_t>(dsc_v, key.LenValue());
+  size_t g_P = cas::CommonPrefix(key.Path(), ref_key.Path(), dsc_p);
+  size_t g_V = cas::CommonPrefix(key.Value(), ref_key.Value(), dsc_v);
+  // the mismatching byte was compared as well
+  stats_.dsc_bytes_compared_ += g_P + (g_P < dsc_p) + g_V + (g_V < dsc_v);
+  dsc_p = g_P;
+  dsc_v = g_V;
+}
+
+
 template<class VType>
 void cas::BulkLoader<VType>::DscByteByByte(
     cas::Partition& partition) {
@@ -763,7 +1588,7 @@ void cas::BulkLoader<VType>::DscByteByByte(
   int dsc_V = 0;
 
   // storage for reference key
-  auto buffer = std::make_unique<std::array<std::byte, cas::PAGE_SZ>>();
+  auto buffer = KeyBuffer();
   BinaryKey ref_key{buffer->data()};
   bool is_first_key = true;
 
@@ -800,6 +1625,48 @@ void cas::BulkLoader<VType>::DscByteByByte(
 }
 
 
+template<class VType>
+void cas::BulkLoader<VType>::InitializeWorkers() {
+  if (context_.nr_threads_ <= 1) {
+    return;
+  }
+  // every worker needs its own input and output pages,
+  // only start as many workers as the memory allows
+  size_t nr_workers = std::min(context_.nr_threads_,
+      mpool_.work_.NrFreePages() / cas::MemoryPools::SliceSize(context_.read_ahead_depth_));
+  if (nr_workers <= 1) {
+    return;
+  }
+  workers_.reserve(nr_workers);
+  for (size_t i = 0; i < nr_workers; ++i) {
+    auto worker = std::make_unique<Worker>();
+    // workers need distinct partition and index files
+    std::string prefix = context_.partition_folder_
+      + "worker" + std::to_string(i) + "_";
+    worker->context_ = context_;
+    worker->context_.partition_folder_ = prefix;
+    worker->context_.index_file_ = prefix + "subtrees";
+    worker->context_.nr_threads_ = 1;
+    worker->loader_ = std::unique_ptr<BulkLoader>(new BulkLoader(
+          worker->context_, worker->stats_, mpool_));
+    worker->loader_->ref_dictionary_ = ref_dictionary_;
+    workers_.push_back(std::move(worker));
+  }
+}
+
+
+template<class VType>
+void cas::BulkLoader<VType>::ReleaseWorkers() {
+  for (auto& worker : workers_) {
+    stats_.Merge(worker->stats_);
+    // returns the worker's pages to mpool_
+    worker->loader_.reset();
+    std::filesystem::remove(worker->context_.index_file_);
+  }
+  workers_.clear();
+}
+
+
 template<class VType>
 void cas::BulkLoader<VType>::InitializeRootPartition(
       cas::Partition& partition) {
@@ -810,10 +1677,12 @@ void cas::BulkLoader<VType>::InitializeRootPartition(
   // after all memory-resident pages of this partition
   size_t first_disk_page_nr = 0;
 
-  // decide how many input pages are processed
+  // decide how many input pages are processed, the header of the
+  // file (if any) is read when the file is opened
+  partition.Open();
   size_t last_disk_page_nr = context_.dataset_size_ > 0
-    ? context_.dataset_size_ / cas::PAGE_SZ
-    : std::filesystem::file_size(partition.Filename()) / cas::PAGE_SZ;
+    ? context_.dataset_size_ / context_.page_size_
+    : partition.NrFilePages();
 
   // decide if we want to use memory pages for the root partition
   bool use_memory_pages =
@@ -12,9 +12,13 @@ void cas::BulkLoaderStats::Dump() const {
   std::cout << "\nfiles_created_: " << files_created_;
   std::cout << "\nmem_pages_read_: " << mem_pages_read_;
   std::cout << "\nmem_pages_written_: " << mem_pages_written_;
+  std::cout << "\npartition_write_requests_: " << partition_write_requests_;
   std::cout << "\nnr_path_nodes_: " << nr_path_nodes_;
   std::cout << "\nnr_value_nodes_: " << nr_value_nodes_;
   std::cout << "\nnr_leaf_nodes_: " << nr_leaf_nodes_;
+  std::cout << "\nnr_compressed_leaves_: " << nr_compressed_leaves_;
+  std::cout << "\nnr_dictionary_refs_: " << nr_dictionary_refs_;
+  std::cout << "\ndsc_bytes_compared_: " << dsc_bytes_compared_;
   PrintByteSize("partition_bytes_read_", partition_bytes_read_);
   PrintByteSize("partition_bytes_written_", partition_bytes_written_);
   PrintByteSize("index_bytes_written_", index_bytes_written_);
@@ -30,7 +34,12 @@ void cas::BulkLoaderStats::Dump() const {
   PrintRuntime("      runtime_partitioning_disk_only_", runtime_partitioning_disk_only_);
   PrintRuntime("    runtime_construct_leaf_node_", runtime_construct_leaf_node_);
   PrintRuntime("runtime_partition_disk_read_", runtime_partition_disk_read_);
+  PrintRuntime("  runtime_partition_decompression_", runtime_partition_decompression_);
+  PrintRuntime("  runtime_partition_read_ahead_wait_", runtime_partition_read_ahead_wait_);
   PrintRuntime("runtime_partition_disk_write_", runtime_partition_disk_write_);
+  PrintRuntime("  runtime_partition_compression_", runtime_partition_compression_);
+  PrintRuntime("  runtime_partition_io_submit_", runtime_partition_io_submit_);
+  PrintRuntime("  runtime_partition_io_wait_", runtime_partition_io_wait_);
   PrintRuntime("runtime_dsc_computation_", runtime_dsc_computation_);
   PrintRuntime("runtime_insertion_", runtime_insertion_);
   PrintRuntime("runtime_collect_keys_", runtime_collect_keys_);
@@ -38,6 +47,52 @@ void cas::BulkLoaderStats::Dump() const {
 }
 
 
+void cas::BulkLoaderStats::Merge(const cas::BulkLoaderStats& other) {
+  nr_bulkloads_ += other.nr_bulkloads_;
+  nr_input_keys_ += other.nr_input_keys_;
+  partitions_created_ += other.partitions_created_;
+  partitions_memory_only_ += other.partitions_memory_only_;
+  partitions_hybrid_ += other.partitions_hybrid_;
+  partitions_disk_only_ += other.partitions_disk_only_;
+  files_created_ += other.files_created_;
+  partition_bytes_read_ += other.partition_bytes_read_;
+  partition_bytes_written_ += other.partition_bytes_written_;
+  index_bytes_written_ += other.index_bytes_written_;
+  index_bytes_read_ += other.index_bytes_read_;
+  mem_pages_read_ += other.mem_pages_read_;
+  mem_pages_written_ += other.mem_pages_written_;
+  partition_write_requests_ += other.partition_write_requests_;
+  nr_path_nodes_ += other.nr_path_nodes_;
+  nr_value_nodes_ += other.nr_value_nodes_;
+  nr_leaf_nodes_ += other.nr_leaf_nodes_;
+  nr_compressed_leaves_ += other.nr_compressed_leaves_;
+  nr_dictionary_refs_ += other.nr_dictionary_refs_;
+  dsc_bytes_compared_ += other.dsc_bytes_compared_;
+  runtime_.Merge(other.runtime_);
+  runtime_root_partition_.Merge(other.runtime_root_partition_);
+  runtime_construction_.Merge(other.runtime_construction_);
+  runtime_partitioning_.Merge(other.runtime_partitioning_);
+  runtime_partitioning_mem_only_.Merge(other.runtime_partitioning_mem_only_);
+  runtime_partitioning_hybrid_.Merge(other.runtime_partitioning_hybrid_);
+  runtime_partitioning_disk_only_.Merge(other.runtime_partitioning_disk_only_);
+  runtime_partition_disk_read_.Merge(other.runtime_partition_disk_read_);
+  runtime_partition_disk_write_.Merge(other.runtime_partition_disk_write_);
+  runtime_partition_io_submit_.Merge(other.runtime_partition_io_submit_);
+  runtime_partition_io_wait_.Merge(other.runtime_partition_io_wait_);
+  runtime_partition_compression_.Merge(other.runtime_partition_compression_);
+  runtime_partition_decompression_.Merge(other.runtime_partition_decompression_);
+  runtime_partition_read_ahead_wait_.Merge(other.runtime_partition_read_ahead_wait_);
+  runtime_construct_leaf_node_.Merge(other.runtime_construct_leaf_node_);
+  runtime_dsc_computation_.Merge(other.runtime_dsc_computation_);
+  runtime_insertion_.Merge(other.runtime_insertion_);
+  runtime_collect_keys_.Merge(other.runtime_collect_keys_);
+  node_depth_.Merge(other.node_depth_);
+  node_fanout_.Merge(other.node_fanout_);
+  inner_node_width_.Merge(other.inner_node_width_);
+  leaf_width_.Merge(other.leaf_width_);
+}
+
+
 size_t cas::BulkLoaderStats::IoOverhead() const {
   return + partition_bytes_read_
     + partition_bytes_written_;
@@ -0,0 +1,135 @@
+#include "cas/common_prefix.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+
+size_t CommonPrefixScalar(const std::byte* a, const std::byte* b, size_t len) {
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t wa;
+    uint64_t wb;
+    std::memcpy(&wa, a + i, 8);
+    std::memcpy(&wb, b + i, 8);
+    uint64_t diff = wa ^ wb;
+    if (diff != 0) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return i + __builtin_ctzll(diff) / 8;
+#else
+      return i + __builtin_clzll(diff) / 8;
+#endif
+    }
+  }
+  while (i < len && a[i] == b[i]) {
+    ++i;
+  }
+  return i;
+}
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse2")))
+size_t CommonPrefixSse2(const std::byte* a, const std::byte* b, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+    if (mask != 0xFFFF) {
+      return i + __builtin_ctz(~mask);
+    }
+  }
+  return i + CommonPrefixScalar(a + i, b + i, len - i);
+}
+
+
+__attribute__((target("avx2")))
+size_t CommonPrefixAvx2(const std::byte* a, const std::byte* b, size_t len) {
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    if (mask != 0xFFFFFFFF) {
+      return i + __builtin_ctz(~mask);
+    }
+  }
+  return i + CommonPrefixSse2(a + i, b + i, len - i);
+}
+
+#endif
+
+
+cas::detail::CommonPrefixFn Kernel(cas::PrefixKernel kernel) {
+  switch (kernel) {
+  case cas::PrefixKernel::Scalar:
+    return &CommonPrefixScalar;
+#if defined(__x86_64__)
+  case cas::PrefixKernel::Sse2:
+    return &CommonPrefixSse2;
+  case cas::PrefixKernel::Avx2:
+    return &CommonPrefixAvx2;
+#endif
+  default:
+    throw std::runtime_error{"prefix kernel " + cas::ToString(kernel)
+      + " is not supported"};
+  }
+}
+
+
+cas::PrefixKernel SelectKernel() {
+  for (auto kernel : {cas::PrefixKernel::Avx2, cas::PrefixKernel::Sse2}) {
+    if (cas::IsSupported(kernel)) {
+      return kernel;
+    }
+  }
+  return cas::PrefixKernel::Scalar;
+}
+
+
+} // namespace
+
+
+const cas::detail::CommonPrefixFn cas::detail::kCommonPrefix = Kernel(SelectKernel());
+
+
+size_t cas::CommonPrefix(
+    PrefixKernel kernel,
+    const std::byte* a,
+    const std::byte* b,
+    size_t len) {
+  return Kernel(kernel)(a, b, len);
+}
+
+
+bool cas::IsSupported(PrefixKernel kernel) {
+#if defined(__x86_64__)
+  // kCommonPrefix is initialized before the CPU model may be
+  __builtin_cpu_init();
+#endif
+  switch (kernel) {
+  case PrefixKernel::Scalar:
+    return true;
+#if defined(__x86_64__)
+  case PrefixKernel::Sse2:
+    return __builtin_cpu_supports("sse2");
+  case PrefixKernel::Avx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+
+cas::PrefixKernel cas::ActivePrefixKernel() {
+  return SelectKernel();
+}
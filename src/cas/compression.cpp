@@ -0,0 +1,142 @@
+#include "cas/compression.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#ifdef CAS_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef CAS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+
+namespace {
+
+// pages are compressed once and read a few times, favor speed
+const int kZstdLevel = 1;
+
+void ThrowUnsupported(cas::Compression compression) {
+  throw std::runtime_error{"compression " + cas::ToString(compression)
+    + " is not supported by this build"};
+}
+
+} // namespace
+
+
+bool cas::IsSupported(Compression compression) {
+  switch (compression) {
+  case Compression::None:
+    return true;
+#ifdef CAS_WITH_LZ4
+  case Compression::Lz4:
+    return true;
+#endif
+#ifdef CAS_WITH_ZSTD
+  case Compression::Zstd:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+
+size_t cas::CompressBound(Compression compression, size_t len) {
+  switch (compression) {
+  case Compression::None:
+    return len;
+#ifdef CAS_WITH_LZ4
+  case Compression::Lz4:
+    return LZ4_compressBound(static_cast<int>(len));
+#endif
+#ifdef CAS_WITH_ZSTD
+  case Compression::Zstd:
+    return ZSTD_compressBound(len);
+#endif
+  default:
+    ThrowUnsupported(compression);
+  }
+  return 0;
+}
+
+
+size_t cas::Compress(
+    Compression compression,
+    const std::byte* src,
+    size_t len,
+    std::byte* dst,
+    size_t capacity) {
+  switch (compression) {
+  case Compression::None:
+    if (len > capacity) {
+      throw std::runtime_error{"compression buffer too small"};
+    }
+    std::copy(src, src + len, dst);
+    return len;
+#ifdef CAS_WITH_LZ4
+  case Compression::Lz4: {
+    int size = LZ4_compress_default(
+        reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+        static_cast<int>(len), static_cast<int>(capacity));
+    if (size <= 0) {
+      throw std::runtime_error{"LZ4 compression failed"};
+    }
+    return size;
+  }
+#endif
+#ifdef CAS_WITH_ZSTD
+  case Compression::Zstd: {
+    size_t size = ZSTD_compress(dst, capacity, src, len, kZstdLevel);
+    if (ZSTD_isError(size)) {
+      throw std::runtime_error{"zstd compression failed: "
+        + std::string{ZSTD_getErrorName(size)}};
+    }
+    return size;
+  }
+#endif
+  default:
+    ThrowUnsupported(compression);
+  }
+  return 0;
+}
+
+
+size_t cas::Decompress(
+    Compression compression,
+    const std::byte* src,
+    size_t len,
+    std::byte* dst,
+    size_t capacity) {
+  switch (compression) {
+  case Compression::None:
+    if (len > capacity) {
+      throw std::runtime_error{"decompression buffer too small"};
+    }
+    std::copy(src, src + len, dst);
+    return len;
+#ifdef CAS_WITH_LZ4
+  case Compression::Lz4: {
+    int size = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+        static_cast<int>(len), static_cast<int>(capacity));
+    if (size < 0) {
+      throw std::runtime_error{"LZ4 decompression failed"};
+    }
+    return size;
+  }
+#endif
+#ifdef CAS_WITH_ZSTD
+  case Compression::Zstd: {
+    size_t size = ZSTD_decompress(dst, capacity, src, len);
+    if (ZSTD_isError(size)) {
+      throw std::runtime_error{"zstd decompression failed: "
+        + std::string{ZSTD_getErrorName(size)}};
+    }
+    return size;
+  }
+#endif
+  default:
+    ThrowUnsupported(compression);
+  }
+  return 0;
+}
@@ -19,6 +19,13 @@ double cas::Histogram::Average() const {
 }
 
 
+void cas::Histogram::Merge(const cas::Histogram& other) {
+  for (const auto& [value, count] : other.data_) {
+    data_[value] += count;
+  }
+}
+
+
 size_t cas::Histogram::Count() const {
   size_t sum = 0;
   for (const auto& [_,count] : data_) {
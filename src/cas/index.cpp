@@ -1,11 +1,16 @@
 #include "cas/index.hpp"
 #include "cas/query.hpp"
+#include "cas/query_engine.hpp"
 #include "cas/key_encoder.hpp"
 #include "cas/key_decoder.hpp"
+#include "cas/batch_query.hpp"
 #include "cas/bulk_loader.hpp"
+#include "cas/common_prefix.hpp"
 #include "cas/query_executor.hpp"
+#include "cas/top_k_query.hpp"
 #include "cas/mem/insertion.hpp"
 #include "cas/util.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <random>
 
@@ -51,10 +56,11 @@ void cas::Index<VType>::HandleOverflow() {
 
   // create a function to store keys in the partition
   std::vector<std::byte> key_buffer;
-  key_buffer.resize(cas::PAGE_SZ);
+  key_buffer.resize(context_.page_size_);
   std::vector<std::byte> page_buffer;
-  page_buffer.resize(cas::PAGE_SZ);
-  cas::MemoryPage io_page{&page_buffer[0]};
+  page_buffer.resize(context_.page_size_);
+  cas::MemoryPage io_page{&page_buffer[0], context_.page_size_};
+  io_page.Reset(context_.page_format_);
   const auto emitter = [&](
           const cas::QueryBuffer& path, size_t p_len,
           const cas::QueryBuffer& value, size_t v_len,
@@ -77,13 +83,12 @@ void cas::Index<VType>::HandleOverflow() {
     std::memcpy(tmp_key.Value(), &value[0], v_len);
     tmp_key.Ref(ref);
     // proactively compute dsc bytes
-    int gP = 0, gV = 0;
-    while (gP < dsc_p && ref_key.path_[gP]  == static_cast<uint8_t>(tmp_key.Path()[gP]))  { ++gP; }
-    while (gV < dsc_v && ref_key.value_[gV] == static_cast<uint8_t>(tmp_key.Value()[gV])) { ++gV; }
-    dsc_p = gP;
-    dsc_v = gV;
+    dsc_p = cas::CommonPrefix(tmp_key.Path(),
+        reinterpret_cast<const std::byte*>(ref_key.path_.data()), dsc_p);
+    dsc_v = cas::CommonPrefix(tmp_key.Value(),
+        reinterpret_cast<const std::byte*>(ref_key.value_.data()), dsc_v);
     // add key to io_page
-    if (tmp_key.ByteSize() > io_page.FreeSpace()) {
+    if (!io_page.Fits(tmp_key)) {
       partition.PushToDisk(io_page);
       ++partition.NrPages();
       io_page.Reset();
@@ -149,6 +154,7 @@ void cas::Index<VType>::HandleOverflow() {
     std::string filename = context_.pipeline_dir_ + "/index.bin" + std::to_string(i);
     std::filesystem::remove(filename);
   }
+  reader_.reset();
   cas::util::AddToTimer(stats_.runtime_, start);
 }
 
@@ -179,6 +185,7 @@ void cas::Index<VType>::BulkLoad() {
     + "index.bin"
     + std::to_string(k);
   std::filesystem::rename(context_copy.index_file_, new_index_file);
+  reader_.reset();
 }
 
 
@@ -199,14 +206,32 @@ cas::QueryStats cas::Index<VType>::Query(
     const cas::BinaryKeyEmitter emitter)
 {
   std::vector<cas::QueryStats> stats;
+  ThreadPool* pool = context_.query_parallel_fanout_ > 0 ? query_pool_ : nullptr;
+  // sequential queries use the specialized traversal of QueryEngine
+  bool use_engine = context_.use_query_engine_ && pool == nullptr;
 
   // query the in-memory index
-  if (root_ != nullptr) {
+  if (root_ != nullptr && use_engine) {
+    cas::QueryEngine<cas::mem::Node, const cas::BinaryKeyEmitter> query{root_, key, emitter};
+    query.Execute();
+    stats.push_back(query.Stats());
+  } else if (root_ != nullptr) {
     cas::Query query{root_, key, emitter};
+    if (pool != nullptr) {
+      query.Parallelize(*pool, context_.query_parallel_fanout_);
+    }
     query.Execute();
     stats.push_back(query.Stats());
   }
 
+  // query every disk-based index through the long-lived mappings
+  if (context_.use_index_reader_) {
+    stats.push_back(use_engine
+        ? Reader()->ExecuteInlined(key, emitter)
+        : Reader()->Execute(key, emitter, pool, context_.query_parallel_fanout_));
+    return cas::QueryStats::Sum(stats);
+  }
+
   // check if the the pipeline folder exists
   if (!std::filesystem::is_directory(context_.pipeline_dir_) ||
       !std::filesystem::exists(context_.pipeline_dir_)) {
@@ -226,6 +251,180 @@ cas::QueryStats cas::Index<VType>::Query(
 
 
 
+template<class VType>
+cas::QueryStats cas::Index<VType>::Count(const cas::SearchKey<VType>& key) {
+  bool reversed = false;
+  auto search_key = cas::KeyEncoder<VType>::Encode(key, reversed);
+  return Count(search_key);
+}
+
+
+template<class VType>
+cas::QueryStats cas::Index<VType>::Count(const cas::BinarySK& key) {
+  std::vector<cas::QueryStats> stats;
+  if (root_ != nullptr) {
+    cas::QueryEngine<cas::mem::Node, const cas::BinaryKeyEmitter> query{
+      root_, key, cas::kNullEmitter};
+    query.CountOnly();
+    query.Execute();
+    stats.push_back(query.Stats());
+  }
+  stats.push_back(Reader()->Count(key));
+  return cas::QueryStats::Sum(stats);
+}
+
+
+template<class VType>
+cas::QueryStats cas::Index<VType>::Query(
+    const cas::SearchKey<VType>& key,
+    const cas::BinaryKeyEmitter emitter,
+    size_t limit,
+    cas::QueryOrder order)
+{
+  bool reversed = false;
+  auto search_key = cas::KeyEncoder<VType>::Encode(key, reversed);
+  return Query(search_key, emitter, limit, order);
+}
+
+
+template<class VType>
+cas::QueryStats cas::Index<VType>::Query(
+    const cas::BinarySK& key,
+    const cas::BinaryKeyEmitter emitter,
+    size_t limit,
+    cas::QueryOrder order)
+{
+  if (order == cas::QueryOrder::Unordered) {
+    auto cursor = Query(key, limit);
+    while (cursor.Next()) {
+      emitter(cursor.Path(), cursor.LenPath(),
+          cursor.Value(), cursor.LenValue(), cursor.Ref());
+    }
+    return cursor.Stats();
+  }
+
+  // every index contributes its own top-k matches, which are merged
+  struct Match {
+    std::vector<std::byte> path_;
+    std::vector<std::byte> value_;
+    cas::ref_t ref_;
+  };
+  std::vector<Match> matches;
+  auto collect = [&matches](
+      const cas::QueryBuffer& path, size_t p_len,
+      const cas::QueryBuffer& value, size_t v_len,
+      cas::ref_t ref) -> void {
+    matches.push_back(Match{
+        {path.begin(), path.begin() + p_len},
+        {value.begin(), value.begin() + v_len},
+        ref});
+  };
+
+  std::vector<cas::QueryStats> stats;
+  if (root_ != nullptr) {
+    cas::TopKQuery<cas::mem::Node, decltype(collect)> query{
+      root_, key, collect, limit, order};
+    query.Execute();
+    stats.push_back(query.Stats());
+  }
+  auto reader = Reader();
+  for (size_t i = 0; i < reader->NrFiles(); ++i) {
+    cas::NodeReader root = reader->Root(i);
+    cas::TopKQuery<cas::NodeReader, decltype(collect)> query{
+      &root, key, collect, limit, order};
+    query.Execute();
+    stats.push_back(query.Stats());
+  }
+
+  // the matches of each index are already sorted
+  std::stable_sort(matches.begin(), matches.end(),
+      [order](const Match& a, const Match& b) {
+    return order == cas::QueryOrder::ValueAsc
+      ? a.value_ < b.value_
+      : b.value_ < a.value_;
+  });
+  auto result = cas::QueryStats::Sum(stats);
+  result.nr_matches_ = std::min(limit, matches.size());
+  auto buf_pat = std::make_unique<cas::QueryBuffer>();
+  auto buf_val = std::make_unique<cas::QueryBuffer>();
+  for (size_t i = 0; i < result.nr_matches_; ++i) {
+    const auto& match = matches[i];
+    std::copy(match.path_.begin(), match.path_.end(), buf_pat->begin());
+    std::copy(match.value_.begin(), match.value_.end(), buf_val->begin());
+    emitter(*buf_pat, match.path_.size(), *buf_val, match.value_.size(), match.ref_);
+  }
+  return result;
+}
+
+
+template<class VType>
+cas::QueryCursor cas::Index<VType>::Query(
+    const cas::SearchKey<VType>& key,
+    size_t limit)
+{
+  bool reversed = false;
+  auto search_key = cas::KeyEncoder<VType>::Encode(key, reversed);
+  return Query(search_key, limit);
+}
+
+
+template<class VType>
+cas::QueryCursor cas::Index<VType>::Query(
+    const cas::BinarySK& key,
+    size_t limit)
+{
+  return cas::QueryCursor{root_, Reader(), key, limit};
+}
+
+
+template<class VType>
+cas::QueryStats cas::Index<VType>::QueryBatch(
+    const std::vector<cas::BinarySK>& keys,
+    const std::vector<cas::BinaryKeyEmitter>& emitters,
+    std::vector<cas::QueryStats>* query_stats)
+{
+  std::vector<cas::QueryStats> stats;
+  std::vector<std::vector<cas::QueryStats>> stats_per_query(keys.size());
+  auto collect = [&](const auto& query) {
+    stats.push_back(query.Stats());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      stats_per_query[i].push_back(query.StatsPerQuery()[i]);
+    }
+  };
+
+  if (root_ != nullptr) {
+    cas::BatchQuery<cas::mem::Node> query{root_, keys, emitters};
+    query.Execute();
+    collect(query);
+  }
+  auto reader = Reader();
+  for (size_t i = 0; i < reader->NrFiles(); ++i) {
+    cas::NodeReader root = reader->Root(i);
+    cas::BatchQuery<cas::NodeReader> query{&root, keys, emitters};
+    query.Execute();
+    collect(query);
+  }
+
+  if (query_stats != nullptr) {
+    query_stats->clear();
+    for (const auto& s : stats_per_query) {
+      query_stats->push_back(cas::QueryStats::Sum(s));
+    }
+  }
+  return cas::QueryStats::Sum(stats);
+}
+
+
+template<class VType>
+std::shared_ptr<const cas::IndexReader> cas::Index<VType>::Reader() {
+  std::lock_guard<std::mutex> guard{reader_mutex_};
+  if (reader_ == nullptr || reader_->IsStale()) {
+    reader_ = std::make_shared<const cas::IndexReader>(
+        context_.pipeline_dir_, context_.index_advice_);
+  }
+  return reader_;
+}
+
 
 template<class VType>
 void cas::Index<VType>::DeleteNodesRecursively(cas::INode* node) {
@@ -260,6 +459,7 @@ void cas::Index<VType>::ClearPipelineFiles() {
   for (const auto& entry : std::filesystem::directory_iterator(context_.pipeline_dir_)) {
     std::filesystem::remove_all(entry);
   }
+  reader_.reset();
 }
 
 
@@ -0,0 +1,83 @@
+#include "cas/index_layout.hpp"
+#include "cas/compression.hpp"
+#include "cas/util.hpp"
+#include <stdexcept>
+
+
+cas::IndexLayout cas::IndexLayout::Read(const uint8_t* data, size_t size) {
+  IndexLayout layout;
+  layout.nodes_end_ = size;
+  if (size < TRAILER_SZ) {
+    return layout;
+  }
+  const uint8_t* trailer = data + size - TRAILER_SZ;
+  uint64_t magic;
+  std::memcpy(&magic, trailer + 24, sizeof(uint64_t));
+  if (magic != MAGIC) {
+    return layout;
+  }
+  uint64_t nodes_end;
+  uint64_t nr_refs;
+  uint32_t flags;
+  uint32_t compression;
+  std::memcpy(&nodes_end, trailer + 0, sizeof(uint64_t));
+  std::memcpy(&nr_refs, trailer + 8, sizeof(uint64_t));
+  std::memcpy(&flags, trailer + 16, sizeof(uint32_t));
+  std::memcpy(&compression, trailer + 20, sizeof(uint32_t));
+  if (nodes_end + nr_refs * sizeof(ref_t) + TRAILER_SZ != size) {
+    throw std::runtime_error{"corrupt index trailer"};
+  }
+  layout.nodes_end_ = nodes_end;
+  layout.ref_ids_ = (flags & FLAG_REF_IDS) != 0;
+  layout.varint_headers_ = (flags & FLAG_VARINT_HEADERS) != 0;
+  layout.refs_ = data + nodes_end;
+  layout.nr_refs_ = nr_refs;
+  layout.leaf_compression_ = static_cast<Compression>(compression);
+  if (!IsSupported(layout.leaf_compression_)) {
+    throw std::runtime_error{"leaf compression "
+      + ToString(layout.leaf_compression_) + " is not supported by this build"};
+  }
+  return layout;
+}
+
+
+void cas::IndexLayout::WriteTrailer(uint8_t* dst) const {
+  uint64_t nodes_end = nodes_end_;
+  uint64_t nr_refs = nr_refs_;
+  uint32_t flags = 0;
+  if (ref_ids_) {
+    flags |= FLAG_REF_IDS;
+  }
+  if (varint_headers_) {
+    flags |= FLAG_VARINT_HEADERS;
+  }
+  uint32_t compression = static_cast<uint32_t>(leaf_compression_);
+  uint64_t magic = MAGIC;
+  std::memcpy(dst + 0, &nodes_end, sizeof(uint64_t));
+  std::memcpy(dst + 8, &nr_refs, sizeof(uint64_t));
+  std::memcpy(dst + 16, &flags, sizeof(uint32_t));
+  std::memcpy(dst + 20, &compression, sizeof(uint32_t));
+  std::memcpy(dst + 24, &magic, sizeof(uint64_t));
+}
+
+
+void cas::DecompressLeaf(
+    Compression compression,
+    const uint8_t* data,
+    std::vector<uint8_t>& suffixes) {
+  if (*data != IndexLayout::LEAF_COMPRESSED) {
+    throw std::runtime_error{"leaf is not compressed"};
+  }
+  size_t raw_size;
+  size_t compressed_size;
+  const uint8_t* src = data + 1;
+  src = cas::util::ReadVarint(src, raw_size);
+  src = cas::util::ReadVarint(src, compressed_size);
+  suffixes.resize(raw_size);
+  size_t size = Decompress(compression,
+      reinterpret_cast<const std::byte*>(src), compressed_size,
+      reinterpret_cast<std::byte*>(suffixes.data()), raw_size);
+  if (size != raw_size) {
+    throw std::runtime_error{"corrupt compressed leaf"};
+  }
+}
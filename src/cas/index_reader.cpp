@@ -0,0 +1,147 @@
+#include "cas/index_reader.hpp"
+#include "cas/node_reader.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+namespace {
+
+int ToMadvise(cas::IndexAdvice advice) {
+  switch (advice) {
+    case cas::IndexAdvice::Normal:
+      return MADV_NORMAL;
+    case cas::IndexAdvice::Random:
+      return MADV_RANDOM;
+    case cas::IndexAdvice::Sequential:
+      return MADV_SEQUENTIAL;
+    case cas::IndexAdvice::WillNeed:
+      return MADV_WILLNEED;
+    default:
+      throw std::runtime_error{"unknown IndexAdvice"};
+  }
+}
+
+} // namespace
+
+
+cas::IndexReader::IndexReader(const std::string& pipeline_dir,
+    IndexAdvice advice)
+  : pipeline_dir_(pipeline_dir)
+{
+  // take the timestamp first such that concurrent changes make us stale
+  struct stat st;
+  if (stat(pipeline_dir_.c_str(), &st) == -1 || !S_ISDIR(st.st_mode)) {
+    return;
+  }
+  dir_exists_ = true;
+  dir_mtime_ = st.st_mtim;
+
+  std::vector<std::string> filenames;
+  for (const auto& entry : std::filesystem::directory_iterator(pipeline_dir_)) {
+    if (entry.is_regular_file()) {
+      filenames.push_back(entry.path().string());
+    }
+  }
+  std::sort(filenames.begin(), filenames.end());
+  files_.reserve(filenames.size());
+  for (const auto& filename : filenames) {
+    Map(filename, advice);
+  }
+}
+
+
+cas::IndexReader::~IndexReader() {
+  for (const auto& file : files_) {
+    if (munmap(file.data_, file.size_) < 0) {
+      std::cerr << "could not munmap allocated memory" << std::endl;
+      std::terminate();
+    }
+  }
+}
+
+
+void cas::IndexReader::Map(const std::string& filename, IndexAdvice advice) {
+  int fd = open(filename.c_str(), O_RDONLY, S_IRUSR);
+  if (fd == -1) {
+    std::string error_msg = "failed to open file '" + filename + "'";
+    throw std::runtime_error{error_msg};
+  }
+  size_t file_size = std::filesystem::file_size(filename);
+  if (file_size == 0) {
+    close(fd);
+    return;
+  }
+
+  auto* data = static_cast<uint8_t*>(mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0));
+  if (data == MAP_FAILED) {
+    close(fd);
+    std::string error_msg = "mmap of file '" + filename + "' failed";
+    throw std::runtime_error{error_msg};
+  }
+  // the mapping stays valid after the file is closed
+  if (close(fd) == -1) {
+    munmap(data, file_size);
+    throw std::runtime_error{"error while closing file '" + filename + "'"};
+  }
+  cas::IndexLayout layout;
+  try {
+    layout = cas::IndexLayout::Read(data, file_size);
+  } catch (...) {
+    munmap(data, file_size);
+    throw;
+  }
+  files_.push_back({filename, data, file_size, layout});
+  // the advice is only a hint, we can safely ignore if it fails
+  madvise(data, file_size, ToMadvise(advice));
+}
+
+
+cas::QueryStats cas::IndexReader::Execute(
+    const BinarySK& key,
+    const BinaryKeyEmitter& emitter,
+    ThreadPool* pool,
+    size_t min_fanout) const {
+  std::vector<cas::QueryStats> stats;
+  stats.reserve(files_.size());
+  for (const auto& file : files_) {
+    cas::NodeReader root{file.data_, 0, &file.layout_};
+    cas::Query query{&root, key, emitter};
+    if (pool != nullptr) {
+      query.Parallelize(*pool, min_fanout);
+    }
+    query.Execute();
+    stats.push_back(query.Stats());
+  }
+  return cas::QueryStats::Sum(stats);
+}
+
+
+cas::QueryStats cas::IndexReader::Count(const BinarySK& key) const {
+  std::vector<cas::QueryStats> stats;
+  stats.reserve(files_.size());
+  for (const auto& file : files_) {
+    cas::NodeReader root{file.data_, 0, &file.layout_};
+    cas::QueryEngine<cas::NodeReader, const cas::BinaryKeyEmitter> query{
+      &root, key, cas::kNullEmitter};
+    query.CountOnly();
+    query.Execute();
+    stats.push_back(query.Stats());
+  }
+  return cas::QueryStats::Sum(stats);
+}
+
+
+bool cas::IndexReader::IsStale() const {
+  struct stat st;
+  bool dir_exists = stat(pipeline_dir_.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  if (dir_exists != dir_exists_) {
+    return true;
+  }
+  return dir_exists &&
+    (st.st_mtim.tv_sec != dir_mtime_.tv_sec || st.st_mtim.tv_nsec != dir_mtime_.tv_nsec);
+}
@@ -0,0 +1,534 @@
+#include "cas/io_engine.hpp"
+#include "cas/util.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#define CAS_HAS_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+
+#ifdef CAS_HAS_IO_URING
+
+// a minimal io_uring wrapper that talks to the kernel directly such that
+// we do not depend on liburing
+struct cas::IoEngine::Ring {
+  int fd_ = -1;
+  void* sq_ptr_ = MAP_FAILED;
+  size_t sq_sz_ = 0;
+  void* cq_ptr_ = MAP_FAILED;
+  size_t cq_sz_ = 0;
+  io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqes_sz_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+
+  bool Setup(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+      return false;
+    }
+#ifdef IORING_FEAT_RW_CUR_POS
+    // IORING_OP_READ/WRITE are available since the same kernel release
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return false;
+    }
+#else
+    return false;
+#endif
+    sq_sz_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_sz_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+      sq_sz_ = cq_sz_ = std::max(sq_sz_, cq_sz_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_sz_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      cq_ptr_ = mmap(nullptr, cq_sz_, PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+      if (cq_ptr_ == MAP_FAILED) {
+        return false;
+      }
+    }
+    sqes_sz_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_sz_,
+          PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+    auto* sq = static_cast<std::byte*>(sq_ptr_);
+    auto* cq = static_cast<std::byte*>(cq_ptr_);
+    sq_tail_  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  ~Ring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_sz_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_sz_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_sz_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+};
+
+#else
+
+struct cas::IoEngine::Ring {
+  bool Setup(unsigned /* entries */) { return false; }
+};
+
+#endif
+
+
+namespace {
+
+// upper bound of the extents that are preallocated ahead of the
+// written pages of a file whose size is not known
+const size_t kMaxPreallocationPages = 1024;
+
+} // namespace
+
+
+cas::IoEngine::IoEngine(size_t queue_depth, BulkLoaderStats& stats,
+    size_t write_behind_pages, size_t page_size)
+  : stats_(stats)
+  , queue_depth_(queue_depth)
+  , page_size_(page_size)
+  , write_behind_pages_(write_behind_pages)
+{
+  if (queue_depth_ > 0) {
+    // one half of the slots is reserved for reads, the other one for writes
+    size_t nr_slots = 2 * queue_depth_;
+    ring_ = std::make_unique<Ring>();
+    // the buffers need to be page-aligned for O_DIRECT
+    void* buffers = MAP_FAILED;
+    if (ring_->Setup(nr_slots)) {
+      buffers = mmap(nullptr, nr_slots * page_size_, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (buffers != MAP_FAILED) {
+      buffers_ = static_cast<std::byte*>(buffers);
+      slots_.resize(nr_slots);
+      for (size_t i = 0; i < nr_slots; ++i) {
+        slots_[i].buffer_ = buffers_ + i * page_size_;
+      }
+      return;
+    }
+    // fall back to synchronous I/O
+    ring_.reset();
+  }
+  if (write_behind_pages_ == 0) {
+    return;
+  }
+  void* buffers = mmap(nullptr, write_behind_pages_ * page_size_,
+      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED) {
+    // write every page immediately
+    return;
+  }
+  write_buffers_ = static_cast<std::byte*>(buffers);
+  free_write_buffers_.reserve(write_behind_pages_);
+  for (size_t i = write_behind_pages_; i > 0; --i) {
+    free_write_buffers_.push_back(i - 1);
+  }
+}
+
+
+cas::IoEngine::~IoEngine() {
+  if (ring_ != nullptr) {
+    // the kernel must not write into the buffers after they are unmapped
+    try {
+      while (nr_in_flight_ > 0) {
+        Enter(1);
+      }
+    } catch (...) {}
+  }
+  ring_.reset();
+  if (buffers_ != nullptr) {
+    munmap(buffers_, slots_.size() * page_size_);
+  }
+  if (write_buffers_ != nullptr) {
+    munmap(write_buffers_, write_behind_pages_ * page_size_);
+  }
+}
+
+
+int cas::IoEngine::ReadPage(int fd, MemoryPage& page,
+    size_t page_nr, size_t last_page_nr) {
+  bool in_order = stream_fd_ == fd
+    && !stream_.empty()
+    && slots_[stream_.front()].page_nr_ == page_nr;
+  if (in_order) {
+    stream_window_ = std::min(2 * stream_window_, queue_depth_);
+  } else {
+    CancelStream();
+    stream_fd_ = fd;
+    stream_next_page_nr_ = page_nr;
+    stream_window_ = 1;
+  }
+  stream_last_page_nr_ = last_page_nr;
+  FillStream();
+
+  size_t slot = stream_.front();
+  stream_.pop_front();
+  while (slots_[slot].state_ == SlotState::READING) {
+    Enter(1);
+  }
+  int bytes_read = slots_[slot].result_;
+  if (bytes_read > 0) {
+    std::memcpy(page.Data(), slots_[slot].buffer_, bytes_read);
+  }
+  slots_[slot].state_ = SlotState::FREE;
+
+  // keep the next reads in flight while the caller processes page
+  if (bytes_read == static_cast<int>(page_size_)) {
+    FillStream();
+  } else {
+    CancelStream();
+  }
+  return bytes_read;
+}
+
+
+int cas::IoEngine::WritePage(int fd, const MemoryPage& page, size_t page_nr) {
+  if (!IsAsync()) {
+    return BufferPage(fd, page, page_nr);
+  }
+  size_t slot = slots_.size();
+  while (slot == slots_.size()) {
+    for (size_t i = queue_depth_; i < slots_.size(); ++i) {
+      if (slots_[i].state_ == SlotState::FREE) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot == slots_.size()) {
+      Enter(1);
+    }
+  }
+  auto& writes = writes_[fd];
+  if (writes.nr_failed_ > 0) {
+    return -1;
+  }
+  ++writes.nr_pending_;
+  std::memcpy(slots_[slot].buffer_, page.Data(), page_size_);
+  slots_[slot].state_ = SlotState::WRITING;
+  slots_[slot].fd_ = fd;
+  slots_[slot].page_nr_ = page_nr;
+#ifdef CAS_HAS_IO_URING
+  Prepare(slot, IORING_OP_WRITE);
+#endif
+  ++stats_.partition_write_requests_;
+  // writes are submitted in batches of half the queue depth
+  if (++nr_unsubmitted_writes_ >= std::max<size_t>(1, queue_depth_ / 2)) {
+    Enter(0);
+  }
+  return page_size_;
+}
+
+
+bool cas::IoEngine::Flush(int fd) {
+  auto file = files_.find(fd);
+  if (file != files_.end() && !WriteBack(fd, file->second)) {
+    return false;
+  }
+  auto it = writes_.find(fd);
+  if (it == writes_.end()) {
+    return true;
+  }
+  if (stream_fd_ == fd) {
+    CancelStream();
+    stream_fd_ = -1;
+  }
+  // submits the writes of fd that are still queued, the entry of fd is
+  // removed once its last write completed successfully
+  while (it != writes_.end() && it->second.nr_pending_ > 0) {
+    Enter(1);
+    it = writes_.find(fd);
+  }
+  if (it == writes_.end()) {
+    return true;
+  }
+  writes_.erase(it);
+  return false;
+}
+
+
+bool cas::IoEngine::HasPendingWrites(int fd) const {
+  auto file = files_.find(fd);
+  if (file != files_.end() && !file->second.pages_.empty()) {
+    return true;
+  }
+  return writes_.find(fd) != writes_.end();
+}
+
+
+bool cas::IoEngine::Close(int fd) {
+  bool success = Flush(fd);
+  // fd might be reused for another file after it is closed
+  files_.erase(fd);
+  if (stream_fd_ == fd) {
+    CancelStream();
+    stream_fd_ = -1;
+  }
+  return success;
+}
+
+
+void cas::IoEngine::Preallocate(int fd, size_t nr_pages) {
+  auto& file = files_[fd];
+  // a single page is allocated as cheaply when it is written
+  if (nr_pages <= file.reserved_pages_ + 1) {
+    return;
+  }
+  fallocate(fd, FALLOC_FL_KEEP_SIZE, file.reserved_pages_ * page_size_,
+      (nr_pages - file.reserved_pages_) * page_size_);
+  file.reserved_pages_ = nr_pages;
+}
+
+
+int cas::IoEngine::BufferPage(int fd, const MemoryPage& page, size_t page_nr) {
+  if (write_buffers_ == nullptr) {
+    return -1;
+  }
+  if (free_write_buffers_.empty()) {
+    // sequential runs are longest for the file with the most pages
+    auto victim = std::max_element(files_.begin(), files_.end(),
+        [](const auto& lhs, const auto& rhs) {
+          return lhs.second.pages_.size() < rhs.second.pages_.size();
+        });
+    if (!WriteBack(victim->first, victim->second)) {
+      return -1;
+    }
+  }
+  size_t buffer = free_write_buffers_.back();
+  free_write_buffers_.pop_back();
+  std::memcpy(write_buffers_ + buffer * page_size_, page.Data(), page_size_);
+  files_[fd].pages_.emplace_back(page_nr, buffer);
+  return page_size_;
+}
+
+
+// writes the pending pages of file in runs of consecutive pages and
+// returns their buffers to the free list
+bool cas::IoEngine::WriteBack(int fd, File& file) {
+  auto& pages = file.pages_;
+  if (pages.empty()) {
+    return true;
+  }
+  // a page that is written twice keeps its latest content
+  std::stable_sort(pages.begin(), pages.end(),
+      [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  size_t end = pages.back().first + 1;
+  if (end > file.reserved_pages_) {
+    size_t extent = std::min(std::max<size_t>(file.reserved_pages_, 1),
+        kMaxPreallocationPages);
+    Preallocate(fd, std::max(end, file.reserved_pages_ + extent));
+  }
+  bool success = true;
+  std::vector<iovec> iov;
+  iov.reserve(std::min<size_t>(pages.size(), IOV_MAX));
+  for (size_t i = 0; i < pages.size(); ) {
+    size_t page_nr = pages[i].first;
+    iov.clear();
+    while (i < pages.size() && pages[i].first == page_nr + iov.size()
+        && iov.size() < IOV_MAX) {
+      iov.push_back(iovec{write_buffers_ + pages[i].second * page_size_,
+          page_size_});
+      free_write_buffers_.push_back(pages[i].second);
+      ++i;
+    }
+    success &= WriteRun(fd, iov.data(), static_cast<int>(iov.size()), page_nr);
+  }
+  pages.clear();
+  return success;
+}
+
+
+bool cas::IoEngine::WriteRun(int fd, iovec* iov, int iovcnt, size_t page_nr) {
+  off_t offset = page_nr * page_size_;
+  while (iovcnt > 0) {
+    ssize_t rt = pwritev(fd, iov, iovcnt, offset);
+    ++stats_.partition_write_requests_;
+    if (rt < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rt <= 0) {
+      return false;
+    }
+    // continue after a partial write
+    offset += rt;
+    size_t written = static_cast<size_t>(rt);
+    while (iovcnt > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<std::byte*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+  return true;
+}
+
+
+void cas::IoEngine::FillStream() {
+  while (stream_.size() < stream_window_
+      && stream_next_page_nr_ < stream_last_page_nr_) {
+    size_t slot = queue_depth_;
+    for (size_t i = 0; i < queue_depth_; ++i) {
+      if (slots_[i].state_ == SlotState::FREE) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot == queue_depth_) {
+      // discarded reads are still in flight
+      break;
+    }
+    slots_[slot].state_ = SlotState::READING;
+    slots_[slot].fd_ = stream_fd_;
+    slots_[slot].page_nr_ = stream_next_page_nr_++;
+#ifdef CAS_HAS_IO_URING
+    Prepare(slot, IORING_OP_READ);
+#endif
+    stream_.push_back(slot);
+  }
+  if (stream_.empty() && stream_next_page_nr_ < stream_last_page_nr_) {
+    // all read slots are occupied by discarded reads
+    Enter(1);
+    FillStream();
+    return;
+  }
+  Enter(0);
+}
+
+
+void cas::IoEngine::CancelStream() {
+  for (size_t slot : stream_) {
+    slots_[slot].state_ = slots_[slot].state_ == SlotState::READING
+      ? SlotState::DISCARDED
+      : SlotState::FREE;
+  }
+  stream_.clear();
+}
+
+
+#ifdef CAS_HAS_IO_URING
+
+void cas::IoEngine::Prepare(size_t slot, uint8_t opcode) {
+  unsigned tail = *ring_->sq_tail_;
+  unsigned index = tail & *ring_->sq_mask_;
+  io_uring_sqe* sqe = &ring_->sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = slots_[slot].fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(slots_[slot].buffer_);
+  sqe->len = page_size_;
+  sqe->off = slots_[slot].page_nr_ * page_size_;
+  sqe->user_data = slot;
+  ring_->sq_array_[index] = index;
+  // publish the entry to the kernel
+  __atomic_store_n(ring_->sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++nr_unsubmitted_;
+  ++nr_in_flight_;
+}
+
+
+void cas::IoEngine::Enter(size_t min_complete) {
+  if (nr_unsubmitted_ == 0 && min_complete == 0) {
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  int rt;
+  do {
+    rt = static_cast<int>(syscall(__NR_io_uring_enter, ring_->fd_,
+          nr_unsubmitted_, min_complete, flags, nullptr, 0));
+  } while (rt < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+  if (rt < 0) {
+    throw std::runtime_error{"io_uring_enter failed: "
+      + std::string{std::strerror(errno)}};
+  }
+  nr_unsubmitted_ -= static_cast<size_t>(rt);
+  nr_unsubmitted_writes_ = std::min(nr_unsubmitted_writes_, nr_unsubmitted_);
+  cas::util::AddToTimer(min_complete > 0
+      ? stats_.runtime_partition_io_wait_
+      : stats_.runtime_partition_io_submit_, start);
+  Reap();
+}
+
+
+void cas::IoEngine::Reap() {
+  unsigned head = *ring_->cq_head_;
+  unsigned tail = __atomic_load_n(ring_->cq_tail_, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    const io_uring_cqe& cqe = ring_->cqes_[head & *ring_->cq_mask_];
+    auto& slot = slots_[cqe.user_data];
+    slot.result_ = cqe.res;
+    switch (slot.state_) {
+      case SlotState::READING:
+        slot.state_ = SlotState::READ;
+        break;
+      case SlotState::WRITING: {
+        auto it = writes_.find(slot.fd_);
+        --it->second.nr_pending_;
+        if (cqe.res != static_cast<int>(page_size_)) {
+          ++it->second.nr_failed_;
+        }
+        if (it->second.nr_pending_ == 0 && it->second.nr_failed_ == 0) {
+          writes_.erase(it);
+        }
+        slot.state_ = SlotState::FREE;
+        break;
+      }
+      default:
+        slot.state_ = SlotState::FREE;
+        break;
+    }
+    --nr_in_flight_;
+    ++head;
+  }
+  __atomic_store_n(ring_->cq_head_, head, __ATOMIC_RELEASE);
+}
+
+#else
+
+void cas::IoEngine::Prepare(size_t /* slot */, uint8_t /* opcode */) {}
+void cas::IoEngine::Enter(size_t /* min_complete */) {}
+void cas::IoEngine::Reap() {}
+
+#endif
@@ -34,6 +34,7 @@ cas::BinarySK cas::KeyEncoder<VType>::Encode(
   } else {
     EncodeQueryPath(key.path_, bkey.path_.data());
   }
+  bkey.automaton_ = cas::PathAutomaton::Compile(bkey.path_);
   return bkey;
 }
 
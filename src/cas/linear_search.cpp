@@ -20,8 +20,8 @@ cas::LinearSearch<VType>::LinearSearch(
 template<class VType>
 void cas::LinearSearch<VType>::Execute() {
   const auto& t_start = std::chrono::high_resolution_clock::now();
-  std::array<std::byte, cas::PAGE_SZ> io_page_buffer;
-  cas::MemoryPage io_page{&io_page_buffer[0]};
+  std::vector<std::byte> io_page_buffer(partition_.PageSize());
+  cas::MemoryPage io_page{&io_page_buffer[0], partition_.PageSize()};
   auto cursor = partition_.Cursor(io_page);
   while (cursor.HasNext()) {
     auto& page = cursor.NextPage();
@@ -47,7 +47,7 @@ void cas::LinearSearch<VType>::Execute() {
 template<class VType>
 bool cas::LinearSearch<VType>::MatchPath(uint16_t len_pat) {
   return cas::path_matcher::MatchPath(
-      *buf_pat_, key_.path_, len_pat);
+      *buf_pat_, key_, len_pat);
 }
 
 
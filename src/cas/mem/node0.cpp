@@ -29,6 +29,12 @@ void cas::mem::Node0::ForEachChild(const cas::INode::ChildCallback& /* callback
 }
 
 
+void cas::mem::Node0::ForEachChildInRange(uint8_t /* low */, uint8_t /* high */,
+    const cas::INode::ChildCallback& /* callback */) const {
+  // NO-OP
+}
+
+
 void cas::mem::Node0::ForEachSuffix(const RefCallback& callback) const {
   for (const auto& ref : refs_) {
     callback(ref);
@@ -2,6 +2,42 @@
 #include "cas/mem/node48.hpp"
 #include <cassert>
 #include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+#ifdef __SSE2__
+// bitmask of the first n keys
+inline int ValidKeys(int n) {
+  return (1 << n) - 1;
+}
+#endif
+
+// number of keys among the first n (sorted) keys that are less than byte,
+// i.e., the position of the first key that is not less than byte
+inline int LowerBound(const uint8_t* keys, int n, uint8_t byte) {
+#ifdef __SSE2__
+  // SSE2 only has signed comparisons, flipping the sign bit of both
+  // operands yields the unsigned order
+  const __m128i flip = _mm_set1_epi8(static_cast<char>(0x80));
+  __m128i k = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)), flip);
+  __m128i b = _mm_xor_si128(_mm_set1_epi8(static_cast<char>(byte)), flip);
+  int mask = _mm_movemask_epi8(_mm_cmplt_epi8(k, b)) & ValidKeys(n);
+  return __builtin_popcount(mask);
+#else
+  int pos = 0;
+  while (pos < n && keys[pos] < byte) {
+    ++pos;
+  }
+  return pos;
+#endif
+}
+
+} // namespace
+
 
 
 cas::mem::Node16::Node16(cas::Dimension dimension)
@@ -19,13 +55,34 @@ void cas::mem::Node16::ForEachChild(const cas::INode::ChildCallback& callback) c
 }
 
 
+int cas::mem::Node16::LowerBound(uint8_t key_byte) const {
+  return ::LowerBound(keys_, nr_children_, key_byte);
+}
+
+
+void cas::mem::Node16::ForEachChildInRange(uint8_t low, uint8_t high,
+    const cas::INode::ChildCallback& callback) const {
+  int end = high == 0xFF ? nr_children_ : LowerBound(high + 1);
+  for (int i = LowerBound(low); i < end; ++i) {
+    callback(keys_[i], children_[i]);
+  }
+}
+
+
 cas::mem::Node* cas::mem::Node16::LocateChild(uint8_t key_byte) const {
+#ifdef __SSE2__
+  __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys_));
+  __m128i b = _mm_set1_epi8(static_cast<char>(key_byte));
+  int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(k, b)) & ValidKeys(nr_children_);
+  return mask != 0 ? children_[__builtin_ctz(mask)] : nullptr;
+#else
   for (int i = 0; i < nr_children_; ++i) {
     if (key_byte == keys_[i]) {
       return children_[i];
     }
   }
   return nullptr;
+#endif
 }
 
 
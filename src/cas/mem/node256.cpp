@@ -18,6 +18,16 @@ void cas::mem::Node256::ForEachChild(const cas::INode::ChildCallback& callback)
 }
 
 
+void cas::mem::Node256::ForEachChildInRange(uint8_t low, uint8_t high,
+    const cas::INode::ChildCallback& callback) const {
+  for (int i = low; i <= high; ++i) {
+    if (children_[i] != nullptr) {
+      callback(static_cast<uint8_t>(i), children_[i]);
+    }
+  }
+}
+
+
 cas::mem::Node* cas::mem::Node256::LocateChild(uint8_t key_byte) const {
 	return children_[key_byte];
 }
@@ -19,6 +19,17 @@ void cas::mem::Node4::ForEachChild(const cas::INode::ChildCallback& callback) co
 }
 
 
+void cas::mem::Node4::ForEachChildInRange(uint8_t low, uint8_t high,
+    const cas::INode::ChildCallback& callback) const {
+  // keys_ are sorted
+  for (int i = 0; i < nr_children_ && keys_[i] <= high; ++i) {
+    if (keys_[i] >= low) {
+      callback(keys_[i], children_[i]);
+    }
+  }
+}
+
+
 cas::mem::Node* cas::mem::Node4::LocateChild(uint8_t key_byte) const {
   for (int i = 0; i < nr_children_; ++i) {
     if (key_byte == keys_[i]) {
@@ -20,6 +20,16 @@ void cas::mem::Node48::ForEachChild(const cas::INode::ChildCallback& callback) c
 }
 
 
+void cas::mem::Node48::ForEachChildInRange(uint8_t low, uint8_t high,
+    const cas::INode::ChildCallback& callback) const {
+  for (int i = low; i <= high; ++i) {
+    if (indexes_[i] != cas::mem::kEmptyIndex) {
+      callback(static_cast<uint8_t>(i), children_[indexes_[i]]);
+    }
+  }
+}
+
+
 cas::mem::Node* cas::mem::Node48::LocateChild(uint8_t key_byte) const {
   uint8_t index = indexes_[key_byte];
   if (index == cas::mem::kEmptyIndex) {
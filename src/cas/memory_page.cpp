@@ -1,21 +1,182 @@
 #include "cas/memory_page.hpp"
+#include "cas/common_prefix.hpp"
+#include "cas/util.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
 
+namespace {
+
+
+size_t SharedPrefix(const std::byte* data, size_t len,
+    const std::vector<std::byte>& last) {
+  return cas::CommonPrefix(data, last.data(), std::min(len, last.size()));
+}
+
+
+} // namespace
+
+
+size_t cas::MemoryPage::EncodedSize(const cas::BinaryKey& key) const {
+  if (Format() == PageFormat::Plain) {
+    return key.ByteSize();
+  }
+  size_t shared_p = SharedPrefix(key.Path(), key.LenPath(), last_path_);
+  size_t shared_v = SharedPrefix(key.Value(), key.LenValue(), last_value_);
+  size_t suffix_p = key.LenPath() - shared_p;
+  size_t suffix_v = key.LenValue() - shared_v;
+  return cas::util::VarintSize(shared_p) + cas::util::VarintSize(suffix_p)
+    + cas::util::VarintSize(shared_v) + cas::util::VarintSize(suffix_v)
+    + sizeof(ref_t) + suffix_p + suffix_v;
+}
+
+
 void cas::MemoryPage::Push(const cas::BinaryKey& key) {
-  size_t key_size = key.ByteSize();
+  size_t key_size = EncodedSize(key);
   if (tail_pos_ + key_size > Size()) {
     throw std::runtime_error{"key does not fit"};
   }
-  std::memcpy(data_ + tail_pos_, key.Begin(), key_size);
-  ++NrKeys();
+  if (Format() == PageFormat::Plain) {
+    std::memcpy(data_ + tail_pos_, key.Begin(), key_size);
+  } else {
+    size_t shared_p = SharedPrefix(key.Path(), key.LenPath(), last_path_);
+    size_t shared_v = SharedPrefix(key.Value(), key.LenValue(), last_value_);
+    size_t suffix_p = key.LenPath() - shared_p;
+    size_t suffix_v = key.LenValue() - shared_v;
+    std::byte* dst = data_ + tail_pos_;
+    dst = cas::util::WriteVarint(dst, shared_p);
+    dst = cas::util::WriteVarint(dst, suffix_p);
+    dst = cas::util::WriteVarint(dst, shared_v);
+    dst = cas::util::WriteVarint(dst, suffix_v);
+    std::memcpy(dst, &key.Ref(), sizeof(ref_t));
+    dst += sizeof(ref_t);
+    std::memcpy(dst, key.Path() + shared_p, suffix_p);
+    dst += suffix_p;
+    std::memcpy(dst, key.Value() + shared_v, suffix_v);
+    last_path_.resize(shared_p);
+    last_path_.insert(last_path_.end(), key.Path() + shared_p,
+        key.Path() + key.LenPath());
+    last_value_.resize(shared_v);
+    last_value_.insert(last_value_.end(), key.Value() + shared_v,
+        key.Value() + key.LenValue());
+  }
+  ++Header();
   tail_pos_ += key_size;
 }
 
 
+// Decode buffers are recycled by the thread that releases them, so
+// iterating front-coded pages does not allocate in the steady state.
+// A thread only needs more than one buffer while several iterators
+// are alive at the same time.
+struct cas::MemoryPage::iterator::Buffer {
+  size_t nr_references_ = 0;
+  std::vector<std::byte> data_;
+};
+
+
+std::vector<std::unique_ptr<cas::MemoryPage::iterator::Buffer>>&
+cas::MemoryPage::iterator::FreeBuffers() {
+  thread_local std::vector<std::unique_ptr<Buffer>> free_buffers;
+  return free_buffers;
+}
+
+
+cas::MemoryPage::iterator::Buffer* cas::MemoryPage::iterator::Acquire(
+    size_t size) {
+  auto& free_buffers = FreeBuffers();
+  std::unique_ptr<Buffer> buffer;
+  if (free_buffers.empty()) {
+    buffer = std::make_unique<Buffer>();
+  } else {
+    buffer = std::move(free_buffers.back());
+    free_buffers.pop_back();
+  }
+  // grows to the largest page size that is iterated by this thread
+  if (buffer->data_.size() < size) {
+    buffer->data_.resize(size);
+  }
+  buffer->nr_references_ = 1;
+  return buffer.release();
+}
+
+
+void cas::MemoryPage::iterator::Release(Buffer* buffer) {
+  if (buffer != nullptr && --buffer->nr_references_ == 0) {
+    FreeBuffers().emplace_back(buffer);
+  }
+}
+
+
+std::byte* cas::MemoryPage::iterator::BufferData(Buffer* buffer) {
+  return buffer->data_.data();
+}
+
+
+cas::MemoryPage::iterator::iterator(const iterator& other)
+  : key_(other.key_)
+  , data_(other.data_)
+  , key_nr_(other.key_nr_)
+  , nr_keys_(other.nr_keys_)
+  , buffer_(other.buffer_)
+{
+  if (buffer_ != nullptr) {
+    ++buffer_->nr_references_;
+  }
+}
+
+
+cas::MemoryPage::iterator& cas::MemoryPage::iterator::operator=(
+    const iterator& other) {
+  if (other.buffer_ != nullptr) {
+    ++other.buffer_->nr_references_;
+  }
+  Release(buffer_);
+  key_ = other.key_;
+  data_ = other.data_;
+  key_nr_ = other.key_nr_;
+  nr_keys_ = other.nr_keys_;
+  buffer_ = other.buffer_;
+  return *this;
+}
+
+
+cas::MemoryPage::iterator::~iterator() {
+  Release(buffer_);
+}
+
+
+void cas::MemoryPage::iterator::Decode() {
+  size_t shared_p;
+  size_t suffix_p;
+  size_t shared_v;
+  size_t suffix_v;
+  const std::byte* src = data_;
+  src = cas::util::ReadVarint(src, shared_p);
+  src = cas::util::ReadVarint(src, suffix_p);
+  src = cas::util::ReadVarint(src, shared_v);
+  src = cas::util::ReadVarint(src, suffix_v);
+  ref_t ref;
+  std::memcpy(&ref, src, sizeof(ref_t));
+  src += sizeof(ref_t);
+  key_.Ref(ref);
+  // the value follows the path, move its shared prefix first
+  size_t len_p = shared_p + suffix_p;
+  std::memmove(key_.Path() + len_p, key_.Value(), shared_v);
+  std::memcpy(key_.Path() + shared_p, src, suffix_p);
+  src += suffix_p;
+  key_.LenPath(static_cast<uint16_t>(len_p));
+  std::memcpy(key_.Value() + shared_v, src, suffix_v);
+  src += suffix_v;
+  key_.LenValue(static_cast<uint16_t>(shared_v + suffix_v));
+  data_ = const_cast<std::byte*>(src);
+}
+
+
 void cas::MemoryPage::Dump() {
   std::cout << "nr_keys_: " << NrKeys() << "\n";
+  std::cout << "format_: " << ToString(Format()) << "\n";
   for (auto& key : *this) {
     key.Dump();
   }
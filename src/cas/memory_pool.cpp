@@ -1,25 +1,75 @@
 #include "cas/memory_pool.hpp"
 #include "cas/types.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <fcntl.h>
 #include <unistd.h>
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+namespace {
+
+// size of explicit huge pages (Hugepagesize in /proc/meminfo)
+size_t HugePageSize() {
+  std::ifstream meminfo{"/proc/meminfo"};
+  std::string line;
+  while (std::getline(meminfo, line)) {
+    size_t size_kb;
+    if (std::sscanf(line.c_str(), "Hugepagesize: %zu kB", &size_kb) == 1) {
+      return size_kb * 1024;
+    }
+  }
+  return 2 * 1024 * 1024;
+}
+
+// bit mask of the online NUMA nodes, e.g., "0-1,3" (at most 64 nodes)
+unsigned long OnlineNumaNodes() {
+  std::ifstream online{"/sys/devices/system/node/online"};
+  unsigned long mask = 0;
+  std::string range;
+  while (std::getline(online, range, ',')) {
+    size_t first;
+    size_t last;
+    int nr_parsed = std::sscanf(range.c_str(), "%zu-%zu", &first, &last);
+    if (nr_parsed < 1) {
+      continue;
+    }
+    if (nr_parsed == 1) {
+      last = first;
+    }
+    for (size_t node = first; node <= last && node < 64; ++node) {
+      mask |= 1ul << node;
+    }
+  }
+  return mask;
+}
+
+} // namespace
 
 
 cas::MemoryPools cas::MemoryPools::Construct(
     size_t max_memory,
-    size_t memory_capacity)
+    size_t memory_capacity,
+    size_t read_ahead_depth,
+    size_t page_size,
+    const MemoryBacking& backing)
 {
+  cas::CheckPageSize(page_size);
   if (0 < memory_capacity && memory_capacity < max_memory) {
     throw std::bad_alloc();
   }
-  size_t available_pages = max_memory / cas::PAGE_SZ;
-  if (available_pages < 1 + cas::BYTE_MAX) {
+  size_t available_pages = max_memory / page_size;
+  if (available_pages < 1 + read_ahead_depth + cas::BYTE_MAX) {
     throw std::bad_alloc();
   }
   // determine input pool size
-  size_t input_sz = 1;
-  available_pages -= 1;
+  size_t input_sz = 1 + read_ahead_depth;
+  available_pages -= input_sz;
   // determine output pool size
   size_t output_sz = cas::BYTE_MAX;
   available_pages -= cas::BYTE_MAX;
@@ -27,42 +77,155 @@ cas::MemoryPools cas::MemoryPools::Construct(
   size_t work_sz = available_pages;
   // see how many pages are left that can be occupied
   size_t cache_killer_sz = 0;
-  size_t total_pages = memory_capacity / cas::PAGE_SZ;
+  size_t total_pages = memory_capacity / page_size;
   if (total_pages > (input_sz + output_sz + work_sz)) {
     cache_killer_sz = total_pages - (input_sz + output_sz + work_sz);
   }
-  return MemoryPools(input_sz, output_sz, work_sz, cache_killer_sz);
+  // the small input and output pools are accessed by a single thread
+  MemoryBacking work_backing = backing;
+  MemoryBacking other_backing = backing;
+  other_backing.numa_interleave_ = false;
+  return MemoryPools(input_sz, output_sz, work_sz, cache_killer_sz, page_size,
+      other_backing, work_backing);
 }
 
 
-cas::MemoryPool::MemoryPool(size_t max_pages, MemoryPageType type)
+cas::MemoryPool::MemoryPool(size_t max_pages, MemoryPageType type,
+    size_t page_size, const MemoryBacking& backing)
   : max_pages_(max_pages)
   , type_(type)
+  , page_size_(page_size)
 {
-  if (max_pages * cas::PAGE_SZ <= 0) {
+  if (max_pages * page_size_ <= 0) {
     address_ = nullptr;
     return;
   }
-  address_ = static_cast<std::byte*>(mmap(NULL, max_pages * cas::PAGE_SZ,
-      PROT_READ | PROT_WRITE,
-      MAP_PRIVATE | MAP_ANONYMOUS,
-      -1, 0));
+  Map(backing);
+  pages_.reserve(max_pages_);
+  for (size_t i = 0; i < max_pages_; ++i) {
+    pages_.emplace_back(address_ + i * page_size_, page_size_);
+    pages_.back().Type(type);
+  }
+}
+
+void cas::MemoryPool::Map(const MemoryBacking& backing) {
+  backing_ = backing;
+  size_t size = max_pages_ * page_size_;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  address_ = static_cast<std::byte*>(MAP_FAILED);
+  if (backing_.huge_pages_ == HugePages::Explicit) {
+    // fails if not enough huge pages are reserved (vm.nr_hugepages)
+    size_t huge_page_size = HugePageSize();
+    mapped_size_ = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    address_ = static_cast<std::byte*>(mmap(NULL, mapped_size_,
+        PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0));
+    if (address_ == MAP_FAILED) {
+      std::cerr << "could not mmap explicit huge pages, "
+        << "using transparent huge pages" << std::endl;
+      backing_.huge_pages_ = HugePages::Transparent;
+    }
+  }
+  if (address_ == MAP_FAILED) {
+    mapped_size_ = size;
+    address_ = static_cast<std::byte*>(mmap(NULL, mapped_size_,
+        PROT_READ | PROT_WRITE, flags, -1, 0));
+  }
   if (address_ == MAP_FAILED) {
     std::cerr << "could not mmap memory" << std::endl;
     std::terminate();
   }
-  pages_.reserve(max_pages_);
-  for (size_t i = 0; i < max_pages_; ++i) {
-    pages_.emplace_back(address_ + i * cas::PAGE_SZ);
-    pages_.back().Type(type);
+  if (backing_.huge_pages_ == HugePages::Transparent
+      && madvise(address_, mapped_size_, MADV_HUGEPAGE) != 0) {
+    backing_.huge_pages_ = HugePages::None;
+  }
+  // the memory policy only applies to pages that are not faulted in yet
+  if (backing_.numa_interleave_) {
+    InterleaveNumaNodes();
+  }
+  if (backing_.prefault_) {
+    Prefault(backing_.nr_threads_);
+  }
+}
+
+
+void cas::MemoryPool::InterleaveNumaNodes() {
+  unsigned long nodes = OnlineNumaNodes();
+  if ((nodes & (nodes - 1)) == 0) {
+    // there is at most one node
+    backing_.numa_interleave_ = false;
+    return;
+  }
+  unsigned long max_node = 8 * sizeof(nodes) + 1;
+  if (syscall(SYS_mbind, address_, mapped_size_, MPOL_INTERLEAVE,
+        &nodes, max_node, 0) != 0) {
+    std::cerr << "could not interleave memory across NUMA nodes" << std::endl;
+    backing_.numa_interleave_ = false;
+  }
+}
+
+
+void cas::MemoryPool::Prefault(size_t nr_threads) {
+  // writing a byte of every base page of the OS faults it in
+  const size_t os_page_size = sysconf(_SC_PAGESIZE);
+  const size_t nr_os_pages = mapped_size_ / os_page_size;
+  nr_threads = std::clamp<size_t>(nr_threads, 1, nr_os_pages);
+  const size_t share = (nr_os_pages + nr_threads - 1) / nr_threads;
+  auto touch = [this, os_page_size, nr_os_pages, share](size_t t) {
+    size_t end = std::min((t + 1) * share, nr_os_pages);
+    for (size_t i = t * share; i < end; ++i) {
+      address_[i * os_page_size] = std::byte{0};
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < nr_threads; ++t) {
+    threads.emplace_back(touch, t);
+  }
+  touch(0);
+  for (auto& thread : threads) {
+    thread.join();
   }
 }
 
+
+cas::MemoryPools cas::MemoryPools::Slice(
+    cas::MemoryPools& pools,
+    size_t read_ahead_depth) {
+  if (pools.work_.NrFreePages() < SliceSize(read_ahead_depth)) {
+    throw std::bad_alloc();
+  }
+  return MemoryPools(pools.work_, 1 + read_ahead_depth);
+}
+
+
+cas::MemoryPool::MemoryPool(
+    MemoryPool& source,
+    size_t nr_pages,
+    size_t max_pages,
+    MemoryPageType type)
+  : max_pages_(max_pages)
+  , type_(type)
+  , page_size_(source.PageSize())
+  , address_(nullptr)
+  , source_(&source)
+{
+  pages_.reserve(max_pages_);
+  Borrow(nr_pages);
+}
+
+
 cas::MemoryPool::~MemoryPool() {
+  if (source_ != nullptr) {
+    // borrowed pages might have changed hands in the meantime,
+    // the source pool only cares about getting their number back
+    for (auto& page : pages_) {
+      source_->Release(std::move(page));
+    }
+    return;
+  }
   if (address_ == nullptr) {
     return;
   }
-  int rt = munmap(address_, max_pages_ * cas::PAGE_SZ);
+  int rt = munmap(address_, mapped_size_);
   if (rt < 0) {
     std::cerr << "could not munmap allocated memory" << std::endl;
     std::terminate();
@@ -70,12 +233,12 @@ cas::MemoryPool::~MemoryPool() {
 }
 
 
-cas::MemoryPage cas::MemoryPool::Get() {
+cas::MemoryPage cas::MemoryPool::Get(PageFormat format) {
   if (pages_.empty()) {
     throw std::bad_alloc();
   }
   auto page = std::move(pages_.back());
-  page.Reset();
+  page.Reset(format);
   page.Type(type_);
   pages_.pop_back();
   return page;
@@ -90,6 +253,18 @@ void cas::MemoryPool::Release(MemoryPage&& page) {
 }
 
 
+void cas::MemoryPool::Borrow(size_t nr_pages) {
+  if (source_ == nullptr) {
+    throw std::runtime_error{"pool does not borrow its pages"};
+  }
+  for (size_t i = 0; i < nr_pages; ++i) {
+    auto page = source_->Get();
+    page.Type(type_);
+    Release(std::move(page));
+  }
+}
+
+
 void cas::MemoryPools::Dump() {
   std::cout << "MemoryPool (";
   std::cout << "input: " <<
@@ -99,12 +274,17 @@ void cas::MemoryPools::Dump() {
   std::cout << "work: " <<
     work_.NrUsedPages() << "/" << work_.Capacity() << "; ";
   std::cout << "cache_killer: " <<
-    cache_killer_.NrUsedPages() << "/" << cache_killer_.Capacity() << ")\n";
+    cache_killer_.NrUsedPages() << "/" << cache_killer_.Capacity() << "; ";
+  std::cout << "page_size: " << input_.PageSize() << "; ";
+  const auto& backing = work_.Backing();
+  std::cout << "huge_pages: " << ToString(backing.huge_pages_) << "; ";
+  std::cout << "prefault: " << backing.prefault_ << "; ";
+  std::cout << "numa_interleave: " << backing.numa_interleave_ << ")\n";
 }
 
 
 void cas::MemoryPool::FillWithZeros() {
   for (auto& page : pages_) {
-    std::memset(page.Data(), 0, cas::PAGE_SZ);
+    std::memset(page.Data(), 0, page.Size());
   }
 }
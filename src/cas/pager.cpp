@@ -6,8 +6,9 @@
 #include <vector>
 
 
-cas::Pager::Pager(const std::string& filename)
-  : filename_(filename) {
+cas::Pager::Pager(const std::string& filename, size_t page_size)
+  : filename_(filename)
+  , page_size_(page_size) {
   OpenFile();
 }
 
@@ -50,8 +51,8 @@ void cas::Pager::Clear() {
 std::shared_ptr<cas::IdxPage>
 cas::Pager::Fetch(cas::page_nr_t page_nr) {
   auto page = NewIdxPage();
-  file_.seekg(page_nr * cas::PAGE_SZ);
-  file_.read(reinterpret_cast<char*>(&page->front()), cas::PAGE_SZ); // NOLINT
+  file_.seekg(page_nr * page_size_);
+  file_.read(reinterpret_cast<char*>(&page->front()), page_size_); // NOLINT
   if (!file_.good()) {
     throw std::runtime_error{"failed reading page " + std::to_string(page_nr)};
   }
@@ -60,8 +61,8 @@ cas::Pager::Fetch(cas::page_nr_t page_nr) {
 
 
 void cas::Pager::Write(const IdxPage& page, cas::page_nr_t page_nr) {
-  file_.seekp(page_nr * cas::PAGE_SZ);
-  file_.write(reinterpret_cast<const char*>(&page.front()), cas::PAGE_SZ); // NOLINT
+  file_.seekp(page_nr * page_size_);
+  file_.write(reinterpret_cast<const char*>(&page.front()), page.size()); // NOLINT
   if (!file_.good()) {
     throw std::runtime_error{"failed writing page " + std::to_string(page_nr)};
   }
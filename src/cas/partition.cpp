@@ -1,21 +1,76 @@
 #include "cas/partition.hpp"
+#include "cas/compression.hpp"
+#include "cas/partition_header.hpp"
 #include "cas/util.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <iterator>
 #include <filesystem>
+#include <mutex>
+#include <thread>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 
+namespace {
+
+// O_DIRECT requires aligned buffers, offsets, and sizes
+const size_t kFrameAlignment = 4096;
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// buffer for (de)compressing frames, shared by the partitions of a thread
+std::byte* FrameBuffer(size_t size) {
+  struct Free {
+    void operator()(std::byte* ptr) { std::free(ptr); }
+  };
+  thread_local std::unique_ptr<std::byte, Free> buffer;
+  thread_local size_t capacity = 0;
+  size = AlignUp(size, kFrameAlignment);
+  if (capacity < size) {
+    buffer.reset(static_cast<std::byte*>(std::aligned_alloc(kFrameAlignment, size)));
+    if (buffer == nullptr) {
+      throw std::bad_alloc();
+    }
+    capacity = size;
+  }
+  return buffer.get();
+}
+
+} // namespace
+
+
 cas::Partition::Partition(const std::string& filename,
     BulkLoaderStats& stats, const cas::Context& context)
   : filename_(filename)
-  , stats_(stats)
+  , page_size_(context.page_size_)
+  , compression_(context.partition_compression_)
+  , stats_(&stats)
   , context_(context)
-{}
+{
+  if (!cas::IsSupported(compression_)) {
+    throw std::runtime_error{"compression " + cas::ToString(compression_)
+      + " is not supported by this build"};
+  }
+}
 
 
 
+void cas::Partition::Io(IoEngine* io) {
+  if (fptr_ != -1 && BuffersWrites() && !io_->Close(fptr_)) {
+    throw std::runtime_error{"failed to write to file '" + filename_ + "'"};
+  }
+  io_ = io;
+}
+
+
 bool cas::Partition::HasMemoryPage() {
   return !mptr_.empty();
 }
@@ -25,6 +80,8 @@ cas::MemoryPage cas::Partition::PopFromMemory() {
   --nr_memory_pages_;
   auto page = std::move(mptr_.front());
   mptr_.pop_front();
+  // evicted pages are counted again by PushToDisk
+  nr_keys_ -= page.NrKeys();
   return page;
 }
 
@@ -55,9 +112,69 @@ void cas::Partition::PushToDisk(
 }
 
 
+void cas::Partition::AppendToDisk(
+    const MemoryPage& page,
+    std::mutex& mutex,
+    BulkLoaderStats& stats) {
+  auto start = std::chrono::high_resolution_clock::now();
+  const std::byte* data = page.Data();
+  size_t raw_size = page.UsedSpace();
+  size_t size = raw_size;
+  size_t nr_bytes = page_size_;
+  if (compression_ != cas::Compression::None) {
+    // the size of the frame is only known after compressing it
+    size_t capacity = std::max(raw_size,
+        cas::CompressBound(compression_, raw_size));
+    std::byte* buffer = FrameBuffer(capacity);
+    auto start_compression = std::chrono::high_resolution_clock::now();
+    size = cas::Compress(compression_,
+        page.Data(), raw_size, buffer, capacity);
+    cas::util::AddToTimer(stats.runtime_partition_compression_, start_compression);
+    if (size >= raw_size) {
+      std::memcpy(buffer, page.Data(), raw_size);
+      size = raw_size;
+    }
+    nr_bytes = context_.use_direct_io_
+      ? AlignUp(size, kFrameAlignment)
+      : size;
+    std::memset(buffer + size, 0, nr_bytes - size);
+    data = buffer;
+  }
+
+  size_t offset;
+  {
+    std::lock_guard<std::mutex> guard{mutex};
+    if (fptr_ == -1) {
+      OpenFile();
+    }
+    nr_keys_ += page.NrKeys();
+    ++nr_disk_pages_;
+    ++nr_pages_;
+    if (compression_ != cas::Compression::None) {
+      offset = fptr_write_offset_;
+      frames_.push_back(Frame{offset,
+          static_cast<uint32_t>(size), static_cast<uint32_t>(raw_size)});
+      fptr_write_offset_ += nr_bytes;
+    } else {
+      offset = (header_pages_ + fptr_write_page_nr_) * page_size_;
+    }
+    ++fptr_write_page_nr_;
+  }
+
+  ssize_t bytes_written = pwrite(fptr_, data, nr_bytes, offset);
+  if (bytes_written != static_cast<ssize_t>(nr_bytes)) {
+    throw std::runtime_error{"failed to write to file '" + filename_ + "'"};
+  }
+  stats.partition_bytes_written_ += nr_bytes;
+  ++stats.mem_pages_written_;
+  ++stats.partition_write_requests_;
+  cas::util::AddToTimer(stats.runtime_partition_disk_write_, start);
+}
+
+
 void cas::Partition::OpenFile() {
   if (!std::filesystem::exists(filename_)) {
-    ++stats_.files_created_;
+    ++stats_->files_created_;
   }
   int flags = O_CREAT | O_RDWR;
   if (context_.use_direct_io_) {
@@ -68,6 +185,65 @@ void cas::Partition::OpenFile() {
     std::string error_msg = "failed to open file '" + filename_ + "'";
     throw std::runtime_error{error_msg};
   }
+  if (is_root_partition_) {
+    struct stat st;
+    if (fstat(fptr_, &st) == 0 && st.st_size == 0) {
+      WriteHeader();
+    } else {
+      ReadHeader();
+    }
+  }
+}
+
+
+void cas::Partition::ReadHeader() {
+  // O_DIRECT does not allow to read only the header
+  std::byte* buffer = FrameBuffer(kFrameAlignment);
+  ssize_t bytes_read = pread(fptr_, buffer, kFrameAlignment, 0);
+  auto header = cas::PartitionHeader::Read(buffer,
+      bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0);
+  if (header.page_size_ != page_size_) {
+    throw std::runtime_error{"file '" + filename_ + "' has pages of "
+      + std::to_string(header.page_size_) + " bytes instead of "
+      + std::to_string(page_size_)};
+  }
+  header_pages_ = header.present_ ? 1 : 0;
+}
+
+
+void cas::Partition::WriteHeader() {
+  cas::PartitionHeader header;
+  header.page_size_ = page_size_;
+  header.present_ = true;
+  std::byte* buffer = FrameBuffer(page_size_);
+  header.Write(buffer);
+  if (pwrite(fptr_, buffer, page_size_, 0) != static_cast<ssize_t>(page_size_)) {
+    throw std::runtime_error{"failed to write to file '" + filename_ + "'"};
+  }
+  header_pages_ = 1;
+  fptr_write_offset_ = page_size_;
+}
+
+
+void cas::Partition::Open() {
+  if (std::filesystem::exists(filename_) && fptr_ == -1) {
+    OpenFile();
+  } else if (fptr_ != -1 && BuffersWrites() && io_->HasPendingWrites(fptr_)) {
+    // the read-ahead must not overtake outstanding writes
+    auto start = std::chrono::high_resolution_clock::now();
+    bool success = io_->Flush(fptr_);
+    cas::util::AddToTimer(stats_->runtime_partition_disk_write_, start);
+    if (!success) {
+      throw std::runtime_error{"failed to write to file '" + filename_ + "'"};
+    }
+  }
+}
+
+
+void cas::Partition::Preallocate(size_t nr_pages) {
+  if (fptr_ != -1 && BuffersWrites() && compression_ == cas::Compression::None) {
+    io_->Preallocate(fptr_, header_pages_ + nr_pages);
+  }
 }
 
 
@@ -75,10 +251,23 @@ void cas::Partition::CloseFile() {
   if (fptr_ == -1) {
     return;
   }
+  // waiting for outstanding asynchronous or buffered writes, the timer
+  // only records closes that actually wait
+  if (BuffersWrites()) {
+    bool has_pending_writes = io_->HasPendingWrites(fptr_);
+    auto start = std::chrono::high_resolution_clock::now();
+    bool success = io_->Close(fptr_);
+    if (has_pending_writes) {
+      cas::util::AddToTimer(stats_->runtime_partition_disk_write_, start);
+    }
+    if (!success) {
+      throw std::runtime_error{"failed to write to file '" + filename_ + "'"};
+    }
+  }
   /* // flushing data to disk */
   /* auto start = std::chrono::high_resolution_clock::now(); */
   /* fsync(fptr_); */
-  /* cas::util::AddToTimer(stats_.runtime_partition_disk_write_, start); */
+  /* cas::util::AddToTimer(stats_->runtime_partition_disk_write_, start); */
   // closing file
   if (close(fptr_) == -1) {
     throw std::runtime_error{"error while closing file '" + filename_ + "'"};
@@ -91,49 +280,240 @@ void cas::Partition::CloseFile() {
 void cas::Partition::DeleteFile() {
   CloseFile();
   std::filesystem::remove(filename_);
+  frames_.clear();
+  fptr_write_offset_ = 0;
+  header_pages_ = 0;
 }
 
 
 int cas::Partition::FWritePage(
     const MemoryPage& page,
     size_t page_nr) {
+  if (compression_ != cas::Compression::None) {
+    return FWriteFrame(page, page_nr);
+  }
   auto start = std::chrono::high_resolution_clock::now();
   int err;
 
-  int bytes_written = pwrite(fptr_, page.Data(), cas::PAGE_SZ, page_nr * cas::PAGE_SZ);
-  if (bytes_written == cas::PAGE_SZ) {
-    stats_.partition_bytes_written_ += cas::PAGE_SZ;
-    ++stats_.mem_pages_written_;
+  int bytes_written;
+  page_nr += header_pages_;
+  if (BuffersWrites()) {
+    bytes_written = io_->WritePage(fptr_, page, page_nr);
+  } else {
+    bytes_written = pwrite(fptr_, page.Data(), page_size_, page_nr * page_size_);
+    ++stats_->partition_write_requests_;
+  }
+  if (bytes_written == static_cast<int>(page_size_)) {
+    stats_->partition_bytes_written_ += page_size_;
+    ++stats_->mem_pages_written_;
     err = 0;
   } else {
     err = -1;
   }
 
-  cas::util::AddToTimer(stats_.runtime_partition_disk_write_, start);
+  cas::util::AddToTimer(stats_->runtime_partition_disk_write_, start);
   return err;
 }
 
 
 int cas::Partition::FReadPage(
     MemoryPage& page,
-    size_t page_nr) {
+    size_t page_nr,
+    size_t last_page_nr,
+    IoEngine* io,
+    BulkLoaderStats& stats) {
+  if (IsCompressed()) {
+    return FReadFrame(page, page_nr, stats);
+  }
   auto start = std::chrono::high_resolution_clock::now();
   int err;
 
-  int bytes_read = pread(fptr_, page.Data(), cas::PAGE_SZ, page_nr * cas::PAGE_SZ);
-  if (bytes_read == cas::PAGE_SZ) {
-    stats_.partition_bytes_read_ += cas::PAGE_SZ;
-    ++stats_.mem_pages_read_;
+  page_nr += header_pages_;
+  if (last_page_nr < std::numeric_limits<size_t>::max()) {
+    last_page_nr += header_pages_;
+  }
+  int bytes_read = io != nullptr && io->IsAsync()
+    ? io->ReadPage(fptr_, page, page_nr, last_page_nr)
+    : pread(fptr_, page.Data(), page_size_, page_nr * page_size_);
+  if (bytes_read == static_cast<int>(page_size_)) {
+    stats.partition_bytes_read_ += page_size_;
+    ++stats.mem_pages_read_;
+    err = 0;
+  } else {
+    err = -1;
+  }
+
+  cas::util::AddToTimer(stats.runtime_partition_disk_read_, start);
+  return err;
+}
+
+
+// Compressed pages are appended synchronously, i.e., without io_,
+// because the size of their frames is only known after compressing
+// them. Pages that do not compress are stored as they are.
+int cas::Partition::FWriteFrame(
+    const MemoryPage& page,
+    size_t page_nr) {
+  auto start = std::chrono::high_resolution_clock::now();
+  if (page_nr != frames_.size()) {
+    throw std::runtime_error{"pages of compressed partitions must be appended"};
+  }
+  size_t raw_size = page.UsedSpace();
+  size_t capacity = std::max(raw_size,
+      cas::CompressBound(compression_, raw_size));
+  std::byte* buffer = FrameBuffer(capacity);
+  auto start_compression = std::chrono::high_resolution_clock::now();
+  size_t size = cas::Compress(compression_,
+      page.Data(), raw_size, buffer, capacity);
+  cas::util::AddToTimer(stats_->runtime_partition_compression_, start_compression);
+  if (size >= raw_size) {
+    std::memcpy(buffer, page.Data(), raw_size);
+    size = raw_size;
+  }
+  size_t nr_bytes = context_.use_direct_io_
+    ? AlignUp(size, kFrameAlignment)
+    : size;
+  std::memset(buffer + size, 0, nr_bytes - size);
+
+  int err;
+  ssize_t bytes_written = pwrite(fptr_, buffer, nr_bytes, fptr_write_offset_);
+  ++stats_->partition_write_requests_;
+  if (bytes_written == static_cast<ssize_t>(nr_bytes)) {
+    frames_.push_back(Frame{fptr_write_offset_,
+        static_cast<uint32_t>(size), static_cast<uint32_t>(raw_size)});
+    fptr_write_offset_ += nr_bytes;
+    stats_->partition_bytes_written_ += nr_bytes;
+    ++stats_->mem_pages_written_;
     err = 0;
   } else {
     err = -1;
   }
 
-  cas::util::AddToTimer(stats_.runtime_partition_disk_read_, start);
+  cas::util::AddToTimer(stats_->runtime_partition_disk_write_, start);
   return err;
 }
 
 
+int cas::Partition::FReadFrame(
+    MemoryPage& page,
+    size_t page_nr,
+    BulkLoaderStats& stats) {
+  auto start = std::chrono::high_resolution_clock::now();
+  if (page_nr >= frames_.size()) {
+    return -1;
+  }
+  const auto& frame = frames_[page_nr];
+  size_t nr_bytes = context_.use_direct_io_
+    ? AlignUp(frame.size_, kFrameAlignment)
+    : frame.size_;
+  std::byte* buffer = FrameBuffer(nr_bytes);
+
+  int err = -1;
+  ssize_t bytes_read = pread(fptr_, buffer, nr_bytes, frame.offset_);
+  if (bytes_read == static_cast<ssize_t>(nr_bytes)) {
+    size_t size = frame.size_;
+    if (frame.size_ < frame.raw_size_) {
+      auto start_decompression = std::chrono::high_resolution_clock::now();
+      size = cas::Decompress(compression_,
+          buffer, frame.size_, page.Data(), page.Size());
+      cas::util::AddToTimer(stats.runtime_partition_decompression_, start_decompression);
+    } else {
+      std::memcpy(page.Data(), buffer, frame.size_);
+    }
+    if (size == frame.raw_size_) {
+      stats.partition_bytes_read_ += nr_bytes;
+      ++stats.mem_pages_read_;
+      err = 0;
+    }
+  }
+
+  cas::util::AddToTimer(stats.runtime_partition_disk_read_, start);
+  return err;
+}
+
+
+
+size_t cas::Partition::NrFilePages() const {
+  if (IsCompressed()) {
+    return frames_.size();
+  }
+  struct stat st;
+  size_t header_size = header_pages_ * page_size_;
+  if (fptr_ == -1 || fstat(fptr_, &st) == -1
+      || static_cast<size_t>(st.st_size) < header_size) {
+    return 0;
+  }
+  return (st.st_size - header_size) / page_size_;
+}
+
+
+// Pages are either free, being read by the background thread, or ready.
+// The thread stops at the last page, at the first failed read, or when
+// the cursor is destroyed.
+struct cas::Partition::Cursor::ReadAhead {
+  Partition& p_;
+  MemoryPool& pool_;
+  // reads of the background thread, merged into the cursor's stats
+  BulkLoaderStats stats_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<MemoryPage> free_;
+  std::deque<MemoryPage> ready_;
+  size_t next_page_nr_;
+  size_t last_page_nr_;
+  bool done_ = false;
+  bool stop_ = false;
+  std::thread thread_;
+
+  ReadAhead(Partition& partition, MemoryPool& pool,
+      size_t first_page_nr, size_t last_page_nr)
+    : p_(partition)
+    , pool_(pool)
+    , next_page_nr_(first_page_nr)
+    , last_page_nr_(last_page_nr)
+  { }
+
+  void Run() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (!stop_ && next_page_nr_ < last_page_nr_) {
+      cv_.wait(lock, [&] { return stop_ || !free_.empty(); });
+      if (stop_) {
+        break;
+      }
+      MemoryPage page = std::move(free_.back());
+      free_.pop_back();
+      size_t page_nr = next_page_nr_++;
+      lock.unlock();
+      int rt = p_.FReadPage(page, page_nr, last_page_nr_, nullptr, stats_);
+      lock.lock();
+      if (rt != 0) {
+        free_.push_back(std::move(page));
+        break;
+      }
+      ready_.push_back(std::move(page));
+      cv_.notify_all();
+    }
+    done_ = true;
+    cv_.notify_all();
+  }
+
+  // swaps the next page that was read ahead into io_page
+  bool Next(MemoryPage& io_page, BulkLoaderStats& stats) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::mutex> lock{mutex_};
+    cv_.wait(lock, [&] { return done_ || !ready_.empty(); });
+    cas::util::AddToTimer(stats.runtime_partition_read_ahead_wait_, start);
+    if (ready_.empty()) {
+      return false;
+    }
+    std::swap(io_page, ready_.front());
+    free_.push_back(std::move(ready_.front()));
+    ready_.pop_front();
+    cv_.notify_all();
+    return true;
+  }
+};
+
 
 cas::Partition::Cursor::Cursor(
         cas::Partition& partition,
@@ -146,10 +526,77 @@ cas::Partition::Cursor::Cursor(
   , io_page_(io_page)
   , fptr_read_page_nr_(fptr_read_page_nr)
   , fptr_last_page_nr_(fptr_last_page_nr)
+  , io_(p_.io_)
+  , stats_(p_.stats_)
+  , read_ahead_pool_(p_.read_ahead_pool_)
 {
-  if (std::filesystem::exists(p_.filename_) && p_.fptr_ == -1) {
-    p_.OpenFile();
+  p_.Open();
+}
+
+
+cas::Partition::Cursor::Cursor(
+        cas::Partition& partition,
+        MemoryPage& io_page,
+        size_t fptr_read_page_nr,
+        size_t fptr_last_page_nr,
+        IoEngine* io,
+        BulkLoaderStats& stats,
+        MemoryPool* read_ahead_pool)
+  : p_(partition)
+  , mptr_it_(p_.mptr_.end())
+  , mptr_it_prev_(p_.mptr_.before_begin())
+  , io_page_(io_page)
+  , fptr_read_page_nr_(fptr_read_page_nr)
+  , fptr_last_page_nr_(fptr_last_page_nr)
+  , io_(io)
+  , stats_(&stats)
+  , read_ahead_pool_(read_ahead_pool)
+{ }
+
+
+cas::Partition::Cursor::~Cursor() {
+  if (read_ahead_ == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard{read_ahead_->mutex_};
+    read_ahead_->stop_ = true;
+  }
+  read_ahead_->cv_.notify_all();
+  read_ahead_->thread_.join();
+  for (auto& page : read_ahead_->free_) {
+    read_ahead_->pool_.Release(std::move(page));
+  }
+  for (auto& page : read_ahead_->ready_) {
+    read_ahead_->pool_.Release(std::move(page));
+  }
+  stats_->Merge(read_ahead_->stats_);
+}
+
+
+// io_uring reads ahead on its own
+void cas::Partition::Cursor::StartReadAhead() {
+  MemoryPool* pool = read_ahead_pool_;
+  read_ahead_pool_ = nullptr;
+  size_t depth = p_.context_.read_ahead_depth_;
+  if (depth == 0 || pool == nullptr || p_.fptr_ == -1 ||
+      (io_ != nullptr && io_->IsAsync())) {
+    return;
+  }
+  size_t last_page_nr = std::min(fptr_last_page_nr_, p_.NrFilePages());
+  if (fptr_read_page_nr_ >= last_page_nr) {
+    return;
+  }
+  depth = std::min(depth, pool->NrFreePages());
+  if (depth == 0) {
+    return;
+  }
+  read_ahead_ = std::make_unique<ReadAhead>(p_, *pool,
+      fptr_read_page_nr_, last_page_nr);
+  for (size_t i = 0; i < depth; ++i) {
+    read_ahead_->free_.push_back(pool->Get());
   }
+  read_ahead_->thread_ = std::thread(&ReadAhead::Run, read_ahead_.get());
 }
 
 
@@ -162,10 +609,18 @@ bool cas::Partition::Cursor::HasNext() {
 
 
 bool cas::Partition::Cursor::FetchNextDiskPage() {
+  if (has_fetched_ && read_ahead_pool_ != nullptr) {
+    StartReadAhead();
+  }
+  if (read_ahead_ != nullptr) {
+    return read_ahead_->Next(io_page_, *stats_);
+  }
   if (p_.fptr_ != -1 && fptr_read_page_nr_ < fptr_last_page_nr_) {
-    int rt = p_.FReadPage(io_page_, fptr_read_page_nr_);
+    int rt = p_.FReadPage(io_page_, fptr_read_page_nr_, fptr_last_page_nr_,
+        io_, *stats_);
     if (rt == 0) {
       ++fptr_read_page_nr_;
+      has_fetched_ = true;
       return true;
     }
   }
@@ -0,0 +1,46 @@
+#include "cas/partition_header.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+cas::PartitionHeader cas::PartitionHeader::Read(
+    const std::byte* data, size_t size) {
+  PartitionHeader header;
+  if (size < SZ) {
+    return header;
+  }
+  uint64_t magic;
+  std::memcpy(&magic, data, sizeof(uint64_t));
+  if (magic != MAGIC) {
+    return header;
+  }
+  uint64_t page_size;
+  std::memcpy(&page_size, data + 8, sizeof(uint64_t));
+  try {
+    CheckPageSize(page_size);
+  } catch (std::runtime_error& e) {
+    throw std::runtime_error{"corrupt partition header: " + std::string{e.what()}};
+  }
+  header.page_size_ = page_size;
+  header.present_ = true;
+  return header;
+}
+
+
+cas::PartitionHeader cas::PartitionHeader::Read(const std::string& filename) {
+  std::ifstream file{filename, std::ios::binary};
+  std::byte data[SZ];
+  file.read(reinterpret_cast<char*>(data), SZ); // NOLINT
+  return Read(data, static_cast<size_t>(file.gcount()));
+}
+
+
+void cas::PartitionHeader::Write(std::byte* dst) const {
+  uint64_t magic = MAGIC;
+  uint64_t page_size = page_size_;
+  std::memset(dst, 0, page_size_);
+  std::memcpy(dst + 0, &magic, sizeof(uint64_t));
+  std::memcpy(dst + 8, &page_size, sizeof(uint64_t));
+}
+
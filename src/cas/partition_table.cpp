@@ -6,10 +6,14 @@
 cas::PartitionTable::PartitionTable(
       long& partition_counter,
       const cas::Context& context,
-      BulkLoaderStats& stats)
+      BulkLoaderStats& stats,
+      IoEngine* io,
+      MemoryPool* read_ahead_pool)
   : partition_counter_(partition_counter)
   , context_(context)
   , stats_(stats)
+  , io_(io)
+  , read_ahead_pool_(read_ahead_pool)
 {}
 
 
@@ -20,6 +24,8 @@ void cas::PartitionTable::InitializePartition(int position, int dsc_p, int dsc_v
         filename, stats_, context_);
     table_[position]->DscP(dsc_p);
     table_[position]->DscV(dsc_v);
+    table_[position]->Io(io_);
+    table_[position]->ReadAhead(read_ahead_pool_);
   }
 }
 
@@ -0,0 +1,325 @@
+#include "cas/path_automaton.hpp"
+#include "cas/key_encoding.hpp"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+
+namespace {
+
+
+enum class Symbol {
+  Byte,   // a specific byte
+  NonSep, // any byte but kPathSep
+  Any,    // any byte
+};
+
+
+struct Edge {
+  Symbol symbol_;
+  std::byte byte_;
+  size_t target_;
+
+  bool Accepts(std::byte byte) const {
+    switch (symbol_) {
+    case Symbol::Byte:
+      return byte == byte_;
+    case Symbol::NonSep:
+      return byte != cas::kPathSep;
+    case Symbol::Any:
+      return true;
+    }
+    return false;
+  }
+};
+
+
+struct Nfa {
+  std::vector<std::vector<Edge>> edges_;
+  std::vector<std::vector<size_t>> epsilons_;
+  size_t final_ = 0;
+
+  size_t AddState() {
+    edges_.emplace_back();
+    epsilons_.emplace_back();
+    return edges_.size() - 1;
+  }
+
+  void AddEdge(size_t from, Symbol symbol, size_t to,
+      std::byte byte = cas::kNullByte) {
+    edges_[from].push_back(Edge{symbol, byte, to});
+  }
+
+  void AddEpsilon(size_t from, size_t to) {
+    epsilons_[from].push_back(to);
+  }
+};
+
+
+bool IsDescendantAxis(const std::vector<std::byte>& query_path, size_t pos) {
+  return pos + 1 < query_path.size() &&
+    query_path[pos]   == cas::kByteChildAxis &&
+    query_path[pos+1] == cas::kByteChildAxis;
+}
+
+
+// mirrors the semantics of path_matcher::MatchPathIncremental:
+//  - * matches a (possibly empty) sequence of bytes within a path step,
+//    at the end of the query it must match at least one byte
+//  - /**/ matches a single / or any sequence that starts and ends with /
+//  - a trailing /** matches the empty sequence or / followed by at least
+//    one byte
+Nfa BuildNfa(const std::vector<std::byte>& query_path) {
+  Nfa nfa;
+  size_t cur = nfa.AddState();
+  size_t len = query_path.size();
+  size_t pos = 0;
+  while (pos < len) {
+    if (query_path[pos] == cas::kPathSep && IsDescendantAxis(query_path, pos+1) &&
+        (pos + 3 == len || query_path[pos+3] == cas::kPathSep)) {
+      // optional path step /** (followed by / or the end of the query)
+      size_t next = nfa.AddState();
+      size_t step = nfa.AddState();
+      nfa.AddEpsilon(cur, next);
+      nfa.AddEdge(cur, Symbol::Byte, step, cas::kPathSep);
+      if (pos + 3 == len) {
+        size_t more = nfa.AddState();
+        nfa.AddEdge(step, Symbol::Any, more);
+        nfa.AddEdge(more, Symbol::Any, more);
+        nfa.AddEpsilon(more, next);
+      } else {
+        nfa.AddEdge(step, Symbol::Any, step);
+        nfa.AddEpsilon(step, next);
+      }
+      cur = next;
+      pos += 3;
+    } else if (IsDescendantAxis(query_path, pos)) {
+      // ** that is not a path step of its own
+      size_t next = nfa.AddState();
+      nfa.AddEpsilon(cur, next);
+      if (pos + 2 < len && query_path[pos+2] == cas::kPathSep) {
+        size_t any = nfa.AddState();
+        nfa.AddEpsilon(cur, any);
+        nfa.AddEdge(any, Symbol::Any, any);
+        nfa.AddEdge(any, Symbol::Byte, next, cas::kPathSep);
+        pos += 3;
+      } else {
+        nfa.AddEdge(next, Symbol::Any, next);
+        pos += 2;
+      }
+      cur = next;
+    } else if (query_path[pos] == cas::kByteChildAxis) {
+      size_t next = nfa.AddState();
+      if (pos + 1 == len) {
+        nfa.AddEdge(cur, Symbol::NonSep, next);
+      } else {
+        nfa.AddEpsilon(cur, next);
+      }
+      nfa.AddEdge(next, Symbol::NonSep, next);
+      cur = next;
+      ++pos;
+    } else {
+      size_t next = nfa.AddState();
+      nfa.AddEdge(cur, Symbol::Byte, next, query_path[pos]);
+      cur = next;
+      ++pos;
+    }
+  }
+  nfa.final_ = cur;
+  return nfa;
+}
+
+
+using StateSet = std::vector<uint64_t>;
+
+
+void Insert(const Nfa& nfa, StateSet& set, size_t state) {
+  uint64_t bit = 1ULL << (state % 64);
+  if ((set[state / 64] & bit) != 0) {
+    return;
+  }
+  set[state / 64] |= bit;
+  for (size_t target : nfa.epsilons_[state]) {
+    Insert(nfa, set, target);
+  }
+}
+
+
+bool Contains(const StateSet& set, size_t state) {
+  return (set[state / 64] & (1ULL << (state % 64))) != 0;
+}
+
+
+} // namespace
+
+
+std::shared_ptr<const cas::PathAutomaton> cas::PathAutomaton::Compile(
+    const std::vector<std::byte>& query_path) {
+  Nfa nfa = BuildNfa(query_path);
+  size_t nr_nfa_states = nfa.edges_.size();
+  size_t words = (nr_nfa_states + 63) / 64;
+
+  auto automaton = std::make_shared<cas::PathAutomaton>();
+
+  // one class per byte of the query path (class 0 contains all other
+  // bytes), each class is represented by one of its bytes
+  std::vector<std::byte> representatives;
+  automaton->classes_.fill(0);
+  representatives.push_back(cas::kNullByte);
+  auto add_class = [&](std::byte byte) {
+    auto& c = automaton->classes_[static_cast<uint8_t>(byte)];
+    if (c == 0) {
+      c = static_cast<uint8_t>(representatives.size());
+      representatives.push_back(byte);
+    }
+  };
+  add_class(cas::kPathSep);
+  for (const auto& edges : nfa.edges_) {
+    for (const auto& edge : edges) {
+      if (edge.symbol_ == Symbol::Byte && edge.byte_ != cas::kNullByte) {
+        add_class(edge.byte_);
+      }
+    }
+  }
+  for (int byte = 1; byte < 256; ++byte) {
+    if (automaton->classes_[byte] == 0) {
+      representatives[0] = std::byte(byte);
+      break;
+    }
+  }
+  size_t nr_classes = representatives.size();
+  automaton->nr_classes_ = nr_classes;
+
+  // subset construction, state 0 (kDead) is the empty set
+  std::vector<StateSet> sets;
+  std::map<StateSet, uint16_t> ids;
+  auto state_id = [&](StateSet&& set) -> size_t {
+    auto it = ids.find(set);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    uint16_t id = static_cast<uint16_t>(sets.size());
+    ids.emplace(set, id);
+    sets.push_back(std::move(set));
+    return id;
+  };
+  state_id(StateSet(words, 0));
+  StateSet start(words, 0);
+  Insert(nfa, start, 0);
+  state_id(std::move(start));
+
+  std::vector<uint16_t>& transitions = automaton->transitions_;
+  for (size_t state = 0; state < sets.size(); ++state) {
+    if (sets.size() > kMaxStates) {
+      return nullptr;
+    }
+    for (size_t c = 0; c < nr_classes; ++c) {
+      StateSet target(words, 0);
+      for (size_t s = 0; s < nr_nfa_states; ++s) {
+        if (!Contains(sets[state], s)) {
+          continue;
+        }
+        for (const auto& edge : nfa.edges_[s]) {
+          if (edge.Accepts(representatives[c])) {
+            Insert(nfa, target, edge.target_);
+          }
+        }
+      }
+      // sets may be reallocated by state_id
+      transitions.push_back(static_cast<uint16_t>(state_id(std::move(target))));
+    }
+  }
+  size_t nr_states = sets.size();
+
+  auto& flags = automaton->flags_;
+  flags.assign(nr_states, 0);
+  for (size_t state = 0; state < nr_states; ++state) {
+    if (Contains(sets[state], nfa.final_)) {
+      flags[state] |= kFlagAccepting;
+    }
+  }
+
+  // states from which no accepting state can be reached are dead
+  std::vector<bool> live(nr_states, false);
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (size_t state = 1; state < nr_states; ++state) {
+      if (live[state]) {
+        continue;
+      }
+      bool reaches = (flags[state] & kFlagAccepting) != 0;
+      for (size_t c = 0; c < nr_classes && !reaches; ++c) {
+        reaches = live[transitions[state * nr_classes + c]];
+      }
+      if (reaches) {
+        live[state] = true;
+        changed = true;
+      }
+    }
+  }
+  for (auto& target : transitions) {
+    if (!live[target]) {
+      target = kDead;
+    }
+  }
+
+  // states that accept every extension, i.e., that are accepting and
+  // cannot leave this set of states
+  for (size_t state = 1; state < nr_states; ++state) {
+    if ((flags[state] & kFlagAccepting) != 0) {
+      flags[state] |= kFlagAnyExtension;
+    }
+  }
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (size_t state = 1; state < nr_states; ++state) {
+      if ((flags[state] & kFlagAnyExtension) == 0) {
+        continue;
+      }
+      for (size_t c = 0; c < nr_classes; ++c) {
+        if ((flags[transitions[state * nr_classes + c]] & kFlagAnyExtension) == 0) {
+          flags[state] &= ~kFlagAnyExtension;
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  // the child bytes that can lead to a match (kNullByte ends the path)
+  automaton->low_.assign(nr_states, 0xFF);
+  automaton->high_.assign(nr_states, 0x00);
+  for (size_t state = 1; state < nr_states; ++state) {
+    for (int byte = 0; byte < 256; ++byte) {
+      bool viable = byte == 0
+        ? (flags[state] & kFlagAccepting) != 0
+        : automaton->Next(state, std::byte(byte)) != kDead;
+      if (viable) {
+        automaton->low_[state] = std::min<uint8_t>(automaton->low_[state], byte);
+        automaton->high_[state] = byte;
+      }
+    }
+  }
+
+  return automaton;
+}
+
+
+void cas::PathAutomaton::Dump() const {
+  std::cout << "PathAutomaton\n";
+  std::cout << "nr_states: " << NrStates() << "\n";
+  std::cout << "nr_classes: " << NrClasses() << "\n";
+  for (size_t state = 0; state < NrStates(); ++state) {
+    std::cout << state << ":";
+    for (size_t c = 0; c < nr_classes_; ++c) {
+      std::cout << " " << transitions_[state * nr_classes_ + c];
+    }
+    if (IsAccepting(state)) {
+      std::cout << " (accepting)";
+    }
+    if (AcceptsAnyExtension(state)) {
+      std::cout << " (any extension)";
+    }
+    std::cout << "\n";
+  }
+}
@@ -6,6 +6,37 @@
 #include <stdexcept>
 
 
+cas::path_matcher::PrefixMatch cas::path_matcher::MatchPathIncremental(
+      const cas::QueryBuffer& path,
+      const cas::BinarySK& key,
+      size_t len_path,
+      State& s) {
+  if (key.automaton_ == nullptr) {
+    return MatchPathIncremental(path, key.path_, len_path, s);
+  }
+
+  const cas::PathAutomaton& automaton = *key.automaton_;
+  uint16_t state = s.dfa_state_;
+  size_t ppos = s.ppos_;
+  while (ppos < len_path) {
+    if (path[ppos] == cas::kNullByte) {
+      // we reached the end of a full path
+      s.ppos_ = ppos;
+      s.dfa_state_ = state;
+      return automaton.IsAccepting(state) ? PrefixMatch::MATCH : PrefixMatch::MISMATCH;
+    }
+    state = automaton.Next(state, path[ppos]);
+    ++ppos;
+    if (state == cas::PathAutomaton::kDead) {
+      return PrefixMatch::MISMATCH;
+    }
+  }
+  s.ppos_ = ppos;
+  s.dfa_state_ = state;
+  return PrefixMatch::INCOMPLETE;
+}
+
+
 cas::path_matcher::PrefixMatch cas::path_matcher::MatchPathIncremental(
       const cas::QueryBuffer& path,
       const std::vector<std::byte>& query_path,
@@ -89,6 +120,15 @@ cas::path_matcher::PrefixMatch cas::path_matcher::MatchPathIncremental(
 }
 
 
+bool cas::path_matcher::MatchPath(
+      const cas::QueryBuffer& path,
+      const cas::BinarySK& key,
+      size_t len_path) {
+  State s;
+  return MatchPathIncremental(path, key, len_path, s) == PrefixMatch::MATCH;
+}
+
+
 bool cas::path_matcher::MatchPath(
       const cas::QueryBuffer& path,
       const std::vector<std::byte>& query_path,
@@ -98,8 +138,30 @@ bool cas::path_matcher::MatchPath(
 }
 
 
+bool cas::path_matcher::MatchesAnyExtension(
+      const cas::BinarySK& key,
+      const State& s) {
+  if (key.automaton_ == nullptr) {
+    return MatchesAnyExtension(key.path_, s);
+  }
+  return key.automaton_->AcceptsAnyExtension(s.dfa_state_);
+}
+
+
+bool cas::path_matcher::MatchesAnyExtension(
+      const std::vector<std::byte>& query_path,
+      const State& s) {
+  // after a trailing /** the matcher only advances desc_ppos_ (and
+  // eventually accepts at the end of the path), there is no pattern
+  // symbol left that could mismatch
+  return s.star_qpos_ == -1 &&
+    s.desc_qpos_ == static_cast<int16_t>(query_path.size() + 1);
+}
+
+
 void cas::path_matcher::State::Dump() const {
   std::cout << "ppos_: " << ppos_ << std::endl;
+  std::cout << "dfa_state_: " << dfa_state_ << std::endl;
   std::cout << "qpos_: " << qpos_ << std::endl;
   std::cout << "desc_ppos_: " << desc_ppos_ << std::endl;
   std::cout << "desc_qpos_: " << desc_qpos_ << std::endl;
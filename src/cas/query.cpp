@@ -4,6 +4,7 @@
 #include <cassert>
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <functional>
 #include <iostream>
 #include <list>
@@ -21,6 +22,27 @@ cas::Query::Query(
 {}
 
 
+cas::Query::Query(const Query& parent, const State& s)
+    : root_(s.node_)
+    , key_(parent.key_)
+    , emitter_(parent.emitter_)
+    , buf_pat_(std::make_unique<QueryBuffer>())
+    , buf_val_(std::make_unique<QueryBuffer>())
+    , emitter_mutex_(parent.emitter_mutex_)
+{
+  // the task continues with the prefixes matched so far
+  std::memcpy(buf_pat_->data(), parent.buf_pat_->data(), s.len_pat_);
+  std::memcpy(buf_val_->data(), parent.buf_val_->data(), s.len_val_);
+}
+
+
+void cas::Query::Parallelize(ThreadPool& pool, size_t min_fanout) {
+  pool_ = &pool;
+  min_fanout_ = min_fanout;
+  emitter_mutex_ = std::make_shared<std::mutex>();
+}
+
+
 void cas::Query::Execute() {
   if (root_ == nullptr) {
     return;
@@ -37,13 +59,67 @@ void cas::Query::Execute() {
     .vl_pos_ = 0,
     .vh_pos_ = 0,
   };
-  EvaluateQuery(initial_state);
+  try {
+    EvaluateQuery(initial_state);
+  } catch (...) {
+    // the tasks must not outlive the query
+    try { CompleteTasks(); } catch (...) {}
+    throw;
+  }
+  CompleteTasks();
   const auto& t_end = std::chrono::high_resolution_clock::now();
   stats_.runtime_mus_ =
     std::chrono::duration_cast<std::chrono::microseconds>(t_end-t_start).count();
 }
 
 
+void cas::Query::Spawn(State s, const cas::INode* child) {
+  auto task = std::make_shared<Task>();
+  // a child of a NodeReader lives only as long as the ForEachChild callback
+  task->node_ = child->Detach();
+  s.node_ = task->node_ != nullptr ? task->node_.get() : child;
+  task->state_ = s;
+  task->query_ = std::unique_ptr<Query>(new Query(*this, s));
+  task->done_ = pool_->Submit([task]() {
+    if (!task->claimed_.exchange(true)) {
+      task->query_->EvaluateQuery(task->state_);
+    }
+  });
+  tasks_.push_back(std::move(task));
+}
+
+
+void cas::Query::CompleteTasks() {
+  std::exception_ptr error;
+  for (auto& task : tasks_) {
+    try {
+      // tasks that did not start yet are executed by this thread
+      if (!task->claimed_.exchange(true)) {
+        task->query_->EvaluateQuery(task->state_);
+      } else {
+        task->done_.get();
+      }
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+      continue;
+    }
+    const auto& stats = task->query_->stats_;
+    stats_.nr_matches_       += stats.nr_matches_;
+    stats_.read_nodes_       += stats.read_nodes_;
+    stats_.read_path_nodes_  += stats.read_path_nodes_;
+    stats_.read_value_nodes_ += stats.read_value_nodes_;
+    stats_.read_leaf_nodes_  += stats.read_leaf_nodes_;
+    stats_.sum_depth_        += stats.sum_depth_;
+  }
+  tasks_.clear();
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+
 void cas::Query::EvaluateQuery(State& s) {
   UpdateStats(s.node_);
   PrepareBuffer(s, s.node_);
@@ -106,7 +182,12 @@ void cas::Query::EmitMatch(const State& s,
       const cas::ref_t& ref) {
   ++stats_.nr_matches_;
   stats_.sum_depth_ += s.depth_;
-  emitter_(*buf_pat_, s.len_pat_, *buf_val_, s.len_val_, ref);
+  if (emitter_mutex_ != nullptr) {
+    std::lock_guard<std::mutex> guard{*emitter_mutex_};
+    emitter_(*buf_pat_, s.len_pat_, *buf_val_, s.len_val_, ref);
+  } else {
+    emitter_(*buf_pat_, s.len_pat_, *buf_val_, s.len_val_, ref);
+  }
 }
 
 
@@ -151,46 +232,73 @@ void cas::Query::PrepareBuffer(State& s, const cas::INode* node) {
 
 cas::path_matcher::PrefixMatch
 cas::Query::MatchPathPrefix(State& s) {
-  return cas::path_matcher::MatchPathIncremental(*buf_pat_, key_.path_,
+  return cas::path_matcher::MatchPathIncremental(*buf_pat_, key_,
       s.len_pat_, s.pm_state_);
 }
 
 
 cas::path_matcher::PrefixMatch
 cas::Query::MatchValuePrefix(State& s) {
-  // match as much as possible of key_.low_
-  while (s.vl_pos_ < key_.low_.size() &&
-         s.vl_pos_ < s.len_val_ &&
-         buf_val_->at(s.vl_pos_) == key_.low_[s.vl_pos_]) {
-    ++s.vl_pos_;
+  return MatchValue(key_, *buf_val_, s.len_val_, s.vl_pos_, s.vh_pos_);
+}
+
+
+cas::path_matcher::PrefixMatch
+cas::Query::MatchValue(
+    const BinarySK& key,
+    const QueryBuffer& buf_val,
+    uint16_t len_val,
+    uint16_t& vl_pos,
+    uint16_t& vh_pos) {
+  // match as much as possible of key.low_
+  while (vl_pos < key.low_.size() &&
+         vl_pos < len_val &&
+         buf_val[vl_pos] == key.low_[vl_pos]) {
+    ++vl_pos;
   }
-  // match as much as possible of key_.high_
-  while (s.vh_pos_ < key_.high_.size() &&
-         s.vh_pos_ < s.len_val_ &&
-         buf_val_->at(s.vh_pos_) == key_.high_[s.vh_pos_]) {
-    ++s.vh_pos_;
+  // match as much as possible of key.high_
+  while (vh_pos < key.high_.size() &&
+         vh_pos < len_val &&
+         buf_val[vh_pos] == key.high_[vh_pos]) {
+    ++vh_pos;
   }
 
-  if (s.vl_pos_ < key_.low_.size() && s.vl_pos_ < s.len_val_ &&
-      buf_val_->at(s.vl_pos_) < key_.low_[s.vl_pos_]) {
-    // buf_val_ < key_.low_
+  if (vl_pos < key.low_.size() && vl_pos < len_val &&
+      buf_val[vl_pos] < key.low_[vl_pos]) {
+    // buf_val < key.low_
     return path_matcher::PrefixMatch::MISMATCH;
   }
 
-  if (s.vh_pos_ < key_.high_.size() && s.vh_pos_ < s.len_val_ &&
-      buf_val_->at(s.vh_pos_) > key_.high_[s.vh_pos_]) {
-    // buf_val_ > key_.high_
+  if (vh_pos < key.high_.size() && vh_pos < len_val &&
+      buf_val[vh_pos] > key.high_[vh_pos]) {
+    // buf_val > key.high_
     return path_matcher::PrefixMatch::MISMATCH;
   }
 
   // TODO: here we assume the values are 64 bit numbers
-  bool is_complete_value = s.len_val_ == sizeof(cas::vint64_t);
+  bool is_complete_value = len_val == sizeof(cas::vint64_t);
 
   return is_complete_value ? path_matcher::PrefixMatch::MATCH
                            : path_matcher::PrefixMatch::INCOMPLETE;
 }
 
 
+bool cas::Query::ValueRangeCovers(
+    const BinarySK& key,
+    const QueryBuffer& buf_val,
+    uint16_t len_val,
+    uint16_t vl_pos,
+    uint16_t vh_pos) {
+  // the prefix either equals key.low_ completely or is already greater
+  bool above_low = vl_pos == key.low_.size() ||
+    (vl_pos < len_val && buf_val[vl_pos] > key.low_[vl_pos]);
+  // the prefix either equals key.high_ completely or is already smaller
+  bool below_high = vh_pos == key.high_.size() ||
+    (vh_pos < len_val && buf_val[vh_pos] < key.high_[vh_pos]);
+  return above_low && below_high;
+}
+
+
 void cas::Query::Descend(const State& s, const cas::INode* node) {
   switch (node->Dimension()) {
   case cas::Dimension::PATH:
@@ -206,46 +314,87 @@ void cas::Query::Descend(const State& s, const cas::INode* node) {
 
 
 void cas::Query::DescendPathNode(const State& s, const cas::INode* node) {
-  // default is to descend all children of s.node_
-  std::byte low{0x00};
-  std::byte high{0xFF};
-  // check if we are looking for exactly one child
-  if (!(s.pm_state_.desc_qpos_ != -1 ||
-      s.pm_state_.star_qpos_ != -1 ||
-      key_.path_[s.pm_state_.qpos_] == cas::kByteChildAxis)) {
-    low  = key_.path_[s.pm_state_.qpos_];
-    high = key_.path_[s.pm_state_.qpos_];
-  }
+  std::byte low;
+  std::byte high;
+  PathChildRange(key_, s.pm_state_, low, high);
   DescendNode(s, node, low, high);
 }
 
 
 void cas::Query::DescendValueNode(const State& s, const cas::INode* node) {
-  std::byte low  = (s.vl_pos_ == s.len_val_) ? key_.low_[s.vl_pos_]  : std::byte{0x00};
-  std::byte high = (s.vh_pos_ == s.len_val_) ? key_.high_[s.vh_pos_] : std::byte{0xFF};
+  std::byte low;
+  std::byte high;
+  ValueChildRange(key_, s.len_val_, s.vl_pos_, s.vh_pos_, low, high);
   DescendNode(s, node, low, high);
 }
 
 
+void cas::Query::PathChildRange(
+    const BinarySK& key,
+    const path_matcher::State& pm_state,
+    std::byte& low,
+    std::byte& high) {
+  if (key.automaton_ != nullptr) {
+    low  = key.automaton_->LowChild(pm_state.dfa_state_);
+    high = key.automaton_->HighChild(pm_state.dfa_state_);
+    return;
+  }
+  // default is to descend all children
+  low  = std::byte{0x00};
+  high = std::byte{0xFF};
+  // check if we are looking for exactly one child
+  if (!(pm_state.desc_qpos_ != -1 ||
+      pm_state.star_qpos_ != -1 ||
+      key.path_[pm_state.qpos_] == cas::kByteChildAxis)) {
+    low  = key.path_[pm_state.qpos_];
+    high = key.path_[pm_state.qpos_];
+  }
+}
+
+
+void cas::Query::ValueChildRange(
+    const BinarySK& key,
+    uint16_t len_val,
+    uint16_t vl_pos,
+    uint16_t vh_pos,
+    std::byte& low,
+    std::byte& high) {
+  low  = (vl_pos == len_val) ? key.low_[vl_pos]  : std::byte{0x00};
+  high = (vh_pos == len_val) ? key.high_[vh_pos] : std::byte{0xFF};
+}
+
+
 void cas::Query::DescendNode(const State& s,
     const cas::INode* node, std::byte low, std::byte high) {
-  node->ForEachChild([&](uint8_t byte, cas::INode* child){
-    if (static_cast<uint8_t>(low) <= byte && byte <= static_cast<uint8_t>(high)) {
-      State copy = {
-        .is_root_          = false,
-        .node_             = child,
-        .parent_dimension_ = node->Dimension(),
-        .parent_byte_      = static_cast<std::byte>(byte),
-        .len_pat_          = s.len_pat_,
-        .len_val_          = s.len_val_,
-        .pm_state_         = s.pm_state_,
-        .vl_pos_           = s.vl_pos_,
-        .vh_pos_           = s.vh_pos_,
-        .depth_            = s.depth_ + 1,
-      };
+  // split into subtree tasks if many children can qualify
+  size_t range = static_cast<uint8_t>(high) - static_cast<uint8_t>(low) + 1;
+  bool parallel = pool_ != nullptr &&
+    std::min(node->NrChildren(), range) >= min_fanout_;
+  const cas::INode::ChildCallback visit = [&](uint8_t byte, cas::INode* child){
+    State copy = {
+      .is_root_          = false,
+      .node_             = child,
+      .parent_dimension_ = node->Dimension(),
+      .parent_byte_      = static_cast<std::byte>(byte),
+      .len_pat_          = s.len_pat_,
+      .len_val_          = s.len_val_,
+      .pm_state_         = s.pm_state_,
+      .vl_pos_           = s.vl_pos_,
+      .vh_pos_           = s.vh_pos_,
+      .depth_            = s.depth_ + 1,
+    };
+    if (parallel) {
+      Spawn(copy, child);
+    } else {
       EvaluateQuery(copy);
     }
-  });
+  };
+  // selective queries only look up the one child they need
+  if (low == high) {
+    node->LookupChild(static_cast<uint8_t>(low), visit);
+  } else {
+    node->ForEachChildInRange(static_cast<uint8_t>(low), static_cast<uint8_t>(high), visit);
+  }
 }
 
 
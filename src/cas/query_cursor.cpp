@@ -0,0 +1,95 @@
+#include "cas/query_cursor.hpp"
+#include <cstring>
+
+
+void cas::QueryCursor::Collector::operator()(
+    const cas::QueryBuffer& path, size_t len_path,
+    const cas::QueryBuffer& value, size_t len_value,
+    cas::ref_t ref)
+{
+  if (!copy_) {
+    return;
+  }
+  std::memcpy(path_->data(), path.data(), len_path);
+  std::memcpy(value_->data(), value.data(), len_value);
+  len_path_ = len_path;
+  len_value_ = len_value;
+  ref_ = ref;
+}
+
+
+cas::QueryCursor::QueryCursor(
+        const cas::mem::Node* root,
+        std::shared_ptr<const cas::IndexReader> reader,
+        const cas::BinarySK& key,
+        size_t limit)
+    : key_(std::make_unique<const cas::BinarySK>(key))
+    , collector_(std::make_unique<Collector>())
+    , reader_(std::move(reader))
+    , limit_(limit)
+{
+  collector_->path_ = std::make_unique<cas::QueryBuffer>();
+  collector_->value_ = std::make_unique<cas::QueryBuffer>();
+  if (root != nullptr) {
+    mem_engine_ = std::make_unique<MemEngine>(root, *key_, *collector_);
+  }
+}
+
+
+bool cas::QueryCursor::Next() {
+  if (nr_returned_ >= limit_) {
+    return false;
+  }
+  collector_->copy_ = true;
+  if (Advance(1) == 0) {
+    return false;
+  }
+  ++nr_returned_;
+  return true;
+}
+
+
+size_t cas::QueryCursor::Skip(size_t n) {
+  collector_->copy_ = false;
+  size_t nr_skipped = Advance(n);
+  collector_->copy_ = true;
+  return nr_skipped;
+}
+
+
+size_t cas::QueryCursor::Advance(size_t n) {
+  size_t nr_emitted = 0;
+  while (nr_emitted < n) {
+    if (mem_engine_ != nullptr) {
+      nr_emitted += mem_engine_->Next(n - nr_emitted);
+      if (mem_engine_->Done()) {
+        stats_ = cas::QueryStats::Sum({stats_, mem_engine_->Stats()});
+        mem_engine_.reset();
+      }
+    } else if (file_engine_ != nullptr) {
+      nr_emitted += file_engine_->Next(n - nr_emitted);
+      if (file_engine_->Done()) {
+        stats_ = cas::QueryStats::Sum({stats_, file_engine_->Stats()});
+        file_engine_.reset();
+      }
+    } else if (reader_ != nullptr && next_file_ < reader_->NrFiles()) {
+      file_root_ = std::make_unique<cas::NodeReader>(reader_->Root(next_file_++));
+      file_engine_ = std::make_unique<FileEngine>(file_root_.get(), *key_, *collector_);
+    } else {
+      break;
+    }
+  }
+  return nr_emitted;
+}
+
+
+cas::QueryStats cas::QueryCursor::Stats() const {
+  std::vector<cas::QueryStats> stats{stats_};
+  if (mem_engine_ != nullptr) {
+    stats.push_back(mem_engine_->Stats());
+  }
+  if (file_engine_ != nullptr) {
+    stats.push_back(file_engine_->Stats());
+  }
+  return cas::QueryStats::Sum(stats);
+}
@@ -29,7 +29,8 @@ cas::QueryStats cas::QueryExecutor::Execute(
     std::string error_msg = "mmap of file '" + idx_filename_ + "' failed";
     throw std::runtime_error{error_msg};
   }
-  cas::NodeReader root{file, 0};
+  auto layout = cas::IndexLayout::Read(file, file_size);
+  cas::NodeReader root{file, 0, &layout};
 
   cas::Query query{&root, key, emitter};
   query.Execute();
@@ -0,0 +1,56 @@
+#include "cas/query_service.hpp"
+
+
+template<class VType>
+cas::QueryService<VType>::QueryService(Index<VType>& index, size_t nr_workers)
+  : index_(index)
+  , pool_(nr_workers)
+{
+  index_.QueryPool(&pool_);
+}
+
+
+template<class VType>
+cas::QueryService<VType>::~QueryService() {
+  index_.QueryPool(nullptr);
+}
+
+
+template<class VType>
+cas::QueryStats cas::QueryService<VType>::Query(
+    const BinarySK& key,
+    const BinaryKeyEmitter& emitter) {
+  std::shared_lock<std::shared_mutex> lock{index_mutex_};
+  return index_.Query(key, emitter);
+}
+
+
+template<class VType>
+std::future<cas::QueryStats> cas::QueryService<VType>::Submit(
+    BinarySK key,
+    BinaryKeyEmitter emitter) {
+  if (pool_.NrThreads() == 0) {
+    throw std::runtime_error{"QueryService has no worker threads"};
+  }
+  return pool_.Submit(
+      [this, key = std::move(key), emitter = std::move(emitter)]() {
+        return Query(key, emitter);
+      });
+}
+
+
+template<class VType>
+void cas::QueryService<VType>::Insert(BinaryKey key) {
+  std::unique_lock<std::shared_mutex> lock{index_mutex_};
+  index_.Insert(key);
+}
+
+
+template<class VType>
+void cas::QueryService<VType>::FlushMemoryResidentKeys() {
+  std::unique_lock<std::shared_mutex> lock{index_mutex_};
+  index_.FlushMemoryResidentKeys();
+}
+
+
+template class cas::QueryService<cas::vint64_t>;
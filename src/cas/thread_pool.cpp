@@ -0,0 +1,57 @@
+#include "cas/thread_pool.hpp"
+
+
+cas::ThreadPool::ThreadPool(size_t nr_threads) {
+  workers_.reserve(nr_threads);
+  for (size_t i = 0; i < nr_threads; ++i) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+}
+
+
+cas::ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard{mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  // outstanding tasks are completed before the workers terminate
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  // a pool without workers completes its tasks here
+  while (RunPendingTask()) {}
+}
+
+
+bool cas::ThreadPool::RunPendingTask() {
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> guard{mutex_};
+    if (tasks_.empty()) {
+      return false;
+    }
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+  }
+  task();
+  return true;
+}
+
+
+void cas::ThreadPool::Work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    // exceptions are stored in the task's future
+    task();
+  }
+}
@@ -2,6 +2,15 @@
 #include <stdexcept>
 
 
+void cas::CheckPageSize(size_t page_size) {
+  if (page_size < PAGE_SZ_MIN || page_size > PAGE_SZ_MAX
+      || page_size % PAGE_SZ_MIN != 0) {
+    throw std::runtime_error{"page size " + std::to_string(page_size)
+      + " is not a multiple of 4KB between 4KB and 1MB"};
+  }
+}
+
+
 std::string cas::ToString(MemoryPlacement v){
   switch (v) {
     case MemoryPlacement::FrontLoading:
@@ -34,6 +43,109 @@ std::string cas::ToString(DscComputation v) {
 }
 
 
+std::string cas::ToString(IndexAdvice v) {
+  switch (v) {
+    case IndexAdvice::Normal:
+      return "normal";
+    case IndexAdvice::Random:
+      return "random";
+    case IndexAdvice::Sequential:
+      return "sequential";
+    case IndexAdvice::WillNeed:
+      return "willneed";
+    default:
+      throw std::runtime_error{"unknown IndexAdvice"};
+  }
+  return "";
+}
+
+
+std::string cas::ToString(NodeFormat v) {
+  switch (v) {
+    case NodeFormat::Interleaved:
+      return "interleaved";
+    case NodeFormat::KeyArray:
+      return "key_array";
+    default:
+      throw std::runtime_error{"unknown NodeFormat"};
+  }
+  return "";
+}
+
+
+std::string cas::ToString(QueryOrder v) {
+  switch (v) {
+    case QueryOrder::Unordered:
+      return "unordered";
+    case QueryOrder::ValueAsc:
+      return "value_asc";
+    case QueryOrder::ValueDesc:
+      return "value_desc";
+    default:
+      throw std::runtime_error{"unknown QueryOrder"};
+  }
+  return "";
+}
+
+
+std::string cas::ToString(PageFormat v) {
+  switch (v) {
+    case PageFormat::Plain:
+      return "plain";
+    case PageFormat::FrontCoded:
+      return "front_coded";
+    default:
+      throw std::runtime_error{"unknown PageFormat"};
+  }
+  return "";
+}
+
+
+std::string cas::ToString(Compression v) {
+  switch (v) {
+    case Compression::None:
+      return "none";
+    case Compression::Lz4:
+      return "lz4";
+    case Compression::Zstd:
+      return "zstd";
+    default:
+      throw std::runtime_error{"unknown Compression"};
+  }
+  return "";
+}
+
+
+std::string cas::ToString(PrefixKernel v) {
+  switch (v) {
+    case PrefixKernel::Scalar:
+      return "scalar";
+    case PrefixKernel::Sse2:
+      return "sse2";
+    case PrefixKernel::Avx2:
+      return "avx2";
+    default:
+      throw std::runtime_error{"unknown PrefixKernel"};
+  }
+  return "";
+}
+
+
 std::string cas::ToString(const uint64_t& ref) {
   return std::to_string(ref);
 }
+
+
+std::string cas::ToString(HugePages v) {
+  switch (v) {
+    case HugePages::None:
+      return "none";
+    case HugePages::Transparent:
+      return "transparent";
+    case HugePages::Explicit:
+      return "explicit";
+    default:
+      throw std::runtime_error{"unknown HugePages"};
+  }
+  return "";
+}
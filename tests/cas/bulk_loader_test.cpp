@@ -0,0 +1,256 @@
+#include "test/catch.hpp"
+#include "index_builder.hpp"
+#include "cas/compression.hpp"
+#include "cas/partition_table.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+std::vector<test::Input> Inputs(size_t nr_keys) {
+  std::vector<test::Input> inputs;
+  for (size_t i = 0; i < nr_keys; ++i) {
+    inputs.push_back({
+        "/d" + std::to_string(i % 13) + "/s" + std::to_string(i % 101)
+          + "/f" + std::to_string(i / 7) + ".c",
+        static_cast<cas::vint64_t>(i % 53) - 20,
+        i});
+  }
+  return inputs;
+}
+
+
+// the discriminative bytes and keys of a child partition of the root
+struct Child {
+  int dsc_p_;
+  int dsc_v_;
+  size_t nr_keys_;
+  size_t key_bytes_;
+  std::vector<std::string> keys_;
+
+  bool operator==(const Child& other) const {
+    return dsc_p_ == other.dsc_p_ && dsc_v_ == other.dsc_v_
+      && nr_keys_ == other.nr_keys_ && key_bytes_ == other.key_bytes_
+      && keys_ == other.keys_;
+  }
+};
+
+struct Children {
+  std::map<int, Child> children_;
+  size_t nr_memory_pages_ = 0;
+  size_t nr_disk_pages_ = 0;
+};
+
+// partitions the keys once and reads back the child partitions
+Children PartitionRoot(cas::Context context, const std::string& dir,
+    const std::string& name, const std::vector<test::Input>& inputs) {
+  context.input_filename_ = dir + name + ".partition";
+  context.partition_folder_ = dir + name + "_partitions/";
+  context.index_file_ = dir + name;
+  test::WritePartition(context.input_filename_, inputs);
+  cas::BulkLoaderStats stats;
+  cas::BulkLoader<cas::vint64_t> bulk_loader{context, stats};
+  long partition_counter = 0;
+  cas::PartitionTable table{partition_counter, context, stats};
+  bulk_loader.PartitionRoot(table, cas::Dimension::PATH);
+
+  Children children;
+  std::vector<std::byte> buffer(cas::PAGE_SZ);
+  cas::MemoryPage io_page{buffer.data()};
+  for (int b = 0x00; b <= 0xFF; ++b) {
+    if (table.Absent(b)) {
+      continue;
+    }
+    auto& partition = table[b];
+    Child child{partition.DscP(), partition.DscV(),
+      partition.NrKeys(), partition.KeyBytes(), {}};
+    children.nr_memory_pages_ += partition.NrMemoryPages();
+    children.nr_disk_pages_ += partition.NrDiskPages();
+    auto cursor = partition.Cursor(io_page);
+    while (cursor.HasNext()) {
+      for (auto key : cursor.NextPage()) {
+        child.keys_.emplace_back(
+            reinterpret_cast<const char*>(key.Begin()), key.ByteSize());
+      }
+    }
+    std::sort(child.keys_.begin(), child.keys_.end());
+    children.children_.emplace(b, std::move(child));
+  }
+  return children;
+}
+
+} // namespace
+
+
+TEST_CASE("Parallel construction", "[cas::BulkLoader]") {
+  auto dir = test::Directory("parallel_construction");
+  auto inputs = Inputs(20'000);
+  cas::Context context;
+  context.mem_size_bytes_ = 2048 * cas::PAGE_SZ;
+
+  auto sequential = test::BuildIndex(context, dir, "sequential", inputs);
+  context.nr_threads_ = 4;
+  auto parallel = test::BuildIndex(context, dir, "parallel", inputs);
+
+  // the subtrees are relocated behind the root in byte order
+  REQUIRE(test::ReadFile(parallel) == test::ReadFile(sequential));
+
+  auto all = test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX);
+  REQUIRE(test::Query(parallel, all) == test::Encode(inputs));
+  for (const auto& key : {
+      test::SearchKey("/d3/**", cas::VINT64_MIN, cas::VINT64_MAX),
+      test::SearchKey("/d*/s7/*", -5, 3),
+      test::SearchKey("/**/f10*.c", 2, 2)}) {
+    auto matches = test::Query(sequential, key);
+    REQUIRE(!matches.empty());
+    REQUIRE(test::Query(parallel, key) == matches);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Asynchronous partition I/O", "[cas::BulkLoader]") {
+  auto dir = test::Directory("asynchronous_io");
+  auto inputs = Inputs(20'000);
+  cas::Context context;
+  // only a few work pages such that partitions are spilled to disk
+  context.mem_size_bytes_ = (1 + cas::BYTE_MAX + 16) * cas::PAGE_SZ;
+
+  auto synchronous = test::BuildIndex(context, dir, "synchronous", inputs);
+  context.write_behind_pages_ = 8;
+  auto write_behind = test::BuildIndex(context, dir, "write_behind", inputs);
+  context.write_behind_pages_ = 0;
+  context.io_queue_depth_ = 8;
+  auto asynchronous = test::BuildIndex(context, dir, "asynchronous", inputs);
+
+  REQUIRE(test::ReadFile(write_behind) == test::ReadFile(synchronous));
+  REQUIRE(test::ReadFile(asynchronous) == test::ReadFile(synchronous));
+  auto all = test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX);
+  REQUIRE(test::Query(asynchronous, all) == test::Encode(inputs));
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Page sizes", "[cas::BulkLoader]") {
+  auto dir = test::Directory("page_sizes");
+  auto inputs = Inputs(20'000);
+  cas::Context context;
+  auto reference = test::BuildIndex(context, dir, "reference", inputs);
+  auto all = test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX);
+  auto some = test::SearchKey("/d*/s7/*", -5, 3);
+  auto some_matches = test::Query(reference, some);
+  REQUIRE(!some_matches.empty());
+
+  for (size_t page_size : {cas::PAGE_SZ_4KB, cas::PAGE_SZ_64KB, cas::PAGE_SZ_1MB}) {
+    // only a few work pages such that partitions are spilled to disk
+    context.page_size_ = page_size;
+    context.mem_size_bytes_ = (1 + cas::BYTE_MAX + 16) * page_size;
+    auto name = "page_size_" + std::to_string(page_size);
+    auto index = test::BuildIndex(context, dir, name, inputs);
+    REQUIRE(test::Query(index, all) == test::Encode(inputs));
+    REQUIRE(test::Query(index, some) == some_matches);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Front-coded partition pages", "[cas::BulkLoader]") {
+  auto dir = test::Directory("front_coded_pages");
+  auto inputs = Inputs(20'000);
+  cas::Context context;
+  context.mem_size_bytes_ = (1 + cas::BYTE_MAX + 16) * cas::PAGE_SZ;
+
+  auto plain = test::BuildIndex(context, dir, "plain", inputs);
+  context.page_format_ = cas::PageFormat::FrontCoded;
+  auto front_coded = test::BuildIndex(context, dir, "front_coded", inputs);
+
+  REQUIRE(test::ReadFile(front_coded) == test::ReadFile(plain));
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Compressed partition files", "[cas::BulkLoader]") {
+  auto dir = test::Directory("compressed_partitions");
+  auto inputs = Inputs(20'000);
+  cas::Context context;
+  context.mem_size_bytes_ = (1 + cas::BYTE_MAX + 16) * cas::PAGE_SZ;
+  auto uncompressed = test::BuildIndex(context, dir, "uncompressed", inputs);
+
+  for (auto compression : {cas::Compression::Lz4, cas::Compression::Zstd}) {
+    if (!cas::IsSupported(compression)) {
+      WARN("compression " << cas::ToString(compression) << " is not supported");
+      continue;
+    }
+    context.partition_compression_ = compression;
+    auto compressed = test::BuildIndex(context, dir,
+        "compressed_" + cas::ToString(compression), inputs);
+    REQUIRE(test::ReadFile(compressed) == test::ReadFile(uncompressed));
+  }
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Parallel partitioning of the root partition", "[cas::BulkLoader]") {
+  auto dir = test::Directory("parallel_partitioning");
+  // long paths, the root partition (1400 pages) does not fit into the
+  // work pool (1100 pages), i.e., AllOrNothing uses no memory pages
+  std::vector<test::Input> inputs;
+  for (size_t i = 0; i < 50'000; ++i) {
+    inputs.push_back({
+        "/d" + std::to_string(i % 13) + "/" + std::string(400, 'p')
+          + "/f" + std::to_string(i / 7) + ".c",
+        static_cast<cas::vint64_t>(i % 53) - 20,
+        i});
+  }
+  cas::Context context;
+  context.mem_size_bytes_ = (5 * cas::MemoryPools::SliceSize() + 64) * cas::PAGE_SZ;
+
+  auto check = [&](const std::string& name, bool use_memory_pages) {
+    context.nr_threads_ = 1;
+    context.parallel_partitioning_ = false;
+    auto sequential = PartitionRoot(context, dir, name + "_sequential", inputs);
+    context.nr_threads_ = 4;
+    context.parallel_partitioning_ = true;
+    auto parallel = PartitionRoot(context, dir, name + "_parallel", inputs);
+
+    REQUIRE(sequential.children_.size() > 1);
+    REQUIRE(parallel.children_ == sequential.children_);
+    size_t nr_keys = 0;
+    for (const auto& [b, child] : parallel.children_) {
+      REQUIRE(child.keys_.size() == child.nr_keys_);
+      nr_keys += child.nr_keys_;
+    }
+    REQUIRE(nr_keys == inputs.size());
+    REQUIRE((sequential.nr_memory_pages_ > 0) == use_memory_pages);
+    REQUIRE((parallel.nr_memory_pages_ > 0) == use_memory_pages);
+    REQUIRE(parallel.nr_disk_pages_ > 0);
+  };
+
+  SECTION("With memory pages") {
+    context.memory_placement_ = cas::MemoryPlacement::FrontLoading;
+    check("memory", true);
+  }
+
+  SECTION("Without memory pages") {
+    // the workers append to the partition files concurrently
+    context.memory_placement_ = cas::MemoryPlacement::AllOrNothing;
+    check("disk", false);
+  }
+
+  SECTION("Without memory pages, compressed") {
+    context.memory_placement_ = cas::MemoryPlacement::AllOrNothing;
+    for (auto compression : {cas::Compression::Lz4, cas::Compression::Zstd}) {
+      if (!cas::IsSupported(compression)) {
+        WARN("compression " << cas::ToString(compression) << " is not supported");
+        continue;
+      }
+      context.partition_compression_ = compression;
+      check(cas::ToString(compression), false);
+    }
+  }
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,62 @@
+#include "test/catch.hpp"
+#include "cas/common_prefix.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+size_t NaiveCommonPrefix(const std::byte* a, const std::byte* b, size_t len) {
+  size_t i = 0;
+  while (i < len && a[i] == b[i]) {
+    ++i;
+  }
+  return i;
+}
+
+} // namespace
+
+
+TEST_CASE("Common prefix kernels", "[cas::CommonPrefix]") {
+  std::mt19937 rng{42};
+  std::uniform_int_distribution<int> byte{0x00, 0xFF};
+  std::uniform_int_distribution<int> flip{0x01, 0xFF};
+
+  for (auto kernel : {cas::PrefixKernel::Scalar,
+                      cas::PrefixKernel::Sse2,
+                      cas::PrefixKernel::Avx2}) {
+    if (!cas::IsSupported(kernel)) {
+      WARN("prefix kernel " << cas::ToString(kernel) << " is not supported");
+      continue;
+    }
+    for (size_t len = 0; len <= 80; ++len) {
+      // the buffers are exactly len bytes long, the kernels must
+      // not read past them
+      for (size_t mismatch = 0; mismatch <= len; ++mismatch) {
+        std::vector<std::byte> a(len);
+        for (auto& b : a) {
+          b = static_cast<std::byte>(byte(rng));
+        }
+        std::vector<std::byte> b = a;
+        if (mismatch < len) {
+          b[mismatch] ^= static_cast<std::byte>(flip(rng));
+          // bytes after the mismatch do not matter
+          for (size_t i = mismatch + 1; i < len; ++i) {
+            b[i] = static_cast<std::byte>(byte(rng));
+          }
+        }
+        size_t expected = NaiveCommonPrefix(a.data(), b.data(), len);
+        REQUIRE(expected == mismatch);
+        REQUIRE(cas::CommonPrefix(kernel, a.data(), b.data(), len) == expected);
+        REQUIRE(cas::CommonPrefix(a.data(), b.data(), len) == expected);
+        // a shorter len cuts the prefix off
+        if (len > 0) {
+          REQUIRE(cas::CommonPrefix(kernel, a.data(), b.data(), len - 1)
+              == std::min(expected, len - 1));
+        }
+      }
+    }
+  }
+}
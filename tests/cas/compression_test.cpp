@@ -0,0 +1,75 @@
+#include "test/catch.hpp"
+#include "cas/compression.hpp"
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+namespace {
+
+// text-like bytes that compress well
+std::vector<std::byte> Compressible(size_t len) {
+  std::vector<std::byte> data(len);
+  const char* words[] = {"/drivers/", "net/", "binder", ".c", "/usr/", "lib"};
+  for (size_t i = 0, w = 0; i < len; ++w) {
+    for (const char* c = words[(w * 7) % 6]; *c != '\0' && i < len; ++c, ++i) {
+      data[i] = static_cast<std::byte>(*c);
+    }
+  }
+  return data;
+}
+
+std::vector<std::byte> Random(size_t len) {
+  std::mt19937 rng{7};
+  std::uniform_int_distribution<int> byte{0x00, 0xFF};
+  std::vector<std::byte> data(len);
+  for (auto& b : data) {
+    b = static_cast<std::byte>(byte(rng));
+  }
+  return data;
+}
+
+} // namespace
+
+
+TEST_CASE("Compress and decompress", "[cas::Compression]") {
+  for (auto compression : {cas::Compression::None,
+                           cas::Compression::Lz4,
+                           cas::Compression::Zstd}) {
+    if (!cas::IsSupported(compression)) {
+      WARN("compression " << cas::ToString(compression) << " is not supported");
+      std::vector<std::byte> src(16);
+      std::vector<std::byte> dst(64);
+      REQUIRE_THROWS_AS(cas::CompressBound(compression, src.size()), std::runtime_error);
+      REQUIRE_THROWS_AS(cas::Compress(compression,
+            src.data(), src.size(), dst.data(), dst.size()), std::runtime_error);
+      continue;
+    }
+    for (size_t len : {1, 100, 4096, 65536}) {
+      for (const auto& src : {Compressible(len), Random(len)}) {
+        std::vector<std::byte> compressed(cas::CompressBound(compression, len));
+        size_t size = cas::Compress(compression,
+            src.data(), src.size(), compressed.data(), compressed.size());
+        REQUIRE(size <= compressed.size());
+
+        std::vector<std::byte> decompressed(len);
+        REQUIRE(cas::Decompress(compression, compressed.data(), size,
+              decompressed.data(), decompressed.size()) == len);
+        REQUIRE(decompressed == src);
+
+        if (len > 1) {
+          std::vector<std::byte> too_small(len / 2);
+          REQUIRE_THROWS_AS(cas::Decompress(compression, compressed.data(), size,
+                too_small.data(), too_small.size()), std::runtime_error);
+        }
+      }
+      if (compression != cas::Compression::None && len >= 4096) {
+        auto src = Compressible(len);
+        std::vector<std::byte> compressed(cas::CompressBound(compression, len));
+        REQUIRE(cas::Compress(compression, src.data(), src.size(),
+              compressed.data(), compressed.size()) < len / 2);
+      }
+    }
+  }
+}
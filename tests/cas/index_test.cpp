@@ -0,0 +1,94 @@
+#include "test/catch.hpp"
+#include "index_builder.hpp"
+#include "cas/index.hpp"
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+std::vector<test::Input> Inputs(size_t begin, size_t end) {
+  std::vector<test::Input> inputs;
+  for (size_t i = begin; i < end; ++i) {
+    inputs.push_back({
+        "/d" + std::to_string(i % 11) + "/s" + std::to_string(i % 97)
+          + "/f" + std::to_string(i / 5) + ".c",
+        static_cast<cas::vint64_t>(i % 61) - 30,
+        i});
+  }
+  return inputs;
+}
+
+
+std::vector<cas::BinarySK> SearchKeys() {
+  std::vector<cas::BinarySK> keys;
+  for (const auto& path : {"/**", "/d3/**", "/d1*/**", "/d*/s7/*", "/**/f1*.c"}) {
+    // the second range covers exactly all values of the keys
+    keys.push_back(test::SearchKey(path, cas::VINT64_MIN, cas::VINT64_MAX));
+    keys.push_back(test::SearchKey(path, -30, 30));
+    keys.push_back(test::SearchKey(path, -5, 3));
+    keys.push_back(test::SearchKey(path, 0, 0));
+    keys.push_back(test::SearchKey(path, 100, 200));
+  }
+  return keys;
+}
+
+} // namespace
+
+
+TEST_CASE("Count matches the number of query results", "[cas::Index]") {
+  auto dir = test::Directory("count");
+  auto disk_inputs = Inputs(0, 20'000);
+  auto memory_inputs = Inputs(20'000, 21'000);
+  auto keys = SearchKeys();
+
+  std::vector<size_t> expected;
+  std::map<size_t, size_t> read_nodes_without_stats;
+  for (bool subtree_stats : {false, true}) {
+    for (size_t nr_threads : {1, 4}) {
+      std::string name = "stats" + std::to_string(subtree_stats)
+        + "_threads" + std::to_string(nr_threads);
+      cas::Context context;
+      context.mem_size_bytes_ = 2048 * cas::PAGE_SZ;
+      context.subtree_stats_ = subtree_stats;
+      context.nr_threads_ = nr_threads;
+      auto index_file = test::BuildIndex(context, dir, name, disk_inputs);
+      context.pipeline_dir_ = dir + name + "_pipeline/";
+      std::filesystem::create_directories(context.pipeline_dir_);
+      std::filesystem::rename(index_file, context.pipeline_dir_ + "index.bin0");
+
+      cas::Index<cas::vint64_t> index{context};
+      cas::QueryBuffer buffer;
+      for (const auto& input : memory_inputs) {
+        cas::BinaryKey bkey{&buffer.at(0)};
+        test::EncodeKey(input, bkey);
+        index.Insert(bkey);
+      }
+
+      for (size_t i = 0; i < keys.size(); ++i) {
+        auto query = index.Query(keys[i], cas::kNullEmitter);
+        auto count = index.Count(keys[i]);
+        REQUIRE(count.nr_matches_ == query.nr_matches_);
+        REQUIRE(count.read_nodes_ <= query.read_nodes_);
+        if (expected.size() == i) {
+          expected.push_back(query.nr_matches_);
+        }
+        REQUIRE(query.nr_matches_ == expected[i]);
+      }
+
+      // with statistics, /** over all values skips the subtrees of the
+      // index file (in-memory nodes have no statistics)
+      auto all = index.Count(keys[0]);
+      REQUIRE(all.nr_matches_ == disk_inputs.size() + memory_inputs.size());
+      if (subtree_stats) {
+        REQUIRE(all.read_nodes_ < read_nodes_without_stats[nr_threads]);
+      } else {
+        read_nodes_without_stats[nr_threads] = all.read_nodes_;
+      }
+    }
+  }
+  REQUIRE(expected[4] == 0);
+  std::filesystem::remove_all(dir);
+}
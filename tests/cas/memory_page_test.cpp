@@ -0,0 +1,181 @@
+#include "test/catch.hpp"
+#include "cas/key_encoder.hpp"
+#include "cas/memory_page.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+// encoded keys with shared path and value prefixes and distinct refs
+std::vector<std::vector<std::byte>> EncodeKeys(size_t nr_keys) {
+  std::vector<std::vector<std::byte>> keys;
+  cas::QueryBuffer buffer;
+  for (size_t i = 0; i < nr_keys; ++i) {
+    cas::ref_t ref;
+    std::memset(&ref, static_cast<int>(i % 256), sizeof(cas::ref_t));
+    std::string path = "/drivers/net/file" + std::to_string(i / 3) + ".c";
+    cas::vint64_t value = 1'600'000'000 + static_cast<cas::vint64_t>(i / 2);
+    cas::Key<cas::vint64_t> key{path, value, ref};
+    cas::BinaryKey bkey{&buffer.at(0)};
+    cas::KeyEncoder<cas::vint64_t>::Encode(key, bkey);
+    keys.emplace_back(bkey.Begin(), bkey.Begin() + bkey.ByteSize());
+  }
+  return keys;
+}
+
+// true if the key has the same path, value, and ref as the encoded key
+bool Equals(const cas::BinaryKey& key, std::vector<std::byte>& encoded) {
+  cas::BinaryKey expected{encoded.data()};
+  return key.LenPath() == expected.LenPath()
+    && key.LenValue() == expected.LenValue()
+    && std::memcmp(key.Path(), expected.Path(), key.LenPath()) == 0
+    && std::memcmp(key.Value(), expected.Value(), key.LenValue()) == 0
+    && std::memcmp(&key.Ref(), &expected.Ref(), sizeof(cas::ref_t)) == 0;
+}
+
+// pushes keys until the page is full, returns the number of pushed keys
+size_t Fill(cas::MemoryPage& page,
+    std::vector<std::vector<std::byte>>& keys) {
+  size_t nr_pushed = 0;
+  for (auto& encoded : keys) {
+    cas::BinaryKey bkey{encoded.data()};
+    if (!page.Fits(bkey)) {
+      break;
+    }
+    page.Push(bkey);
+    ++nr_pushed;
+  }
+  return nr_pushed;
+}
+
+} // namespace
+
+
+TEST_CASE("Pushing and iterating keys", "[cas::MemoryPage]") {
+  auto keys = EncodeKeys(2000);
+  std::vector<std::byte> buffer(cas::PAGE_SZ);
+
+  auto round_trip = [&](cas::PageFormat format) {
+    cas::MemoryPage page{buffer.data()};
+    page.Reset(format);
+    REQUIRE(page.Format() == format);
+    size_t nr_pushed = Fill(page, keys);
+    REQUIRE(nr_pushed > 0);
+    REQUIRE(nr_pushed < keys.size());
+    REQUIRE(page.NrKeys() == nr_pushed);
+    size_t i = 0;
+    for (const auto& bkey : page) {
+      REQUIRE(i < nr_pushed);
+      REQUIRE(Equals(bkey, keys[i]));
+      ++i;
+    }
+    REQUIRE(i == nr_pushed);
+    return nr_pushed;
+  };
+
+  SECTION("Plain") {
+    round_trip(cas::PageFormat::Plain);
+  }
+
+  SECTION("Front-coded") {
+    size_t nr_front_coded = round_trip(cas::PageFormat::FrontCoded);
+    // the keys share long prefixes
+    REQUIRE(nr_front_coded > round_trip(cas::PageFormat::Plain));
+  }
+
+  SECTION("Front-coded iterator copies") {
+    cas::MemoryPage page{buffer.data()};
+    page.Reset(cas::PageFormat::FrontCoded);
+    REQUIRE(Fill(page, keys) > 2);
+    auto it = page.begin();
+    REQUIRE(Equals(*it, keys[0]));
+    {
+      // copies share the decode buffer, it stays valid for the
+      // remaining iterators when a copy is destroyed
+      auto copy = it;
+      REQUIRE((copy == it));
+      ++copy;
+      REQUIRE((copy != it));
+      REQUIRE(Equals(*copy, keys[1]));
+    }
+    ++it;
+    REQUIRE(Equals(*it, keys[1]));
+    ++it;
+    REQUIRE(Equals(*it, keys[2]));
+  }
+
+  SECTION("Nested front-coded iterators") {
+    // two iterators of a thread are alive at the same time, each
+    // one needs its own decode buffer
+    std::vector<std::byte> other_buffer(cas::PAGE_SZ);
+    auto other_keys = EncodeKeys(4000);
+    other_keys.erase(other_keys.begin(), other_keys.begin() + 2000);
+    cas::MemoryPage page{buffer.data()};
+    cas::MemoryPage other_page{other_buffer.data()};
+    page.Reset(cas::PageFormat::FrontCoded);
+    other_page.Reset(cas::PageFormat::FrontCoded);
+    size_t nr_pushed = std::min(Fill(page, keys), Fill(other_page, other_keys));
+    for (int round = 0; round < 2; ++round) {
+      auto it = page.begin();
+      auto other_it = other_page.begin();
+      for (size_t i = 0; i < nr_pushed; ++i, ++it, ++other_it) {
+        REQUIRE(Equals(*it, keys[i]));
+        REQUIRE(Equals(*other_it, other_keys[i]));
+      }
+    }
+  }
+
+  SECTION("Reset keeps the format") {
+    cas::MemoryPage page{buffer.data()};
+    page.Reset(cas::PageFormat::FrontCoded);
+    size_t nr_pushed = Fill(page, keys);
+    page.Reset();
+    REQUIRE(page.Format() == cas::PageFormat::FrontCoded);
+    REQUIRE(page.NrKeys() == 0);
+    REQUIRE((page.begin() == page.end()));
+    // the keys are front-coded again from the first one on
+    REQUIRE(Fill(page, keys) == nr_pushed);
+    size_t i = 0;
+    for (const auto& bkey : page) {
+      REQUIRE(Equals(bkey, keys[i++]));
+    }
+    REQUIRE(i == nr_pushed);
+
+    page.Reset(cas::PageFormat::Plain);
+    REQUIRE(page.Format() == cas::PageFormat::Plain);
+    REQUIRE(page.NrKeys() == 0);
+  }
+}
+
+
+TEST_CASE("Key count limit of large pages", "[cas::MemoryPage]") {
+  // the key count has 15 bits, the highest bit flags front coding
+  const size_t max_nr_keys = (1u << 15) - 1;
+  std::vector<std::byte> buffer(cas::PAGE_SZ_1MB);
+  cas::MemoryPage page{buffer.data(), cas::PAGE_SZ_1MB};
+  page.Reset(cas::PageFormat::FrontCoded);
+
+  // the same tiny key over and over, front-coded without any suffix
+  auto keys = EncodeKeys(1);
+  cas::BinaryKey bkey{keys[0].data()};
+  size_t nr_pushed = 0;
+  while (page.Fits(bkey)) {
+    page.Push(bkey);
+    ++nr_pushed;
+  }
+  REQUIRE(nr_pushed == max_nr_keys);
+  REQUIRE(page.NrKeys() == max_nr_keys);
+  REQUIRE(page.Format() == cas::PageFormat::FrontCoded);
+  // the page is not full, the key count stopped it
+  REQUIRE(page.EncodedSize(bkey) <= page.FreeSpace());
+
+  size_t nr_keys = 0;
+  for (const auto& key : page) {
+    REQUIRE(Equals(key, keys[0]));
+    ++nr_keys;
+  }
+  REQUIRE(nr_keys == max_nr_keys);
+}
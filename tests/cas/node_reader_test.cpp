@@ -0,0 +1,590 @@
+#include "test/catch.hpp"
+#include "index_builder.hpp"
+#include "cas/compression.hpp"
+#include "cas/index_layout.hpp"
+#include "cas/node_reader.hpp"
+#include "cas/util.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+// the paths of the keys branch on all printable bytes after /x
+std::vector<test::Input> WideInputs() {
+  std::vector<test::Input> inputs;
+  size_t ref = 0;
+  for (int b = 0x21; b < 0x7F; ++b) {
+    for (int i = 0; i < 40; ++i) {
+      inputs.push_back({
+          "/x" + std::string(1, static_cast<char>(b)) + "/f" + std::to_string(i % 7),
+          i % 3,
+          ref++});
+    }
+  }
+  return inputs;
+}
+
+
+// large leaves of keys that only differ in their refs, the refs repeat,
+// and a few small leaves
+std::vector<test::Input> RefInputs() {
+  std::vector<test::Input> inputs;
+  for (size_t i = 0; i < 6000; ++i) {
+    inputs.push_back({"/r/" + std::to_string(i % 6) + "/f",
+        static_cast<cas::vint64_t>(i % 4), i % 300});
+  }
+  for (size_t i = 0; i < 100; ++i) {
+    inputs.push_back({"/u/f" + std::to_string(i), 7, i});
+  }
+  return inputs;
+}
+
+
+size_t ReadPointer(const std::vector<uint8_t>& data, size_t pos) {
+  size_t ptr = 0;
+  for (size_t i = 0; i < 6; ++i) {
+    ptr = (ptr << 8) | data[pos + i];
+  }
+  return ptr;
+}
+
+
+// (byte, child path) of the visited children
+using Children = std::vector<std::pair<uint8_t, const uint8_t*>>;
+
+Children ChildrenInRange(const cas::NodeReader& node, uint8_t low, uint8_t high) {
+  Children children;
+  node.ForEachChildInRange(low, high, [&](uint8_t byte, cas::INode* child) {
+    children.emplace_back(byte, child->Path());
+  });
+  return children;
+}
+
+Children FilteredChildren(const cas::NodeReader& node, uint8_t low, uint8_t high) {
+  Children children;
+  node.ForEachChild([&](uint8_t byte, cas::INode* child) {
+    if (low <= byte && byte <= high) {
+      children.emplace_back(byte, child->Path());
+    }
+  });
+  return children;
+}
+
+
+// ranges and point lookups visit the same children as a filtered scan
+void CheckRanges(const cas::NodeReader& node) {
+  // the bounds of the ranges are the child bytes, their successors,
+  // and the extremes
+  std::vector<uint8_t> bounds{0x00, 0xFF};
+  node.ForEachChild([&](uint8_t byte, cas::INode* /* child */) {
+    bounds.push_back(byte);
+    bounds.push_back(static_cast<uint8_t>(byte + 1));
+  });
+  for (uint8_t low : bounds) {
+    for (uint8_t high : bounds) {
+      REQUIRE(ChildrenInRange(node, low, high) == FilteredChildren(node, low, high));
+    }
+  }
+  for (int byte = 0x00; byte <= 0xFF; ++byte) {
+    auto b = static_cast<uint8_t>(byte);
+    Children children;
+    bool found = node.LookupChild(b, [&](uint8_t child_byte, cas::INode* child) {
+      children.emplace_back(child_byte, child->Path());
+    });
+    REQUIRE(children == FilteredChildren(node, b, b));
+    REQUIRE(found == !children.empty());
+  }
+}
+
+
+// compares the nodes at pos of both indexes and descends into their children
+void Compare(const std::vector<uint8_t>& interleaved,
+    const std::vector<uint8_t>& key_array, size_t pos, size_t& max_nr_children) {
+  cas::NodeReader i_node{interleaved.data(), pos};
+  cas::NodeReader k_node{key_array.data(), pos};
+  REQUIRE(i_node.Dimension() == k_node.Dimension());
+  REQUIRE(i_node.NrChildren() == k_node.NrChildren());
+  REQUIRE(i_node.ByteSize() == k_node.ByteSize());
+  if (i_node.IsLeaf()) {
+    REQUIRE(std::equal(&interleaved[pos], &interleaved[pos] + i_node.ByteSize(),
+          &key_array[pos]));
+    return;
+  }
+  REQUIRE(!i_node.HasKeyArray());
+  REQUIRE(k_node.HasKeyArray());
+  max_nr_children = std::max(max_nr_children, k_node.NrChildren());
+
+  size_t n = k_node.NrChildren();
+  for (size_t c = 0; c < n; ++c) {
+    // b:1, ptr:6 records vs. n bytes followed by n pointers
+    REQUIRE(i_node.ChildBytePos(c) == i_node.ChildBytePos(0) + 7 * c);
+    REQUIRE(i_node.ChildPointerPos(c) == i_node.ChildBytePos(c) + 1);
+    REQUIRE(k_node.ChildBytePos(c) == k_node.ChildBytePos(0) + c);
+    REQUIRE(k_node.ChildPointerPos(c) == k_node.ChildBytePos(0) + n + 6 * c);
+
+    uint8_t byte = key_array[pos + k_node.ChildBytePos(c)];
+    size_t ptr = ReadPointer(key_array, pos + k_node.ChildPointerPos(c));
+    REQUIRE(interleaved[pos + i_node.ChildBytePos(c)] == byte);
+    REQUIRE(ReadPointer(interleaved, pos + i_node.ChildPointerPos(c)) == ptr);
+    if (c > 0) {
+      REQUIRE(key_array[pos + k_node.ChildBytePos(c - 1)] < byte);
+    }
+  }
+
+  Children i_children = ChildrenInRange(i_node, 0x00, 0xFF);
+  Children k_children = ChildrenInRange(k_node, 0x00, 0xFF);
+  REQUIRE(k_children.size() == n);
+  for (size_t c = 0; c < n; ++c) {
+    size_t ptr = ReadPointer(key_array, pos + k_node.ChildPointerPos(c));
+    REQUIRE(k_children[c].first == key_array[pos + k_node.ChildBytePos(c)]);
+    REQUIRE(k_children[c].second == cas::NodeReader{key_array.data(), ptr}.Path());
+    REQUIRE(i_children[c].first == k_children[c].first);
+  }
+  CheckRanges(i_node);
+  CheckRanges(k_node);
+
+  for (size_t c = 0; c < n; ++c) {
+    Compare(interleaved, key_array,
+        ReadPointer(key_array, pos + k_node.ChildPointerPos(c)), max_nr_children);
+  }
+}
+
+
+// compares the nodes of an index with absolute and one with relative
+// pointers and counts the pointer widths of the latter
+void CompareRelative(const std::vector<uint8_t>& absolute, size_t a_pos,
+    const std::vector<uint8_t>& relative, size_t r_pos,
+    std::map<size_t, size_t>& widths) {
+  cas::NodeReader a_node{absolute.data(), a_pos};
+  cas::NodeReader r_node{relative.data(), r_pos};
+  REQUIRE(a_node.Dimension() == r_node.Dimension());
+  REQUIRE(a_node.NrChildren() == r_node.NrChildren());
+  REQUIRE(std::equal(a_node.Path(), a_node.Path() + a_node.LenPath() + a_node.LenValue(),
+        r_node.Path(), r_node.Path() + r_node.LenPath() + r_node.LenValue()));
+  REQUIRE(!a_node.HasRelativePointers());
+  if (a_node.IsLeaf()) {
+    REQUIRE(std::equal(&absolute[a_pos], &absolute[a_pos] + a_node.ByteSize(),
+          &relative[r_pos], &relative[r_pos] + r_node.ByteSize()));
+    return;
+  }
+  REQUIRE(a_node.PointerWidth() == 6);
+  REQUIRE(r_node.HasRelativePointers());
+  size_t width = r_node.PointerWidth();
+  ++widths[width];
+  size_t n = r_node.NrChildren();
+  REQUIRE(r_node.ByteSize() == r_node.PayloadPos()
+      + r_node.LenPath() + r_node.LenValue() + (1 + width) * n);
+  for (size_t c = 0; c < n; ++c) {
+    REQUIRE(r_node.ChildByte(c) == a_node.ChildByte(c));
+    // big-endian distance from the node to the child
+    size_t delta = 0;
+    for (size_t i = 0; i < width; ++i) {
+      delta = (delta << 8) | relative[r_pos + r_node.ChildPointerPos(c) + i];
+    }
+    REQUIRE(delta > 0);
+    REQUIRE(r_node.Child(c).Path() == cas::NodeReader{relative.data(), r_pos + delta}.Path());
+    CompareRelative(absolute, ReadPointer(absolute, a_pos + a_node.ChildPointerPos(c)),
+        relative, r_pos + delta, widths);
+  }
+  CheckRanges(r_node);
+}
+
+
+struct Walk {
+  size_t nr_bytes_ = 0;
+  size_t nr_suffixes_ = 0;
+  size_t nr_raw_leaves_ = 0;
+  size_t nr_compressed_leaves_ = 0;
+};
+
+// visits all nodes of an index file with the given layout
+void WalkNodes(const cas::NodeReader& node, const cas::IndexLayout& layout,
+    size_t threshold, Walk& walk) {
+  walk.nr_bytes_ += node.ByteSize();
+  if (!node.IsLeaf()) {
+    node.ForEachChild([&](uint8_t /* byte */, cas::INode* child) {
+      WalkNodes(*static_cast<cas::NodeReader*>(child), layout, threshold, walk);
+    });
+    return;
+  }
+  if (layout.leaf_compression_ != cas::Compression::None) {
+    const uint8_t* marker = node.Path() + node.LenPath() + node.LenValue();
+    REQUIRE((*marker == cas::IndexLayout::LEAF_RAW
+          || *marker == cas::IndexLayout::LEAF_COMPRESSED));
+    REQUIRE(node.IsCompressed() == (*marker == cas::IndexLayout::LEAF_COMPRESSED));
+    if (node.IsCompressed()) {
+      std::vector<uint8_t> suffixes;
+      cas::DecompressLeaf(layout.leaf_compression_, marker, suffixes);
+      REQUIRE(suffixes.size() >= threshold);
+      ++walk.nr_compressed_leaves_;
+    } else {
+      ++walk.nr_raw_leaves_;
+    }
+  } else {
+    REQUIRE(!node.IsCompressed());
+  }
+  node.ForEachSuffix([&](
+        uint8_t /* len_p */, const uint8_t* /* path */,
+        uint8_t /* len_v */, const uint8_t* /* value */,
+        cas::ref_t /* ref */) {
+    ++walk.nr_suffixes_;
+  });
+}
+
+
+// dimension, len path, len value, nr children/suffixes
+using Shape = std::tuple<int, size_t, size_t, size_t>;
+
+// the keys and nodes of an index in depth-first order
+struct Contents {
+  std::vector<test::Entry> entries_;
+  std::vector<Shape> shapes_;
+  size_t max_len_path_ = 0;
+  size_t max_len_value_ = 0;
+  size_t max_nr_suffixes_ = 0;
+};
+
+void Collect(const cas::NodeReader& node, std::string path, std::string value,
+    Contents& contents) {
+  contents.shapes_.emplace_back(static_cast<int>(node.Dimension()),
+      node.LenPath(), node.LenValue(), node.NrEntries());
+  contents.max_len_path_ = std::max(contents.max_len_path_, node.LenPath());
+  contents.max_len_value_ = std::max(contents.max_len_value_, node.LenValue());
+  contents.max_nr_suffixes_ = std::max(contents.max_nr_suffixes_, node.NrSuffixes());
+  path.append(reinterpret_cast<const char*>(node.Path()), node.LenPath());
+  value.append(reinterpret_cast<const char*>(node.Value()), node.LenValue());
+  if (node.IsLeaf()) {
+    node.VisitSuffixes([&](size_t len_p, const uint8_t* p,
+          size_t len_v, const uint8_t* v, cas::ref_t ref) {
+      contents.entries_.emplace_back(
+          path + std::string(reinterpret_cast<const char*>(p), len_p),
+          value + std::string(reinterpret_cast<const char*>(v), len_v),
+          std::string(reinterpret_cast<const char*>(&ref), sizeof(cas::ref_t)));
+    });
+    return;
+  }
+  node.VisitChildrenInRange(0x00, 0xFF, [&](uint8_t byte, cas::NodeReader& child) {
+    char b = static_cast<char>(byte);
+    if (node.Dimension() == cas::Dimension::PATH) {
+      Collect(child, path + b, value, contents);
+    } else {
+      Collect(child, path, value + b, contents);
+    }
+  });
+}
+
+// bulk-loads the keys and reads the index back with NodeReader
+Contents Load(const std::vector<test::StringInput>& inputs, bool varint_headers) {
+  auto dir = test::Directory("varint_headers");
+  cas::Context context;
+  context.mem_size_bytes_ = 1024 * cas::PAGE_SZ;
+  context.varint_headers_ = varint_headers;
+  auto data = test::ReadFile(test::BuildIndex(context, dir, "index", inputs));
+  auto layout = cas::IndexLayout::Read(data.data(), data.size());
+  REQUIRE(layout.varint_headers_ == varint_headers);
+  Contents contents;
+  Collect(cas::NodeReader{data.data(), 0, &layout}, "", "", contents);
+  std::filesystem::remove_all(dir);
+  return contents;
+}
+
+// the varint index holds exactly the input keys and equals the legacy
+// index if the legacy format can hold the keys
+Contents RoundTrip(const std::vector<test::StringInput>& inputs, bool legacy_holds) {
+  auto contents = Load(inputs, true);
+  auto entries = contents.entries_;
+  std::sort(entries.begin(), entries.end());
+  REQUIRE(entries == test::Encode(inputs));
+  if (legacy_holds) {
+    auto legacy = Load(inputs, false);
+    REQUIRE(legacy.entries_ == contents.entries_);
+    REQUIRE(legacy.shapes_ == contents.shapes_);
+  } else {
+    REQUIRE_THROWS_AS(Load(inputs, false), std::runtime_error);
+  }
+  return contents;
+}
+
+} // namespace
+
+
+TEST_CASE("Key-array node format", "[cas::NodeReader]") {
+  REQUIRE(cas::NodeReader::FormatFlag(cas::NodeFormat::Interleaved) == 0);
+  REQUIRE(cas::NodeReader::FormatFlag(cas::NodeFormat::KeyArray) != 0);
+
+  auto dir = test::Directory("key_array");
+  auto inputs = WideInputs();
+  cas::Context context;
+  context.mem_size_bytes_ = 1024 * cas::PAGE_SZ;
+  context.node_format_ = cas::NodeFormat::Interleaved;
+  auto interleaved = test::BuildIndex(context, dir, "interleaved", inputs);
+  context.node_format_ = cas::NodeFormat::KeyArray;
+  auto key_array = test::BuildIndex(context, dir, "key_array", inputs);
+
+  // both formats need 7 bytes per child, the nodes keep their offsets
+  auto interleaved_data = test::ReadFile(interleaved);
+  auto key_array_data = test::ReadFile(key_array);
+  REQUIRE(interleaved_data.size() == key_array_data.size());
+  size_t max_nr_children = 0;
+  Compare(interleaved_data, key_array_data, 0, max_nr_children);
+  REQUIRE(max_nr_children >= 0x7F - 0x21);
+
+  for (const auto& key : {
+      test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX),
+      test::SearchKey("/xa/*", cas::VINT64_MIN, cas::VINT64_MAX),
+      test::SearchKey("/x*/f3", 1, 2)}) {
+    auto matches = test::Query(interleaved, key);
+    REQUIRE(!matches.empty());
+    REQUIRE(test::Query(key_array, key) == matches);
+  }
+  REQUIRE(test::Query(key_array, test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX))
+      == test::Encode(inputs));
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Ref dictionary and compressed leaves", "[cas::NodeReader]") {
+  auto dir = test::Directory("index_layout");
+  auto inputs = RefInputs();
+  auto expected = test::Encode(inputs);
+  auto all = test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX);
+  cas::Context context;
+  context.mem_size_bytes_ = 1024 * cas::PAGE_SZ;
+  context.leaf_compression_threshold_ = 64;
+  // the keys under /u end up in leaves of single keys below the threshold
+  context.partitioning_threshold_ = 1;
+
+  // files without these features only contain nodes
+  auto plain = test::ReadFile(test::BuildIndex(context, dir, "plain", inputs));
+  auto plain_layout = cas::IndexLayout::Read(plain.data(), plain.size());
+  REQUIRE(!plain_layout.HasTrailer());
+  REQUIRE(plain_layout.nodes_end_ == plain.size());
+
+  std::vector<uint8_t> last;
+  for (bool ref_dictionary : {false, true}) {
+    for (auto compression : {cas::Compression::None,
+                             cas::Compression::Lz4,
+                             cas::Compression::Zstd}) {
+      if (!ref_dictionary && compression == cas::Compression::None) {
+        continue;
+      }
+      if (!cas::IsSupported(compression)) {
+        WARN("compression " << cas::ToString(compression) << " is not supported");
+        continue;
+      }
+      context.ref_dictionary_ = ref_dictionary;
+      context.leaf_compression_ = compression;
+      std::string name = "refs" + std::to_string(ref_dictionary)
+        + "_" + cas::ToString(compression);
+      auto index_file = test::BuildIndex(context, dir, name, inputs);
+      auto data = test::ReadFile(index_file);
+      auto layout = cas::IndexLayout::Read(data.data(), data.size());
+      REQUIRE(layout.HasTrailer());
+      REQUIRE(layout.ref_ids_ == ref_dictionary);
+      REQUIRE(layout.leaf_compression_ == compression);
+      REQUIRE(layout.nodes_end_ + layout.nr_refs_ * sizeof(cas::ref_t)
+          + cas::IndexLayout::TRAILER_SZ == data.size());
+      std::vector<uint8_t> trailer(cas::IndexLayout::TRAILER_SZ);
+      layout.WriteTrailer(trailer.data());
+      REQUIRE(std::equal(trailer.begin(), trailer.end(),
+            data.end() - cas::IndexLayout::TRAILER_SZ));
+
+      if (ref_dictionary) {
+        // every distinct ref once, ids > 127 take two varint bytes
+        std::set<std::string> refs;
+        for (size_t id = 0; id < layout.nr_refs_; ++id) {
+          cas::ref_t ref = layout.Ref(id);
+          refs.emplace(reinterpret_cast<const char*>(&ref), sizeof(cas::ref_t));
+        }
+        REQUIRE(layout.nr_refs_ == 300);
+        REQUIRE(refs.size() == layout.nr_refs_);
+        REQUIRE(refs.count(test::RefBytes(299)) == 1);
+      } else {
+        REQUIRE(layout.nr_refs_ == 0);
+      }
+
+      Walk walk;
+      WalkNodes(cas::NodeReader{data.data(), 0, &layout}, layout,
+          context.leaf_compression_threshold_, walk);
+      REQUIRE(walk.nr_bytes_ == layout.nodes_end_);
+      REQUIRE(walk.nr_suffixes_ == inputs.size());
+      if (compression != cas::Compression::None) {
+        REQUIRE(walk.nr_compressed_leaves_ > 0);
+        REQUIRE(walk.nr_raw_leaves_ > 0);
+      }
+      REQUIRE(test::Query(index_file, all) == expected);
+      last = data;
+    }
+  }
+
+  // a trailer whose offsets do not add up is rejected, a file without
+  // magic is read as nodes only
+  auto corrupt = last;
+  corrupt[corrupt.size() - cas::IndexLayout::TRAILER_SZ] ^= 0x01;
+  REQUIRE_THROWS_AS(cas::IndexLayout::Read(corrupt.data(), corrupt.size()),
+      std::runtime_error);
+  corrupt = last;
+  corrupt.back() ^= 0x01;
+  REQUIRE(!cas::IndexLayout::Read(corrupt.data(), corrupt.size()).HasTrailer());
+
+  // files with leaves of an unsupported codec are rejected
+  for (auto compression : {cas::Compression::Lz4, cas::Compression::Zstd}) {
+    cas::IndexLayout layout;
+    layout.leaf_compression_ = compression;
+    std::vector<uint8_t> file(cas::IndexLayout::TRAILER_SZ);
+    layout.WriteTrailer(file.data());
+    if (cas::IsSupported(compression)) {
+      auto read = cas::IndexLayout::Read(file.data(), file.size());
+      REQUIRE(read.leaf_compression_ == compression);
+      REQUIRE(read.nodes_end_ == 0);
+    } else {
+      REQUIRE_THROWS_AS(cas::IndexLayout::Read(file.data(), file.size()),
+          std::runtime_error);
+    }
+  }
+  std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Relative child pointers", "[cas::NodeReader]") {
+  // the width takes two bits of the child count, next to the other flags
+  REQUIRE(cas::NodeReader::PointerWidthFlag(6) == 0);
+  std::vector<uint32_t> flags{
+    cas::NodeReader::FormatFlag(cas::NodeFormat::KeyArray),
+    cas::NodeReader::SubtreeStatsFlag()};
+  for (int width : {1, 2, 4}) {
+    uint32_t flag = cas::NodeReader::PointerWidthFlag(width);
+    REQUIRE(flag != 0);
+    REQUIRE((flag & 0xFF) == 0); // 256 children still fit
+    for (uint32_t other : flags) {
+      REQUIRE(flag != other);
+      REQUIRE((flag & other) == 0);
+    }
+  }
+  REQUIRE((cas::NodeReader::PointerWidthFlag(1) | cas::NodeReader::PointerWidthFlag(2))
+      == cas::NodeReader::PointerWidthFlag(4));
+
+  SECTION("Encoding") {
+    std::vector<uint8_t> buffer(4);
+    size_t node_pos = 1000;
+    for (int width : {1, 2, 4}) {
+      size_t max_delta = (size_t{1} << (8 * width)) - 1;
+      for (size_t delta : {size_t{0}, size_t{1}, max_delta / 2, max_delta}) {
+        uint8_t* end = cas::util::WriteRelativePointer(buffer.data(),
+            node_pos, node_pos + delta, width);
+        REQUIRE(end == buffer.data() + width);
+        REQUIRE(cas::util::ReadRelativePointer(buffer.data(), node_pos, width)
+            == node_pos + delta);
+      }
+      REQUIRE_THROWS_AS(cas::util::WriteRelativePointer(buffer.data(),
+            node_pos, node_pos + max_delta + 1, width), std::runtime_error);
+      // children are placed after their parent
+      REQUIRE_THROWS_AS(cas::util::WriteRelativePointer(buffer.data(),
+            node_pos, node_pos - 1, width), std::runtime_error);
+    }
+  }
+
+  SECTION("Index") {
+    auto dir = test::Directory("relative_pointers");
+    auto inputs = WideInputs();
+    // a node whose children are single keys needs only 1-byte pointers
+    for (auto path : {"/ya", "/yb", "/yc"}) {
+      inputs.push_back({path, 0, inputs.size()});
+    }
+    cas::Context context;
+    context.mem_size_bytes_ = 1024 * cas::PAGE_SZ;
+    // small partitions yield inner nodes of all pointer widths
+    context.partitioning_threshold_ = 2;
+    for (auto format : {cas::NodeFormat::Interleaved, cas::NodeFormat::KeyArray}) {
+      context.node_format_ = format;
+      std::string name = format == cas::NodeFormat::KeyArray ? "key_array" : "interleaved";
+      context.relative_pointers_ = false;
+      auto absolute = test::BuildIndex(context, dir, name + "_absolute", inputs);
+      context.relative_pointers_ = true;
+      auto relative = test::BuildIndex(context, dir, name + "_relative", inputs);
+
+      auto absolute_data = test::ReadFile(absolute);
+      auto relative_data = test::ReadFile(relative);
+      REQUIRE(relative_data.size() < absolute_data.size());
+      std::map<size_t, size_t> widths;
+      CompareRelative(absolute_data, 0, relative_data, 0, widths);
+      REQUIRE(widths[1] > 0);
+      REQUIRE(widths[2] > 0);
+      REQUIRE(widths[4] > 0);
+
+      for (const auto& key : {
+          test::SearchKey("/**", cas::VINT64_MIN, cas::VINT64_MAX),
+          test::SearchKey("/xa/*", cas::VINT64_MIN, cas::VINT64_MAX),
+          test::SearchKey("/x*/f3", 1, 2)}) {
+        auto matches = test::Query(absolute, key);
+        REQUIRE(!matches.empty());
+        REQUIRE(test::Query(relative, key) == matches);
+      }
+    }
+    std::filesystem::remove_all(dir);
+  }
+}
+
+
+TEST_CASE("Round trip of varint node headers", "[cas::NodeReader]") {
+  std::vector<test::StringInput> inputs;
+
+  SECTION("Short prefixes") {
+    for (size_t i = 0; i < 3000; ++i) {
+      inputs.push_back({"/drivers/net/file" + std::to_string(i / 3) + ".c",
+          std::to_string(1'600'000 + i / 2), i});
+    }
+    auto contents = RoundTrip(inputs, true);
+    REQUIRE(contents.shapes_.size() > 1);
+  }
+
+  SECTION("Path prefix longer than 4095 bytes") {
+    std::string dir = "/" + std::string(5000, 'd') + "/";
+    for (size_t i = 0; i < 3000; ++i) {
+      inputs.push_back({dir + "file" + std::to_string(i), "v" + std::to_string(i % 10), i});
+      inputs.push_back({"/a/file" + std::to_string(i), "v" + std::to_string(i % 10), i});
+    }
+    auto contents = RoundTrip(inputs, false);
+    REQUIRE(contents.max_len_path_ > 4095);
+  }
+
+  SECTION("Value prefix longer than 15 bytes") {
+    std::string prefix(20, 'v');
+    for (size_t i = 0; i < 3000; ++i) {
+      inputs.push_back({"/a/file" + std::to_string(i % 100),
+          prefix + std::to_string(i), i});
+    }
+    auto contents = RoundTrip(inputs, false);
+    REQUIRE(contents.max_len_value_ > 15);
+  }
+
+  SECTION("Leaf with more than 16383 suffixes") {
+    for (size_t i = 0; i < 20'000; ++i) {
+      inputs.push_back({"/hot/key", "1", i});
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+      inputs.push_back({"/a/file" + std::to_string(i), "2", i});
+    }
+    auto contents = RoundTrip(inputs, false);
+    REQUIRE(contents.max_nr_suffixes_ == 20'000);
+  }
+
+  SECTION("Leaf larger than the initial serialization buffer") {
+    // a suffix takes 22 bytes, i.e., the leaf takes more than 10MB
+    for (size_t i = 0; i < 600'000; ++i) {
+      inputs.push_back({"/hot/key", "1", i});
+    }
+    auto contents = Load(inputs, true);
+    REQUIRE(contents.max_nr_suffixes_ == 600'000);
+    REQUIRE(contents.entries_.size() == inputs.size());
+  }
+}
@@ -24,8 +24,13 @@ TEST_CASE("Matching a complete path", "[cas::PathMatcher]") {
       // encode query pattern
       cas::BinarySK bskey = cas::KeyEncoder<cas::vint64_t>::Encode(skey);
 
-      return cas::path_matcher::MatchPath(input_buffer2, bskey.path_,
-                                          bikey.LenPath());
+      // the compiled automaton must agree with the backtracking matcher
+      bool result = cas::path_matcher::MatchPath(input_buffer2, bskey.path_,
+                                                 bikey.LenPath());
+      REQUIRE(bskey.automaton_ != nullptr);
+      REQUIRE(cas::path_matcher::MatchPath(input_buffer2, bskey,
+                                           bikey.LenPath()) == result);
+      return result;
    };
 
    auto match = [&](std::string input_path, std::string pattern) -> bool {
@@ -53,8 +58,12 @@ TEST_CASE("Matching a complete path", "[cas::PathMatcher]") {
       // encode query pattern
       cas::BinarySK bskey = cas::KeyEncoder<cas::vint64_t>::Encode(skey);
       cas::path_matcher::State s;
-      return cas::path_matcher::MatchPathIncremental(input_buffer2, bskey.path_,
-                                                     bikey.LenPath()-1,s);
+      auto result = cas::path_matcher::MatchPathIncremental(input_buffer2, bskey.path_,
+                                                            bikey.LenPath()-1,s);
+      cas::path_matcher::State t;
+      REQUIRE(cas::path_matcher::MatchPathIncremental(input_buffer2, bskey,
+                                                      bikey.LenPath()-1, t) == result);
+      return result;
    };
 
    SECTION("Filename Cases"){
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "cas/bulk_loader.hpp"
+#include "cas/bulk_loader_stats.hpp"
+#include "cas/context.hpp"
+#include "cas/key_encoder.hpp"
+#include "cas/memory_page.hpp"
+#include "cas/partition_header.hpp"
+#include "cas/query_executor.hpp"
+#include "cas/search_key.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+// helpers that bulk-load small indexes from keys with integer (or
+// string) values
+namespace test {
+
+struct Input {
+  std::string path_;
+  cas::vint64_t value_;
+  size_t ref_;
+};
+
+// a key with a string value, e.g., to exceed the length limits of
+// the node header
+struct StringInput {
+  std::string path_;
+  std::string value_;
+  size_t ref_;
+};
+
+// path, value, and ref bytes of a key
+using Entry = std::tuple<std::string, std::string, std::string>;
+
+
+inline std::string RefBytes(size_t ref) {
+  std::string bytes(sizeof(cas::ref_t), '\0');
+  std::memcpy(&bytes[0], &ref, sizeof(size_t));
+  return bytes;
+}
+
+
+inline void EncodeKey(const Input& input, cas::BinaryKey& bkey) {
+  cas::Key<cas::vint64_t> key;
+  key.path_ = input.path_;
+  key.value_ = input.value_;
+  std::memcpy(&key.ref_, RefBytes(input.ref_).data(), sizeof(cas::ref_t));
+  cas::KeyEncoder<cas::vint64_t>::Encode(key, bkey);
+}
+
+
+inline void EncodeKey(const StringInput& input, cas::BinaryKey& bkey) {
+  cas::Key<cas::vstring_t> key;
+  key.path_ = input.path_;
+  key.value_ = input.value_;
+  std::memcpy(&key.ref_, RefBytes(input.ref_).data(), sizeof(cas::ref_t));
+  cas::KeyEncoder<cas::vstring_t>::Encode(key, bkey);
+}
+
+
+// the key as stored in the index
+template<class In>
+inline Entry Encode(const In& input) {
+  cas::QueryBuffer buffer;
+  cas::BinaryKey bkey{&buffer.at(0)};
+  EncodeKey(input, bkey);
+  return {
+    std::string(reinterpret_cast<const char*>(bkey.Path()), bkey.LenPath()),
+    std::string(reinterpret_cast<const char*>(bkey.Value()), bkey.LenValue()),
+    RefBytes(input.ref_)
+  };
+}
+
+
+template<class In>
+inline std::vector<Entry> Encode(const std::vector<In>& inputs) {
+  std::vector<Entry> entries;
+  for (const auto& input : inputs) {
+    entries.push_back(Encode(input));
+  }
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+
+// an empty directory for the files of a test
+inline std::string Directory(const std::string& name) {
+  auto dir = std::filesystem::temp_directory_path() / ("cas_test_" + name);
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir.string() + "/";
+}
+
+
+// writes the keys as a root partition file with pages of page_size
+// bytes (see csv2partition)
+template<class In>
+inline void WritePartition(const std::string& filename,
+    const std::vector<In>& inputs, size_t page_size = cas::PAGE_SZ) {
+  std::vector<std::byte> page_buffer(page_size);
+  cas::MemoryPage page{page_buffer.data(), page_size};
+  std::ofstream file{filename, std::ios::binary};
+  cas::PartitionHeader header;
+  header.page_size_ = page_size;
+  header.present_ = true;
+  header.Write(page.Data());
+  file.write(reinterpret_cast<const char*>(page.Data()), page_size);
+  page.Reset();
+  cas::QueryBuffer buffer;
+  for (const auto& input : inputs) {
+    cas::BinaryKey bkey{&buffer.at(0)};
+    EncodeKey(input, bkey);
+    if (!page.Fits(bkey)) {
+      file.write(reinterpret_cast<const char*>(page.Data()), page_size);
+      page.Reset();
+    }
+    page.Push(bkey);
+  }
+  file.write(reinterpret_cast<const char*>(page.Data()), page_size);
+}
+
+
+// bulk-loads the keys into the file name in dir, the other files of
+// context are placed into dir as well
+template<class In>
+inline std::string BuildIndex(cas::Context context, const std::string& dir,
+    const std::string& name, const std::vector<In>& inputs) {
+  context.input_filename_ = dir + name + ".partition";
+  context.partition_folder_ = dir + name + "_partitions/";
+  context.index_file_ = dir + name;
+  WritePartition(context.input_filename_, inputs, context.page_size_);
+  cas::BulkLoaderStats stats;
+  cas::BulkLoader<cas::vint64_t> bulk_loader{context, stats};
+  bulk_loader.Load();
+  return context.index_file_;
+}
+
+
+inline std::vector<uint8_t> ReadFile(const std::string& filename) {
+  std::ifstream file{filename, std::ios::binary};
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+
+inline cas::BinarySK SearchKey(const std::string& path,
+    cas::vint64_t low, cas::vint64_t high) {
+  cas::SearchKey<cas::vint64_t> key{path, low, high};
+  return cas::KeyEncoder<cas::vint64_t>::Encode(key, false);
+}
+
+
+// the matches of the query, sorted
+inline std::vector<Entry> Query(const std::string& index_file,
+    const cas::BinarySK& key) {
+  std::vector<Entry> entries;
+  cas::QueryExecutor query{index_file};
+  query.Execute(key, [&](
+        const cas::QueryBuffer& path, size_t p_len,
+        const cas::QueryBuffer& value, size_t v_len,
+        cas::ref_t ref) {
+    entries.emplace_back(
+        std::string(reinterpret_cast<const char*>(path.data()), p_len),
+        std::string(reinterpret_cast<const char*>(value.data()), v_len),
+        std::string(reinterpret_cast<const char*>(&ref), sizeof(cas::ref_t)));
+  });
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+} // namespace test